@@ -0,0 +1,268 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalhos Práticos 1 e 2                   |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: CostMap.cpp
+// ========
+// Source file for per-pixel render cost map.
+//
+// Author: Trabalhos Práticos 1 e 2
+// Last revision: 18/10/2025
+
+#include "CostMap.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+namespace cg
+{ // begin namespace cg
+
+namespace
+{ // begin namespace
+
+const char* const channelNames[]
+{
+  "samples",
+  "rays",
+  "nodes",
+  "primitives",
+  "time"
+};
+
+static_assert(std::size(channelNames) == CostMap::channelCount);
+
+// False color ramp, from no cost (dark) to the highest cost (light)
+const uint8_t ramp[][3]
+{
+  {0, 0, 4},
+  {87, 16, 110},
+  {188, 55, 84},
+  {249, 142, 9},
+  {252, 255, 164}
+};
+
+constexpr auto rampSize = (int)std::size(ramp);
+
+uint32_t
+crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+  static const auto table = []()
+  {
+    std::vector<uint32_t> t(256);
+
+    for (uint32_t n = 0; n < 256; ++n)
+    {
+      auto c = n;
+
+      for (int k = 0; k < 8; ++k)
+        c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      t[n] = c;
+    }
+    return t;
+  }();
+
+  crc = ~crc;
+  for (size_t i = 0; i < size; ++i)
+    crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+  return ~crc;
+}
+
+inline void
+putBE(std::vector<uint8_t>& out, uint32_t v)
+{
+  out.push_back(uint8_t(v >> 24));
+  out.push_back(uint8_t(v >> 16));
+  out.push_back(uint8_t(v >> 8));
+  out.push_back(uint8_t(v));
+}
+
+void
+writeChunk(FILE* f, const char* type, const std::vector<uint8_t>& data)
+{
+  std::vector<uint8_t> chunk;
+
+  putBE(chunk, (uint32_t)data.size());
+  chunk.insert(chunk.end(), type, type + 4);
+  chunk.insert(chunk.end(), data.begin(), data.end());
+  putBE(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+  fwrite(chunk.data(), 1, chunk.size(), f);
+}
+
+// Zlib stream with stored (uncompressed) deflate blocks: the maps are
+// small and written rarely, so no compressor is needed
+std::vector<uint8_t>
+zlibStore(const std::vector<uint8_t>& raw)
+{
+  constexpr size_t maxBlock = 65535;
+  std::vector<uint8_t> out{0x78, 0x01};
+  uint32_t a = 1, b = 0;
+
+  for (size_t i = 0;; i += maxBlock)
+  {
+    auto n = std::min(maxBlock, raw.size() - i);
+    auto last = i + n == raw.size();
+
+    out.push_back(last ? 1 : 0);
+    out.push_back(uint8_t(n));
+    out.push_back(uint8_t(n >> 8));
+    out.push_back(uint8_t(~n));
+    out.push_back(uint8_t(~n >> 8));
+    out.insert(out.end(), raw.begin() + i, raw.begin() + i + n);
+    if (last)
+      break;
+  }
+  for (auto c : raw)
+  {
+    a = (a + c) % 65521;
+    b = (b + a) % 65521;
+  }
+  putBE(out, (b << 16) | a);
+  return out;
+}
+
+} // end namespace
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// CostMap implementation
+// =======
+const char*
+CostMap::channelName(Channel channel)
+{
+  return channelNames[channel];
+}
+
+void
+CostMap::resize(int width, int height)
+{
+  _width = std::max(width, 0);
+  _height = std::max(height, 0);
+  for (auto& data : _data)
+    data.assign((size_t)_width * _height, 0.0f);
+}
+
+double
+CostMap::total(Channel channel) const
+{
+  auto t = 0.0;
+
+  for (auto v : _data[channel])
+    t += v;
+  return t;
+}
+
+bool
+CostMap::writePFM(Channel channel, const char* filename) const
+//[]---------------------------------------------------[]
+//|  Write the channel as a grayscale float image       |
+//|  @param channel: channel to be written              |
+//|  @param filename: name of the PFM file              |
+//|  @return true if the file was written               |
+//[]---------------------------------------------------[]
+{
+  auto f = fopen(filename, "wb");
+
+  if (f == nullptr)
+    return false;
+
+  // PFM rows go from the bottom to the top of the image, as in the map.
+  // A negative scale means little-endian floats
+  uint16_t one = 1;
+  auto littleEndian = *(const uint8_t*)&one == 1;
+  const auto& data = _data[channel];
+
+  fprintf(f, "Pf\n%d %d\n%s\n", _width, _height, littleEndian ? "-1.0" : "1.0");
+
+  auto ok = fwrite(data.data(), sizeof(float), data.size(), f) == data.size();
+
+  return fclose(f) == 0 && ok;
+}
+
+bool
+CostMap::writePNG(Channel channel, const char* filename) const
+//[]---------------------------------------------------[]
+//|  Write the channel as a false color image           |
+//|  @param channel: channel to be written              |
+//|  @param filename: name of the PNG file              |
+//|  @return true if the file was written               |
+//[]---------------------------------------------------[]
+{
+  if (empty())
+    return false;
+
+  // A few very expensive pixels would leave the rest of the image dark
+  const auto& data = _data[channel];
+  std::vector<float> sorted{data};
+  auto k = (sorted.size() - 1) * 99 / 100;
+
+  std::nth_element(sorted.begin(), sorted.begin() + k, sorted.end());
+
+  auto scale = sorted[k] > 0 ? (rampSize - 1) / sorted[k] : 0.0f;
+  std::vector<uint8_t> raw;
+
+  raw.reserve((size_t)_height * (3 * _width + 1));
+  for (auto y = _height - 1; y >= 0; --y)
+  {
+    raw.push_back(0); // no filter
+    for (auto x = 0; x < _width; ++x)
+    {
+      auto t = std::clamp(data[(size_t)y * _width + x] * scale,
+        0.0f,
+        rampSize - 1.0f);
+      auto i = std::min((int)t, rampSize - 2);
+      auto s = t - i;
+
+      for (int c = 0; c < 3; ++c)
+        raw.push_back(uint8_t(ramp[i][c] + (ramp[i + 1][c] - ramp[i][c]) * s + 0.5f));
+    }
+  }
+
+  auto f = fopen(filename, "wb");
+
+  if (f == nullptr)
+    return false;
+
+  const uint8_t signature[]{0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  std::vector<uint8_t> header;
+
+  fwrite(signature, 1, sizeof signature, f);
+  putBE(header, (uint32_t)_width);
+  putBE(header, (uint32_t)_height);
+  header.insert(header.end(), {8, 2, 0, 0, 0}); // 8-bit RGB
+  writeChunk(f, "IHDR", header);
+  writeChunk(f, "IDAT", zlibStore(raw));
+  writeChunk(f, "IEND", {});
+
+  auto ok = !ferror(f);
+
+  return fclose(f) == 0 && ok;
+}
+
+bool
+CostMap::write(const char* base) const
+{
+  auto ok = true;
+
+  for (int c = 0; c < channelCount; ++c)
+  {
+    auto channel = (Channel)c;
+
+    if (total(channel) == 0)
+      continue;
+
+    char filename[512];
+
+    snprintf(filename, sizeof filename, "%s_%s.pfm", base, channelNames[c]);
+    ok &= writePFM(channel, filename);
+    snprintf(filename, sizeof filename, "%s_%s.png", base, channelNames[c]);
+    ok &= writePNG(channel, filename);
+  }
+  return ok;
+}
+
+} // end namespace cg
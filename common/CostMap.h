@@ -0,0 +1,124 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalhos Práticos 1 e 2                   |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: CostMap.h
+// ========
+// Class definition for per-pixel render cost map.
+//
+// Author: Trabalhos Práticos 1 e 2
+// Last revision: 18/10/2025
+
+#ifndef __CostMap_h
+#define __CostMap_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{ // begin namespace cg
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// CostMap: per-pixel render cost map
+// =======
+//
+// Keeps, for every pixel, the number of samples (pixel rays), the
+// number of rays traced (including shadow and secondary rays), the
+// number of BVH nodes visited, the number of primitives tested and
+// the time spent, in ns. Row 0 is the bottom of the image, as in
+// ImageBuffer. Distinct threads may add to distinct pixels at the
+// same time.
+//
+// Each channel can be written as a float image (PFM) or as a false
+// color PNG, normalized by the 99th percentile of the channel.
+class CostMap
+{
+public:
+  enum Channel
+  {
+    Samples,
+    Rays,
+    Nodes,
+    Primitives,
+    Time,
+    channelCount
+
+  };
+
+  // Costs of a pixel, counted by the thread that renders it
+  struct Counters
+  {
+    uint32_t samples{};
+    uint32_t rays{};
+    uint32_t nodes{};
+    uint32_t primitives{};
+
+  };
+
+  static const char* channelName(Channel);
+
+  // Resizes the map and zeroes all the channels.
+  void resize(int width, int height);
+
+  int
+  width() const
+  {
+    return _width;
+  }
+
+  int
+  height() const
+  {
+    return _height;
+  }
+
+  bool
+  empty() const
+  {
+    return _width == 0 || _height == 0;
+  }
+
+  void
+  add(int x, int y, const Counters& c, float time)
+  {
+    auto i = (size_t)y * _width + x;
+
+    _data[Samples][i] += (float)c.samples;
+    _data[Rays][i] += (float)c.rays;
+    _data[Nodes][i] += (float)c.nodes;
+    _data[Primitives][i] += (float)c.primitives;
+    _data[Time][i] += time;
+  }
+
+  float
+  operator ()(Channel channel, int x, int y) const
+  {
+    return _data[channel][(size_t)y * _width + x];
+  }
+
+  // Sum of the channel over all pixels.
+  double total(Channel) const;
+
+  bool writePFM(Channel, const char* filename) const;
+  bool writePNG(Channel, const char* filename) const;
+
+  // Writes <base>_<channel>.pfm and <base>_<channel>.png for every
+  // channel with some cost recorded. Returns false on I/O errors.
+  bool write(const char* base) const;
+
+private:
+  int _width{};
+  int _height{};
+  std::vector<float> _data[channelCount];
+
+}; // CostMap
+
+} // end namespace cg
+
+#endif // __CostMap_h
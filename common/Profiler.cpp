@@ -0,0 +1,292 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalhos Práticos 1 e 2                   |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: Profiler.cpp
+// ========
+// Source file for per-stage render profiler.
+//
+// Author: Trabalhos Práticos 1 e 2
+// Last revision: 18/10/2025
+
+#include "Profiler.h"
+#include <algorithm>
+#include <iterator>
+
+namespace cg
+{ // begin namespace cg
+
+namespace
+{ // begin namespace
+
+const char* const stageNames[]
+{
+  "BVH build",
+  "Render",
+  "Ray generation",
+  "Primary traversal",
+  "Shadow traversal",
+  "Secondary traversal",
+  "Shading",
+  "Image upload"
+};
+
+const char* const stageKeys[]
+{
+  "bvhBuild",
+  "render",
+  "rayGeneration",
+  "primaryTraversal",
+  "shadowTraversal",
+  "secondaryTraversal",
+  "shading",
+  "imageUpload"
+};
+
+static_assert(std::size(stageNames) == Profiler::stageCount);
+static_assert(std::size(stageKeys) == Profiler::stageCount);
+
+inline double
+elapsedTime(std::chrono::steady_clock::duration d)
+{
+  return std::chrono::duration<double, std::milli>(d).count();
+}
+
+} // end namespace
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Profiler implementation
+// ========
+double
+Profiler::Stats::totalTime() const
+{
+  auto t = 0.0;
+
+  for (auto s : time)
+    t += s;
+  return t;
+}
+
+const char*
+Profiler::stageName(Stage stage)
+{
+  return stageNames[stage];
+}
+
+uint64_t
+Profiler::nextEpoch()
+{
+  static std::atomic<uint64_t> epoch{0};
+  return ++epoch;
+}
+
+Profiler::Profiler()
+{
+#ifdef CG_PROFILE
+  _overhead = calibrate();
+  _tickOrigin = ticks();
+#endif
+}
+
+#ifdef CG_PROFILE
+
+uint64_t
+Profiler::calibrate()
+//[]---------------------------------------------------[]
+//|  Ticks charged to each interval of a sampled pixel  |
+//|  by the profiler itself                             |
+//|  @return the least average over a few runs          |
+//[]---------------------------------------------------[]
+{
+  constexpr int n = 256;
+  auto overhead = UINT64_MAX;
+
+  for (int run = 0; run < 8; ++run)
+  {
+    Counters counters;
+    ThreadState state;
+
+    // Empty scopes: the two intervals of each are all overhead
+    state.counters = &counters;
+    state.stage = Render;
+    state.sampling = true;
+    state.start = ticks();
+    for (int i = 0; i < n; ++i)
+      state.leave(state.enter(Shading));
+    overhead = std::min(overhead,
+      (counters.sampledTicks[Render] + counters.sampledTicks[Shading]) / (2 * n));
+  }
+  return overhead;
+}
+
+void
+Profiler::attach(ThreadState& state)
+{
+  std::lock_guard guard{_lock};
+
+  _counters.push_back(std::make_unique<Counters>());
+  state.epoch = _epoch.load(std::memory_order_relaxed);
+  state.counters = _counters.back().get();
+  state.overhead = _overhead;
+  state.stage = -1;
+  state.sampling = false;
+}
+
+#endif
+
+void
+Profiler::beginFrame()
+{
+#ifdef CG_PROFILE
+  _frameStart = Clock::now();
+#endif
+}
+
+void
+Profiler::endFrame()
+{
+#ifdef CG_PROFILE
+  auto now = Clock::now();
+  auto tickNow = ticks();
+  // Ticks per ms, calibrated against the steady clock over the whole
+  // lifetime of the profiler
+  auto rate = (tickNow - _tickOrigin) / elapsedTime(now - _clockOrigin);
+  std::lock_guard guard{_lock};
+  Stats stats;
+
+  stats.frame = _last.frame + 1;
+  stats.wallTime = elapsedTime(now - _frameStart);
+  stats.threadCount = (int)_counters.size();
+  for (const auto& c : _counters)
+  {
+    // The sampled pixels stand for all the pixels of the thread; the
+    // others were timed as part of the stage enclosing them
+    auto k = c->sampledPixels > 0 ? (double)c->pixels / c->sampledPixels : 0.0;
+
+    for (int s = 0; s < stageCount; ++s)
+    {
+      stats.time[s] += std::max(0.0,
+        c->ticks[s] + k * c->sampledTicks[s] - (k - 1) * c->pixelTicks[s]);
+      stats.calls[s] += c->calls[s];
+    }
+    stats.pixels += c->pixels;
+    stats.sampledPixels += c->sampledPixels;
+  }
+  if (rate > 0)
+    for (auto& t : stats.time)
+      t /= rate;
+  _last = stats;
+  _counters.clear();
+  _epoch.store(nextEpoch(), std::memory_order_release);
+#endif
+}
+
+void
+Profiler::discard()
+{
+#ifdef CG_PROFILE
+  std::lock_guard guard{_lock};
+
+  _counters.clear();
+  _epoch.store(nextEpoch(), std::memory_order_release);
+#endif
+}
+
+std::string
+Profiler::toJSON() const
+//[]---------------------------------------------------[]
+//|  Statistics of the last frame as JSON               |
+//|  @return the JSON text                              |
+//[]---------------------------------------------------[]
+{
+  const auto& s = _last;
+  auto total = s.totalTime();
+  std::string json;
+  char buffer[256];
+
+  snprintf(buffer,
+    sizeof buffer,
+    "{\n  \"frame\": %llu,\n  \"wallTimeMs\": %.4f,\n"
+    "  \"threads\": %d,\n  \"totalTimeMs\": %.4f,\n"
+    "  \"pixels\": %llu,\n  \"sampledPixels\": %llu,\n  \"stages\": [\n",
+    (unsigned long long)s.frame,
+    s.wallTime,
+    s.threadCount,
+    total,
+    (unsigned long long)s.pixels,
+    (unsigned long long)s.sampledPixels);
+  json = buffer;
+  for (int i = 0; i < stageCount; ++i)
+  {
+    snprintf(buffer,
+      sizeof buffer,
+      "    {\"name\": \"%s\", \"timeMs\": %.4f, \"calls\": %llu, "
+      "\"percent\": %.2f}%s\n",
+      stageKeys[i],
+      s.time[i],
+      (unsigned long long)s.calls[i],
+      total > 0 ? s.time[i] * 100 / total : 0.0,
+      i + 1 < stageCount ? "," : "");
+    json += buffer;
+  }
+  json += "  ]\n}\n";
+  return json;
+}
+
+bool
+Profiler::writeJSON(const char* filename) const
+{
+  auto f = fopen(filename, "w");
+
+  if (f == nullptr)
+    return false;
+
+  auto json = toJSON();
+  auto ok = fwrite(json.data(), 1, json.size(), f) == json.size();
+
+  return fclose(f) == 0 && ok;
+}
+
+void
+Profiler::printSummary(FILE* f) const
+//[]---------------------------------------------------[]
+//|  Print the statistics of the last frame as a table  |
+//|  @param output file                                 |
+//[]---------------------------------------------------[]
+{
+  if (!enabled)
+  {
+    fprintf(f, "Profiler disabled (build with CG_PROFILE)\n");
+    return;
+  }
+
+  const auto& s = _last;
+  auto total = s.totalTime();
+
+  fprintf(f, "%-20s %12s %12s %7s\n", "Stage", "Time (ms)", "Calls", "%");
+  for (int i = 0; i < stageCount; ++i)
+    fprintf(f,
+      "%-20s %12.3f %12llu %7.1f\n",
+      stageNames[i],
+      s.time[i],
+      (unsigned long long)s.calls[i],
+      total > 0 ? s.time[i] * 100 / total : 0.0);
+  fprintf(f, "%-20s %12.3f %12s %7.1f\n", "Total", total, "", 100.0);
+  fprintf(f,
+    "Frame %llu: %.3f ms wall time, %d thread(s)\n",
+    (unsigned long long)s.frame,
+    s.wallTime,
+    s.threadCount);
+  if (s.pixels > 0)
+    fprintf(f,
+      "Per-ray stages timed on %llu of %llu pixels\n",
+      (unsigned long long)s.sampledPixels,
+      (unsigned long long)s.pixels);
+}
+
+} // end namespace cg
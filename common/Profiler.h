@@ -0,0 +1,392 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalhos Práticos 1 e 2                   |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: Profiler.h
+// ========
+// Class definition for per-stage render profiler.
+//
+// Author: Trabalhos Práticos 1 e 2
+// Last revision: 18/10/2025
+
+#ifndef __Profiler_h
+#define __Profiler_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef CG_PROFILE
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CG_PROFILE_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CG_PROFILE_RDTSC
+#endif
+#endif
+
+namespace cg
+{ // begin namespace cg
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Profiler: per-stage render profiler
+// ========
+//
+// Render stages are delimited by scopes (see CG_PROFILE_SCOPE). Each
+// thread accumulates, in its own counters, the time stamp counter
+// ticks spent in every stage, excluding the nested scopes, and the
+// number of times the stage was entered. endFrame() sums up the
+// counters of all threads and converts ticks to milliseconds.
+//
+// Reading the clock costs as much as a few ray/box tests, so regular
+// scopes are opened per row, tile or build. The per-ray stages (ray
+// generation, traversals and shading) use sampled scopes instead (see
+// CG_PROFILE_SAMPLED_SCOPE): they are counted on every ray, but timed
+// only inside one of every sampleRate pixels (see CG_PROFILE_PIXEL).
+// endFrame() scales the ticks of the sampled pixels by the number of
+// pixels and takes the same estimate out of the enclosing stage (e.g.,
+// Render), which keeps the total time of the frame.
+//
+// Without CG_PROFILE defined, the scopes expand to nothing and the
+// frame functions do nothing: the renderers pay nothing for them.
+// A thread should report to one profiler at a time.
+class Profiler
+{
+public:
+  enum Stage
+  {
+    BVHBuild,
+    Render, // rows or tiles of pixels
+    RayGeneration,
+    PrimaryTraversal,
+    ShadowTraversal,
+    SecondaryTraversal, // reflection and refraction rays
+    Shading,
+    ImageUpload,
+    stageCount
+
+  };
+
+  struct Stats
+  {
+    uint64_t frame{}; // number of frames ended so far
+    double wallTime{}; // from beginFrame() to endFrame(), in ms
+    double time[stageCount]{}; // summed over threads, in ms
+    uint64_t calls[stageCount]{};
+    uint64_t pixels{};
+    uint64_t sampledPixels{};
+    int threadCount{};
+
+    double totalTime() const;
+
+  };
+
+#ifdef CG_PROFILE
+  static constexpr bool enabled = true;
+#else
+  static constexpr bool enabled = false;
+#endif
+
+  // One of every sampleRate pixels is timed; a prime, so that the
+  // sampled pixels don't line up in columns of the image.
+  static constexpr uint32_t sampleRate = 61;
+
+  static const char* stageName(Stage);
+
+  Profiler();
+
+  // Starts the wall clock of a frame. The work done between frames
+  // (e.g., a BVH rebuilt after a scene edit) goes to the next frame.
+  void beginFrame();
+
+  // Aggregates the counters of all threads into lastFrame(). The
+  // threads must not be inside a scope when the frame ends.
+  void endFrame();
+
+  // Drops the work done since the last endFrame() (canceled frames).
+  void discard();
+
+  const Stats& lastFrame() const
+  {
+    return _last;
+  }
+
+  std::string toJSON() const;
+  bool writeJSON(const char* filename) const;
+  void printSummary(FILE* f = stdout) const;
+
+#ifdef CG_PROFILE
+  class Scope;
+  class SampledScope;
+  class Pixel;
+#endif
+
+private:
+  struct alignas(64) Counters
+  {
+    uint64_t ticks[stageCount]{};
+    uint64_t sampledTicks[stageCount]{}; // inside the sampled pixels
+    uint64_t pixelTicks[stageCount]{}; // sampled pixels, by enclosing stage
+    uint64_t calls[stageCount]{};
+    uint64_t pixels{};
+    uint64_t sampledPixels{};
+
+  };
+
+#ifdef CG_PROFILE
+  struct ThreadState
+  {
+    uint64_t epoch{};
+    Counters* counters{};
+    int stage{-1}; // stage of the innermost open scope
+    uint64_t start{};
+    uint64_t overhead{}; // ticks the profiler adds to an interval
+    uint64_t pixelTime{}; // ticks of the sampled pixel so far
+    uint32_t countdown{1}; // pixels up to the next sampled one
+    bool sampling{};
+
+    // Charges the ticks up to now to the current stage.
+    void charge(uint64_t now)
+    {
+      auto t = now - start;
+
+      if (!sampling)
+      {
+        counters->ticks[stage] += t;
+        return;
+      }
+      // The ticks of the profiler itself would be scaled with the pixel
+      t = t > overhead ? t - overhead : 0;
+      counters->sampledTicks[stage] += t;
+      pixelTime += t;
+    }
+
+    int enter(int s)
+    {
+      auto now = ticks();
+      auto parent = stage;
+
+      if (parent >= 0)
+        charge(now);
+      ++counters->calls[s];
+      stage = s;
+      start = now;
+      return parent;
+    }
+
+    void leave(int parent)
+    {
+      auto now = ticks();
+
+      charge(now);
+      stage = parent;
+      start = now;
+    }
+
+    bool beginPixel()
+    {
+      ++counters->pixels;
+      if (sampling || --countdown > 0)
+        return false;
+
+      auto now = ticks();
+
+      if (stage >= 0)
+        charge(now);
+      ++counters->sampledPixels;
+      countdown = sampleRate;
+      sampling = true;
+      pixelTime = 0;
+      start = now;
+      return true;
+    }
+
+    void endPixel()
+    {
+      auto now = ticks();
+
+      if (stage >= 0)
+      {
+        charge(now);
+        counters->pixelTicks[stage] += pixelTime;
+      }
+      sampling = false;
+      start = now;
+    }
+
+  };
+
+  static uint64_t
+  ticks()
+  {
+#ifdef CG_PROFILE_RDTSC
+    return __rdtsc();
+#else
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<nanoseconds>(
+      steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  ThreadState&
+  threadState()
+  {
+    thread_local ThreadState state;
+
+    if (state.epoch != _epoch.load(std::memory_order_acquire))
+      attach(state);
+    return state;
+  }
+
+  void attach(ThreadState&);
+
+  static uint64_t calibrate();
+#endif
+
+  using Clock = std::chrono::steady_clock;
+
+  std::mutex _lock;
+  std::vector<std::unique_ptr<Counters>> _counters; // one per thread
+  std::atomic<uint64_t> _epoch{nextEpoch()};
+  Clock::time_point _frameStart{Clock::now()};
+  Clock::time_point _clockOrigin{Clock::now()};
+  uint64_t _tickOrigin{};
+  uint64_t _overhead{}; // ticks the profiler adds to an interval
+  Stats _last;
+
+  static uint64_t nextEpoch();
+
+}; // Profiler
+
+#ifdef CG_PROFILE
+
+/////////////////////////////////////////////////////////////////////
+//
+// Profiler::Scope: stage of a render, up to the end of the block
+// ===============
+class Profiler::Scope
+{
+public:
+  Scope(Profiler& profiler, Stage stage):
+    _state{&profiler.threadState()},
+    _parent{_state->enter(stage)}
+  {
+    // do nothing
+  }
+
+  ~Scope()
+  {
+    _state->leave(_parent);
+  }
+
+  Scope(const Scope&) = delete;
+  Scope& operator =(const Scope&) = delete;
+
+private:
+  ThreadState* _state;
+  int _parent;
+
+}; // Profiler::Scope
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Profiler::SampledScope: per-ray stage, up to the end of the block
+// =====================
+//
+// Counts the stage; it is timed only inside a sampled pixel.
+class Profiler::SampledScope
+{
+public:
+  SampledScope(Profiler& profiler, Stage stage):
+    _state{&profiler.threadState()}
+  {
+    if (_state->sampling)
+      _parent = _state->enter(stage);
+    else
+      ++_state->counters->calls[stage];
+  }
+
+  ~SampledScope()
+  {
+    if (_parent != none)
+      _state->leave(_parent);
+  }
+
+  SampledScope(const SampledScope&) = delete;
+  SampledScope& operator =(const SampledScope&) = delete;
+
+private:
+  static constexpr int none = -2; // not timed
+  ThreadState* _state;
+  int _parent{none};
+
+}; // Profiler::SampledScope
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Profiler::Pixel: pixel of a render, up to the end of the block
+// ===============
+//
+// Pixels don't nest. The sampled scopes opened in one of every
+// sampleRate pixels of a thread are timed.
+class Profiler::Pixel
+{
+public:
+  Pixel(Profiler& profiler):
+    _state{&profiler.threadState()},
+    _sampled{_state->beginPixel()}
+  {
+    // do nothing
+  }
+
+  ~Pixel()
+  {
+    if (_sampled)
+      _state->endPixel();
+  }
+
+  Pixel(const Pixel&) = delete;
+  Pixel& operator =(const Pixel&) = delete;
+
+private:
+  ThreadState* _state;
+  bool _sampled;
+
+}; // Profiler::Pixel
+
+#endif
+
+#ifdef CG_PROFILE
+#define CG_PROFILE_CONCAT_(a, b) a##b
+#define CG_PROFILE_CONCAT(a, b) CG_PROFILE_CONCAT_(a, b)
+#define CG_PROFILE_SCOPE(profiler, stage) \
+  ::cg::Profiler::Scope CG_PROFILE_CONCAT(_profileScope, __LINE__) \
+    {profiler, stage}
+#define CG_PROFILE_SAMPLED_SCOPE(profiler, stage) \
+  ::cg::Profiler::SampledScope CG_PROFILE_CONCAT(_profileScope, __LINE__) \
+    {profiler, stage}
+#define CG_PROFILE_PIXEL(profiler) \
+  ::cg::Profiler::Pixel CG_PROFILE_CONCAT(_profilePixel, __LINE__) \
+    {profiler}
+#else
+#define CG_PROFILE_SCOPE(profiler, stage) ((void)0)
+#define CG_PROFILE_SAMPLED_SCOPE(profiler, stage) ((void)0)
+#define CG_PROFILE_PIXEL(profiler) ((void)0)
+#endif
+
+} // end namespace cg
+
+#endif // __Profiler_h
@@ -0,0 +1,232 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalhos Práticos 1 e 2                   |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: TraceRecorder.cpp
+// ========
+// Source file for timeline event recorder.
+//
+// Author: Trabalhos Práticos 1 e 2
+// Last revision: 18/10/2025
+
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace cg
+{ // begin namespace cg
+
+// Ring of the calling thread, given back to the recorder when the
+// thread finishes
+struct RingOwner
+{
+  TraceRecorder::Ring* ring{};
+
+  ~RingOwner()
+  {
+    if (ring != nullptr)
+      TraceRecorder::instance().releaseRing(ring);
+  }
+
+};
+
+namespace
+{ // begin namespace
+
+thread_local RingOwner ringOwner;
+
+void
+appendEvent(std::string& json,
+  const TraceRecorder::Event& e,
+  uint32_t tid,
+  bool& first)
+{
+  char buffer[512];
+  auto n = snprintf(buffer,
+    sizeof buffer,
+    "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+    "\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+    first ? "" : ",",
+    e.name,
+    e.category,
+    tid,
+    e.begin * 1e-3,
+    std::max<int64_t>(e.end - e.begin, 0) * 1e-3);
+
+  json.append(buffer, n);
+  if (e.argNames[0] != nullptr)
+  {
+    n = snprintf(buffer,
+      sizeof buffer,
+      ",\"args\":{\"%s\":%lld",
+      e.argNames[0],
+      (long long)e.args[0]);
+    json.append(buffer, n);
+    if (e.argNames[1] != nullptr)
+    {
+      n = snprintf(buffer,
+        sizeof buffer,
+        ",\"%s\":%lld",
+        e.argNames[1],
+        (long long)e.args[1]);
+      json.append(buffer, n);
+    }
+    json += '}';
+  }
+  json += '}';
+  first = false;
+}
+
+} // end namespace
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// TraceRecorder implementation
+// =============
+TraceRecorder::TraceRecorder():
+  _origin{std::chrono::steady_clock::now()}
+{
+  // do nothing
+}
+
+TraceRecorder&
+TraceRecorder::instance()
+{
+  static TraceRecorder recorder;
+  return recorder;
+}
+
+void
+TraceRecorder::start()
+{
+  std::lock_guard guard{_lock};
+
+  // The rings are never freed: their owners write into them without
+  // locks, so they are only rewound
+  for (auto& ring : _rings)
+    ring->base.store(ring->head.load(std::memory_order_acquire),
+      std::memory_order_relaxed);
+  _recording.store(true, std::memory_order_relaxed);
+}
+
+void
+TraceRecorder::stop()
+{
+  _recording.store(false, std::memory_order_relaxed);
+}
+
+TraceRecorder::Ring*
+TraceRecorder::acquireRing()
+{
+  std::lock_guard guard{_lock};
+
+  if (!_freeRings.empty())
+  {
+    auto ring = _freeRings.back();
+
+    _freeRings.pop_back();
+    return ring;
+  }
+  _rings.push_back(std::make_unique<Ring>());
+
+  auto ring = _rings.back().get();
+
+  ring->tid = (uint32_t)_rings.size();
+  return ring;
+}
+
+void
+TraceRecorder::releaseRing(Ring* ring)
+{
+  std::lock_guard guard{_lock};
+  _freeRings.push_back(ring);
+}
+
+void
+TraceRecorder::record(const Event& event)
+{
+  auto& ring = ringOwner.ring;
+
+  if (ring == nullptr)
+    ring = acquireRing();
+
+  auto head = ring->head.load(std::memory_order_relaxed);
+
+  ring->events[head % ringSize] = event;
+  ring->head.store(head + 1, std::memory_order_release);
+}
+
+size_t
+TraceRecorder::eventCount() const
+{
+  std::lock_guard guard{_lock};
+  size_t count = 0;
+
+  for (const auto& ring : _rings)
+  {
+    auto head = ring->head.load(std::memory_order_acquire);
+    auto base = ring->base.load(std::memory_order_relaxed);
+
+    count += std::min<uint64_t>(head - base, ringSize);
+  }
+  return count;
+}
+
+std::string
+TraceRecorder::toJSON() const
+//[]---------------------------------------------------[]
+//|  Events in the Chrome trace event format            |
+//|  @return the JSON text                              |
+//[]---------------------------------------------------[]
+{
+  std::lock_guard guard{_lock};
+  std::string json{"{\"displayTimeUnit\":\"ms\",\"traceEvents\":["};
+  auto first = true;
+
+  for (const auto& ring : _rings)
+  {
+    auto head = ring->head.load(std::memory_order_acquire);
+    auto base = ring->base.load(std::memory_order_relaxed);
+
+    if (head - base > ringSize)
+      base = head - ringSize;
+    if (head == base)
+      continue;
+
+    char buffer[160];
+    auto n = snprintf(buffer,
+      sizeof buffer,
+      "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+      "\"args\":{\"name\":\"thread %u\"}}",
+      first ? "" : ",",
+      ring->tid,
+      ring->tid);
+
+    json.append(buffer, n);
+    first = false;
+    for (auto i = base; i < head; ++i)
+      appendEvent(json, ring->events[i % ringSize], ring->tid, first);
+  }
+  json += "\n]}\n";
+  return json;
+}
+
+bool
+TraceRecorder::writeJSON(const char* filename) const
+{
+  auto f = fopen(filename, "w");
+
+  if (f == nullptr)
+    return false;
+
+  auto json = toJSON();
+  auto ok = fwrite(json.data(), 1, json.size(), f) == json.size();
+
+  return fclose(f) == 0 && ok;
+}
+
+} // end namespace cg
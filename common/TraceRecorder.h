@@ -0,0 +1,169 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalhos Práticos 1 e 2                   |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: TraceRecorder.h
+// ========
+// Class definition for timeline event recorder.
+//
+// Author: Trabalhos Práticos 1 e 2
+// Last revision: 18/10/2025
+
+#ifndef __TraceRecorder_h
+#define __TraceRecorder_h
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cg
+{ // begin namespace cg
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// TraceRecorder: timeline event recorder
+// =============
+//
+// Records, while recording() is true, the begin and end times of
+// coarse-grained events (image tiles, BVH builds, scene parsing and
+// image uploads) of every thread. Each thread writes its events into
+// its own ring buffer, without locks; when the ring is full, the
+// oldest events are overwritten. The rings of finished threads are
+// reused by the threads created afterwards (e.g., the workers of the
+// next frame), which show up on the same timeline track.
+//
+// The events are written in the Chrome trace event format, which can
+// be opened in Perfetto (ui.perfetto.dev) or chrome://tracing.
+class TraceRecorder
+{
+public:
+  static constexpr uint32_t ringSize = 1 << 14; // events per thread
+
+  // The names are not copied: they must be string literals
+  struct Event
+  {
+    const char* name;
+    const char* category;
+    int64_t begin; // ns since the origin of the recorder
+    int64_t end;
+    const char* argNames[2];
+    int64_t args[2];
+
+  };
+
+  static TraceRecorder& instance();
+
+  bool
+  recording() const
+  {
+    return _recording.load(std::memory_order_relaxed);
+  }
+
+  // Discards the events recorded so far and starts recording.
+  void start();
+  void stop();
+
+  // Number of events kept since the last start(). The events should
+  // be read (eventCount(), toJSON()) after stop().
+  size_t eventCount() const;
+
+  std::string toJSON() const;
+  bool writeJSON(const char* filename) const;
+
+  // Appends the event to the ring of the calling thread.
+  void record(const Event&);
+
+  int64_t
+  now() const
+  {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now() - _origin).count();
+  }
+
+  class Scope;
+
+private:
+  struct Ring
+  {
+    std::unique_ptr<Event[]> events{new Event[ringSize]};
+    std::atomic<uint64_t> head{}; // written by the owner thread only
+    std::atomic<uint64_t> base{}; // head at the last start()
+    uint32_t tid;
+
+  };
+
+  mutable std::mutex _lock;
+  std::vector<std::unique_ptr<Ring>> _rings;
+  std::vector<Ring*> _freeRings; // rings of finished threads
+  std::atomic<bool> _recording{false};
+  std::chrono::steady_clock::time_point _origin;
+
+  TraceRecorder();
+
+  Ring* acquireRing();
+  void releaseRing(Ring*);
+
+  friend struct RingOwner;
+
+}; // TraceRecorder
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// TraceRecorder::Scope: event from the construction to the end of
+// ==================== the block, if recording
+class TraceRecorder::Scope
+{
+public:
+  Scope(const char* name,
+    const char* category,
+    const char* argName0 = nullptr,
+    int64_t arg0 = 0,
+    const char* argName1 = nullptr,
+    int64_t arg1 = 0):
+    _recorder{instance()}
+  {
+    if (_recorder.recording())
+      _event = {name,
+        category,
+        _recorder.now(),
+        0,
+        {argName0, argName1},
+        {arg0, arg1}};
+  }
+
+  ~Scope()
+  {
+    if (_event.name != nullptr)
+    {
+      _event.end = _recorder.now();
+      _recorder.record(_event);
+    }
+  }
+
+  Scope(const Scope&) = delete;
+  Scope& operator =(const Scope&) = delete;
+
+private:
+  TraceRecorder& _recorder;
+  Event _event{};
+
+}; // TraceRecorder::Scope
+
+#define CG_TRACE_CONCAT_(a, b) a##b
+#define CG_TRACE_CONCAT(a, b) CG_TRACE_CONCAT_(a, b)
+#define CG_TRACE_SCOPE(...) \
+  ::cg::TraceRecorder::Scope CG_TRACE_CONCAT(_traceScope, __LINE__) \
+    {__VA_ARGS__}
+
+} // end namespace cg
+
+#endif // __TraceRecorder_h
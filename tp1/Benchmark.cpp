@@ -0,0 +1,655 @@
+#include "Benchmark.h"
+#include "RayCaster.h"
+#include "PBRKernel.h"
+#include "SceneBuilder.h"
+#include "SoftwareRenderer.h"
+#include "TraceRecorder.h"
+#include "graphics/Camera.h"
+#include "graphics/Image.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace cg
+{
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+inline double elapsedMs(Clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Imagem sem contexto OpenGL: o benchmark mede apenas o traçado de raios.
+class BenchImage: public Image
+{
+public:
+  BenchImage(int width, int height):
+    Image{width, height}
+  {
+  }
+
+  void setData(const ImageBuffer&)
+  {
+  }
+
+  void setSubData(int, int, const ImageBuffer&)
+  {
+  }
+};
+
+// Nome do arquivo de saída sem a extensão (prefixo das imagens e perfis).
+std::string outputBase(const std::string& output)
+{
+  std::string base = output;
+  auto dot = base.rfind('.');
+
+  if (dot != std::string::npos)
+    base.erase(dot);
+  return base;
+}
+
+// Lê uma lista separada por vírgulas.
+std::vector<std::string> split(const char* s)
+{
+  std::vector<std::string> items;
+  std::stringstream ss{s};
+  std::string item;
+
+  while (std::getline(ss, item, ','))
+    if (!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+// Câmera inicial da janela.
+Camera* defaultCamera()
+{
+  auto camera = new Camera{16.0f / 9.0f};
+
+  camera->setTransform({0, 0, 15}, quatf::identity());
+  camera->setClippingPlanes(0.1f, 100.0f);
+  camera->setProjectionType(Camera::Perspective);
+  camera->setViewAngle(45.0f);
+  return camera;
+}
+
+// Grava o buffer em PPM binário (a linha 0 do buffer é a base da imagem).
+bool writePPM(const char* filename, const ImageBuffer& buffer)
+{
+  FILE* f = fopen(filename, "wb");
+
+  if (f == nullptr)
+    return false;
+
+  const int w = buffer.width();
+  const int h = buffer.height();
+  std::vector<uint8_t> line(3 * (size_t)w);
+
+  fprintf(f, "P6\n%d %d\n255\n", w, h);
+  for (int y = h - 1; y >= 0; --y)
+  {
+    for (int x = 0; x < w; ++x)
+    {
+      const Pixel& p = buffer(x, y);
+
+      line[3 * x] = p.r;
+      line[3 * x + 1] = p.g;
+      line[3 * x + 2] = p.b;
+    }
+    fwrite(line.data(), 1, line.size(), f);
+  }
+  fclose(f);
+  return true;
+}
+
+} // end namespace
+
+bool Benchmark::requested(int argc, char** argv)
+{
+  for (int i = 1; i < argc; ++i)
+    if (strcmp(argv[i], "--bench") == 0)
+      return true;
+  return false;
+}
+
+size_t Benchmark::residentMemory()
+{
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+
+  if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return counters.WorkingSetSize;
+#elif defined(__linux__)
+  if (FILE* f = fopen("/proc/self/statm", "r"))
+  {
+    long pages = 0, resident = 0;
+    int n = fscanf(f, "%ld %ld", &pages, &resident);
+
+    fclose(f);
+    if (n == 2)
+      return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+  }
+#endif
+  return 0;
+}
+
+bool Benchmark::parse(int argc, char** argv, Options& options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+    if (strcmp(arg, "--bench") == 0)
+      continue;
+    if (strcmp(arg, "--shading") == 0)
+    {
+      options.shading = true;
+      continue;
+    }
+    if (strcmp(arg, "--raster") == 0)
+    {
+      options.raster = true;
+      continue;
+    }
+    if (strcmp(arg, "--default-scene") == 0)
+    {
+      options.defaultScene = true;
+      continue;
+    }
+    if (strcmp(arg, "--profile") == 0)
+    {
+      options.profile = true;
+      continue;
+    }
+    if (strcmp(arg, "--trace") == 0)
+    {
+      options.trace = true;
+      continue;
+    }
+    if (strcmp(arg, "--costmap") == 0)
+    {
+      options.costMap = true;
+      continue;
+    }
+    if (value == nullptr)
+    {
+      fprintf(stderr, "Missing value for option '%s'\n", arg);
+      return false;
+    }
+    ++i;
+    if (strcmp(arg, "--counts") == 0)
+    {
+      options.counts.clear();
+      for (const auto& s : split(value))
+        options.counts.push_back(atoi(s.c_str()));
+    }
+    else if (strcmp(arg, "--dist") == 0)
+    {
+      options.distributions.clear();
+      for (const auto& s : split(value))
+      {
+        StressSceneBuilder::Distribution d;
+
+        if (!StressSceneBuilder::parseDistribution(s.c_str(), d))
+        {
+          fprintf(stderr, "Unknown distribution '%s' (uniform, clustered, floor)\n", s.c_str());
+          return false;
+        }
+        options.distributions.push_back(d);
+      }
+    }
+    else if (strcmp(arg, "--res") == 0)
+    {
+      options.resolutions.clear();
+      for (const auto& s : split(value))
+      {
+        int w, h;
+
+        if (sscanf(s.c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0)
+        {
+          fprintf(stderr, "Invalid resolution '%s' (expected WxH)\n", s.c_str());
+          return false;
+        }
+        options.resolutions.emplace_back(w, h);
+      }
+    }
+    else if (strcmp(arg, "--materials") == 0)
+    {
+      if (!StressSceneBuilder::parseMaterialMix(value, options.materials))
+      {
+        fprintf(stderr, "Unknown material mix '%s' (dielectric, metal, mixed)\n", value);
+        return false;
+      }
+    }
+    else if (strcmp(arg, "--lights") == 0)
+      options.lightCount = atoi(value);
+    else if (strcmp(arg, "--frames") == 0)
+      options.frames = std::max(1, atoi(value));
+    else if (strcmp(arg, "--aa") == 0)
+      options.aaSamples = std::clamp(atoi(value), 1, RayCaster::maxAASamples);
+    else if (strcmp(arg, "--large") == 0)
+    {
+      options.largeFractions.clear();
+      for (const auto& s : split(value))
+        options.largeFractions.push_back(std::max((float)atof(s.c_str()), 0.0f));
+    }
+    else if (strcmp(arg, "--seed") == 0)
+      options.seed = (unsigned)strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--out") == 0)
+      options.output = value;
+    else
+    {
+      fprintf(stderr, "Unknown option '%s'\n", arg);
+      return false;
+    }
+  }
+  if (options.counts.empty() || options.distributions.empty() || options.resolutions.empty()
+    || options.largeFractions.empty())
+  {
+    fprintf(stderr, "Empty benchmark configuration\n");
+    return false;
+  }
+  return true;
+}
+
+int Benchmark::run(int argc, char** argv)
+{
+  Options options;
+
+  if (!parse(argc, argv, options))
+  {
+    puts("usage: tp1 --bench [--counts N,...] [--dist uniform,clustered,floor] [--res WxH,...]");
+    puts("                   [--materials dielectric|metal|mixed] [--lights N] [--frames N]");
+    puts("                   [--aa N] [--large F,...] [--default-scene] [--seed N] [--out file.csv]");
+    puts("                   [--profile] [--trace] [--costmap]");
+    puts("       tp1 --bench --shading [--seed N]");
+    puts("       tp1 --bench --raster [--res WxH,...] [--frames N] [--out file]");
+    return EXIT_FAILURE;
+  }
+  return run(options);
+}
+
+int Benchmark::run(const Options& options)
+{
+  if (options.shading)
+    return runShading(options);
+  if (options.raster)
+    return runRaster(options);
+
+  FILE* csv = fopen(options.output.c_str(), "w");
+
+  if (csv == nullptr)
+  {
+    fprintf(stderr, "Unable to create '%s'\n", options.output.c_str());
+    return EXIT_FAILURE;
+  }
+  fprintf(csv, "distribution,actors,lights,width,height,scene_ms,build_ms,frame_ms,rss_mb,sah_cost,"
+    "aa_samples,edge_ratio,large_fraction,large_actors\n");
+  printf("%-10s %9s %6s %10s %6s %6s %10s %10s %9s %8s\n",
+    "dist", "actors", "lights", "res", "large", "out", "scene(ms)", "build(ms)", "frame(ms)", "rss(MB)");
+
+  // Cena padrão da aplicação, vista da posição inicial da câmera da janela.
+  if (options.defaultScene)
+  {
+    auto start = Clock::now();
+    Reference<Scene> scene = SceneBuilder::buildDefaultScene();
+    double sceneMs = elapsedMs(start);
+    Reference<Camera> camera = defaultCamera();
+
+    measure(options, csv, "default", *scene, *camera, sceneMs);
+  }
+
+  for (auto distribution : options.distributions)
+    for (int count : options.counts)
+    {
+      StressSceneBuilder::Params params;
+
+      params.actorCount = count;
+      params.distribution = distribution;
+      params.materials = options.materials;
+      params.lightCount = options.lightCount;
+      params.seed = options.seed;
+
+      auto start = Clock::now();
+      Reference<Scene> scene = StressSceneBuilder::build(params);
+      double sceneMs = elapsedMs(start);
+
+      // Câmera olhando o volume ocupado pelos atores de cima e de frente.
+      float e = StressSceneBuilder::extent(params);
+      Reference<Camera> camera = new Camera{16.0f / 9.0f};
+
+      camera->setTransform({0, 0.6f * e, 2.2f * e + 5.0f}, quatf::identity());
+      camera->setEulerAngles({-15, 0, 0});
+      camera->setClippingPlanes(0.1f, 10.0f * e + 100.0f);
+      camera->setProjectionType(Camera::Perspective);
+      camera->setViewAngle(45.0f);
+      measure(options, csv, StressSceneBuilder::distributionName(distribution), *scene, *camera, sceneMs);
+    }
+  fclose(csv);
+  writePlotScript(options);
+  return EXIT_SUCCESS;
+}
+
+void Benchmark::measure(const Options& options, FILE* csv, const char* name, Scene& scene, Camera& camera,
+  double sceneMs)
+{
+  RayCaster rayCaster{scene, camera};
+
+  // Quadros repetidos com a mesma câmera seriam servidos inteiramente pela reprojeção.
+  rayCaster.setReprojectionEnabled(false);
+  rayCaster.setAASamples(options.aaSamples);
+  rayCaster.setCostMapEnabled(options.costMap);
+
+  int count = scene.actorCount();
+
+  for (float fraction : options.largeFractions)
+  {
+    // A troca do limiar reconstrói a BVH por completo.
+    auto start = Clock::now();
+    rayCaster.setLargeFraction(fraction);
+    double buildMs = elapsedMs(start);
+
+    double rssMb = residentMemory() / (1024.0 * 1024.0);
+    float sahCost = rayCaster.bvh().sahCost();
+    int large = rayCaster.bvh().largeCount();
+
+    for (const auto& [w, h] : options.resolutions)
+    {
+      Reference<Image> image = new BenchImage{w, h};
+
+      camera.setAspectRatio((float)w / (float)h);
+      rayCaster.setImageSize(w, h);
+      rayCaster.renderImage(&camera, image); // aquecimento
+
+      auto& recorder = TraceRecorder::instance();
+
+      if (options.trace)
+        recorder.start();
+      start = Clock::now();
+      for (int i = 0; i < options.frames; ++i)
+        rayCaster.renderImage(&camera, image);
+
+      double frameMs = elapsedMs(start) / options.frames;
+      char res[32];
+
+      recorder.stop();
+      snprintf(res, sizeof(res), "%dx%d", w, h);
+      printf("%-10s %9d %6d %10s %6.2f %6d %10.1f %10.1f %9.1f %8.1f\n",
+        name, count, scene.lightCount(), res, fraction, large, sceneMs, buildMs, frameMs, rssMb);
+      fprintf(csv, "%s,%d,%d,%d,%d,%.3f,%.3f,%.3f,%.2f,%.3f,%d,%.4f,%.3f,%d\n",
+        name, count, scene.lightCount(), w, h, sceneMs, buildMs, frameMs, rssMb, sahCost,
+        options.aaSamples, rayCaster.aaEdgeRatio(), fraction, large);
+      fflush(csv);
+
+      // Estágios do último quadro medido (tabela no terminal e JSON junto do CSV).
+      if (options.profile)
+      {
+        char filename[512];
+
+        snprintf(filename, sizeof(filename), "%s_%s_%d_%s_%.2f_profile.json",
+          outputBase(options.output).c_str(), name, count, res, fraction);
+        rayCaster.profiler().printSummary();
+        if (Profiler::enabled && !rayCaster.profiler().writeJSON(filename))
+          fprintf(stderr, "Unable to create '%s'\n", filename);
+      }
+      if (options.trace)
+      {
+        char filename[512];
+
+        snprintf(filename, sizeof(filename), "%s_%s_%d_%s_%.2f_timeline.json",
+          outputBase(options.output).c_str(), name, count, res, fraction);
+        if (!recorder.writeJSON(filename))
+          fprintf(stderr, "Unable to create '%s'\n", filename);
+      }
+      if (options.costMap)
+      {
+        char base[512];
+
+        snprintf(base, sizeof(base), "%s_%s_%d_%s_%.2f_cost",
+          outputBase(options.output).c_str(), name, count, res, fraction);
+        if (!rayCaster.costMap().write(base))
+          fprintf(stderr, "Unable to create the cost maps '%s_*'\n", base);
+      }
+    }
+  }
+}
+
+// Hits sintéticos (normal, direção de visão e material aleatórios) com 1 a 16 luzes visíveis.
+// Cada kernel é avaliado sobre todos os hits, incluindo o cálculo das constantes do material.
+int Benchmark::runShading(const Options& options)
+{
+  constexpr int hitCount = 1 << 14;
+  constexpr int repeats = 20;
+  const int lightCounts[] = {1, 2, 3, 4, 8, 16};
+
+  std::mt19937 rng{options.seed};
+  std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+  std::uniform_real_distribution<float> coord{-1.0f, 1.0f};
+
+  auto direction = [&]()
+  {
+    for (;;)
+    {
+      vec3f v{coord(rng), coord(rng), coord(rng)};
+      float n = v.squaredNorm();
+
+      if (n > 1e-4f && n <= 1.0f)
+        return v * (1.0f / std::sqrt(n));
+    }
+  };
+
+  struct Hit
+  {
+    vec3f N;
+    vec3f V;
+    Reference<PBRMaterial> material;
+    PBRKernel::LightBatch lights;
+  };
+
+  std::vector<Hit> hits(hitCount);
+
+  printf("%6s %14s %14s %8s %10s\n", "lights", "scalar(ns/hit)", "batch(ns/hit)", "speedup", "max error");
+
+  bool passed = true;
+  double checksum = 0;
+
+  for (int lightCount : lightCounts)
+  {
+    for (auto& hit : hits)
+    {
+      hit.N = direction();
+      hit.V = direction();
+      if (hit.N.dot(hit.V) < 0)
+        hit.V = -hit.V;
+      hit.material = new PBRMaterial{Color{unit(rng), unit(rng), unit(rng)}, Color{unit(rng), unit(rng), unit(rng)},
+        0.05f + 0.95f * unit(rng), unit(rng) < 0.5f ? 0.0f : 1.0f};
+      hit.lights.count = 0;
+      while (hit.lights.count < lightCount)
+      {
+        vec3f L = direction();
+        float NdotL = hit.N.dot(L);
+
+        if (NdotL > 0)
+          hit.lights.add(L, NdotL, Color{unit(rng), unit(rng), unit(rng)});
+      }
+    }
+
+    float maxError = 0;
+
+    for (const auto& hit : hits)
+    {
+      PBRKernel::Surface surface{hit.N, hit.V, hit.material};
+      vec3f a = PBRKernel::evaluateReference(surface, hit.lights);
+      vec3f b = PBRKernel::evaluate(surface, hit.lights);
+      const float ref[] = {a.x, a.y, a.z};
+      const float out[] = {b.x, b.y, b.z};
+
+      for (int c = 0; c < 3; ++c)
+        maxError = std::max(maxError, std::abs(out[c] - ref[c]) / std::max(1.0f, std::abs(ref[c])));
+    }
+
+    // A soma das cores, impressa ao fim, impede que o compilador descarte as avaliações.
+    auto measure = [&](auto kernel)
+    {
+      float total = 0;
+      auto start = Clock::now();
+
+      for (int r = 0; r < repeats; ++r)
+        for (const auto& hit : hits)
+        {
+          PBRKernel::Surface surface{hit.N, hit.V, hit.material};
+          vec3f c = kernel(surface, hit.lights);
+
+          total += c.x + c.y + c.z;
+        }
+
+      double ns = elapsedMs(start) * 1e6 / ((double)hitCount * repeats);
+
+      checksum += total;
+      return ns;
+    };
+
+    double scalar = measure([](const PBRKernel::Surface& s, const PBRKernel::LightBatch& l)
+    {
+      return PBRKernel::evaluateReference(s, l);
+    });
+    double batch = measure([](const PBRKernel::Surface& s, const PBRKernel::LightBatch& l)
+    {
+      return PBRKernel::evaluate(s, l);
+    });
+
+    printf("%6d %14.1f %14.1f %7.2fx %10.2e\n", lightCount, scalar, batch, scalar / batch, maxError);
+    passed = passed && maxError <= PBRKernel::tolerance;
+  }
+  printf("Checksum: %g\n", checksum);
+  if (!passed)
+  {
+    fprintf(stderr, "Batched kernel exceeds tolerance %g\n", PBRKernel::tolerance);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+int Benchmark::runRaster(const Options& options)
+{
+  Reference<Scene> scene = SceneBuilder::buildDefaultScene();
+  Reference<Camera> camera = defaultCamera();
+  SoftwareRenderer renderer{*scene, *camera};
+  std::string base = outputBase(options.output);
+
+  printf("%10s %10s %9s %8s  %s\n", "res", "triangles", "frame(ms)", "fps", "image");
+  for (const auto& [w, h] : options.resolutions)
+  {
+    camera->setAspectRatio((float)w / (float)h);
+    renderer.setImageSize(w, h);
+    renderer.render(); // aquecimento
+
+    auto start = Clock::now();
+
+    for (int i = 0; i < options.frames; ++i)
+      renderer.render();
+
+    double frameMs = elapsedMs(start) / options.frames;
+    char res[32];
+    char filename[256];
+
+    snprintf(res, sizeof(res), "%dx%d", w, h);
+    snprintf(filename, sizeof(filename), "%s_%s.ppm", base.c_str(), res);
+    if (!writePPM(filename, *renderer.colorBuffer()))
+    {
+      fprintf(stderr, "Unable to create '%s'\n", filename);
+      return EXIT_FAILURE;
+    }
+    printf("%10s %10d %9.2f %8.1f  %s\n", res, renderer.triangleCount(), frameMs, 1000.0 / frameMs, filename);
+  }
+  return EXIT_SUCCESS;
+}
+
+// Gera <saida>.gp: tempo de construção, tempo por quadro e memória em função do número de atores.
+void Benchmark::writePlotScript(const Options& options)
+{
+  std::string script = options.output;
+  auto dot = script.rfind('.');
+
+  if (dot != std::string::npos)
+    script.erase(dot);
+
+  std::string base = script;
+  FILE* gp = fopen((script += ".gp").c_str(), "w");
+
+  if (gp == nullptr)
+    return;
+  fprintf(gp, "# gnuplot %s\n", script.c_str());
+  fprintf(gp, "set datafile separator ','\n");
+  fprintf(gp, "set terminal pngcairo size 1000,600\n");
+  fprintf(gp, "set logscale xy\n");
+  fprintf(gp, "set xlabel 'actors'\n");
+  fprintf(gp, "set key top left\n");
+
+  struct Plot
+  {
+    const char* suffix;
+    const char* label;
+    int column;
+    bool perResolution;
+  };
+
+  const Plot plots[] = {
+    {"build", "BVH build time (ms)", 7, false},
+    {"frame", "frame time (ms)", 8, true},
+    {"memory", "resident memory (MB)", 9, false}
+  };
+
+  for (const auto& plot : plots)
+  {
+    fprintf(gp, "\nset output '%s_%s.png'\n", base.c_str(), plot.suffix);
+    fprintf(gp, "set ylabel '%s'\n", plot.label);
+    fprintf(gp, "plot");
+
+    const char* sep = "";
+
+    for (auto distribution : options.distributions)
+    {
+      const char* name = StressSceneBuilder::distributionName(distribution);
+      size_t n = plot.perResolution ? options.resolutions.size() : 1;
+
+      for (float fraction : options.largeFractions)
+        for (size_t r = 0; r < n; ++r)
+        {
+          int w = options.resolutions[r].first;
+          int h = options.resolutions[r].second;
+
+          fprintf(gp, "%s \\\n  '%s' using 2:(strcol(1) eq '%s' && $4 == %d && $5 == %d && $13 == %.3f ? $%d : 1/0)"
+            " with linespoints title '%s",
+            sep, options.output.c_str(), name, w, h, fraction, plot.column, name);
+          if (plot.perResolution)
+            fprintf(gp, " %dx%d", w, h);
+          if (options.largeFractions.size() > 1)
+            fprintf(gp, " large %.2f", fraction);
+          fprintf(gp, "'");
+          sep = ",";
+        }
+    }
+    fprintf(gp, "\n");
+  }
+  fclose(gp);
+  printf("\nResults written to %s (plot with: gnuplot %s)\n", options.output.c_str(), script.c_str());
+}
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "StressSceneBuilder.h"
+#include "graphics/Camera.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace cg
+{
+
+// Benchmark de escalabilidade do RayCaster executado sem janela (modo --bench).
+// Para cada distribuição e número de atores gera uma cena de estresse, mede o tempo de geração,
+// o tempo de construção da BVH, o tempo médio por quadro em cada resolução e a memória residente.
+// Os resultados são gravados em CSV junto com um script gnuplot que gera os gráficos.
+// Com --default-scene, mede também a cena padrão da aplicação com a câmera inicial da janela.
+// Com --shading, mede apenas o kernel de shading (PBRKernel) para diferentes números de luzes.
+// Com --raster, mede o SoftwareRenderer na cena padrão e grava cada resolução em PPM (referência do caminho GL).
+// Com --profile (em builds com CG_PROFILE), imprime e grava em JSON o tempo por estágio de cada medição.
+// Com --trace, grava a linha do tempo das threads nos quadros de cada medição (Chrome trace, Perfetto).
+// Com --costmap, grava o mapa de custo por pixel do último quadro de cada medição (PFM e PNG).
+class Benchmark
+{
+public:
+  struct Options
+  {
+    std::vector<int> counts{1000, 10000, 100000, 1000000};
+    std::vector<StressSceneBuilder::Distribution> distributions{
+      StressSceneBuilder::Distribution::Uniform,
+      StressSceneBuilder::Distribution::Clustered,
+      StressSceneBuilder::Distribution::Floor
+    };
+    std::vector<std::pair<int, int>> resolutions{{640, 360}, {1280, 720}};
+    StressSceneBuilder::MaterialMix materials = StressSceneBuilder::MaterialMix::Mixed;
+    int lightCount = 3;
+    int frames = 3;
+    int aaSamples = 1; // Amostras por pixel de borda (1 desliga o antialiasing)
+    std::vector<float> largeFractions{0.25f}; // Limiares de atores fora da BVH (0 desabilita)
+    bool defaultScene = false; // Inclui a cena padrão da aplicação
+    bool shading = false; // Microbenchmark do kernel de shading em vez das cenas de estresse
+    bool raster = false; // Rasterizador em CPU na cena padrão em vez das cenas de estresse
+    bool profile = false; // Tempo por estágio do último quadro de cada medição
+    bool trace = false; // Linha do tempo das threads nos quadros medidos
+    bool costMap = false; // Custo por pixel do último quadro de cada medição
+    unsigned seed = 1;
+    std::string output = "bench.csv";
+  };
+
+  // Verifica se a linha de comando solicita o modo benchmark.
+  static bool requested(int argc, char** argv);
+
+  // Interpreta as opções e executa o benchmark; retorna o código de saída do processo.
+  static int run(int argc, char** argv);
+
+  static int run(const Options& options);
+
+  // Memória residente do processo em bytes (0 se indisponível na plataforma).
+  static size_t residentMemory();
+
+  // Custo por hit do kernel Cook-Torrance em lote contra o kernel escalar de referência (modo --shading).
+  static int runShading(const Options& options);
+
+  // Tempo por quadro do SoftwareRenderer na cena padrão, com as imagens gravadas em PPM (modo --raster).
+  static int runRaster(const Options& options);
+
+private:
+  static bool parse(int argc, char** argv, Options& options);
+
+  // Mede a cena em cada limiar de atores grandes e resolução, gravando uma linha por medição.
+  static void measure(const Options& options, FILE* csv, const char* name, Scene& scene, Camera& camera,
+    double sceneMs);
+  static void writePlotScript(const Options& options);
+};
+
+}
@@ -14,13 +14,11 @@ public:
   Box(float size = 1.0f):
     _dimensions{size, size, size}
   {
-    generateMesh();
   }
 
   Box(float width, float height, float depth):
     _dimensions{width, height, depth}
   {
-    generateMesh();
   }
 
   // Retorna as dimensões completas (width, height, depth)
@@ -75,7 +73,7 @@ public:
 protected:
   vec3f _dimensions; 
 
-  void generateMesh() override
+  TriangleMesh* generateMesh() const override
   {
     constexpr int nv = 24;
     constexpr int nt = 12;
@@ -127,7 +125,7 @@ protected:
       nv, nt, vertices, normals, uvs, triangles
     };
 
-    _mesh = new TriangleMesh{std::move(meshData)};
+    return new TriangleMesh{std::move(meshData)};
   }
 };
 
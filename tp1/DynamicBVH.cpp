@@ -0,0 +1,1067 @@
+#include "DynamicBVH.h"
+#include "TraceRecorder.h"
+#include <chrono>
+#include <cmath>
+
+namespace cg
+{
+
+namespace
+{
+
+constexpr int SAH_BINS = 12;
+constexpr float SAH_TRAVERSAL_COST = 0.125f; // Custo relativo de travessia (intersecção de ator = 1)
+constexpr int SAH_MAX_DEPTH = 64;            // A partir daqui a construção divide pela mediana
+
+// Teste raio-caixa pelo método das slabs, com a direção inversa pré-calculada.
+// As comparações descartam NaN (origem sobre a face com direção paralela ao eixo).
+inline bool slabTest(const AABB& b, const vec3f& O, const vec3f& invD, float tMin, float tMax, float& tNear)
+{
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    float t0 = (b.min[axis] - O[axis]) * invD[axis];
+    float t1 = (b.max[axis] - O[axis]) * invD[axis];
+
+    if (invD[axis] < 0)
+      std::swap(t0, t1);
+    tMin = t0 > tMin ? t0 : tMin;
+    tMax = t1 < tMax ? t1 : tMax;
+    if (tMax < tMin)
+      return false;
+  }
+  tNear = tMin;
+  return true;
+}
+
+} // end namespace
+
+/////////////////////////////////////////////////////////////////////
+//
+// DynamicBVH::Tree: nós, folhas e operações incrementais.
+//
+void DynamicBVH::Tree::clear()
+{
+  nodes.clear();
+  leaves.clear();
+  freeNodes.clear();
+  freeLeaves.clear();
+  leafOf.clear();
+  root = -1;
+}
+
+int DynamicBVH::Tree::allocNode()
+{
+  if (freeNodes.empty())
+  {
+    nodes.emplace_back();
+    return (int)nodes.size() - 1;
+  }
+
+  int n = freeNodes.back();
+
+  freeNodes.pop_back();
+  nodes[n] = Node{};
+  return n;
+}
+
+int DynamicBVH::Tree::allocLeaf()
+{
+  if (freeLeaves.empty())
+  {
+    leaves.emplace_back();
+    return (int)leaves.size() - 1;
+  }
+
+  int l = freeLeaves.back();
+
+  freeLeaves.pop_back();
+  leaves[l].count = 0;
+  return l;
+}
+
+void DynamicBVH::Tree::freeNode(int n)
+{
+  nodes[n].parent = -1;
+  freeNodes.push_back(n);
+}
+
+void DynamicBVH::Tree::freeLeaf(int l)
+{
+  leaves[l].count = 0;
+  leaves[l].node = -1;
+  freeLeaves.push_back(l);
+}
+
+int DynamicBVH::Tree::makeLeaf(const Item* items, int count, int parent)
+{
+  int n = allocNode();
+  int l = allocLeaf();
+  AABB box;
+
+  leaves[l].node = n;
+  fillLeaf(l, items, count);
+  for (int i = 0; i < count; ++i)
+    box.expand(items[i].box);
+
+  Node& node = nodes[n];
+
+  node.box = box;
+  node.parent = parent;
+  node.leaf = l;
+  setBuiltCost(n);
+  return n;
+}
+
+// Substitui o conteúdo da folha l e reempacota suas formas.
+void DynamicBVH::Tree::fillLeaf(int l, const Item* items, int count)
+{
+  Leaf& leaf = leaves[l];
+  PackedPrimitive prims[maxLeafSize];
+
+  leaf.count = count;
+  for (int i = 0; i < count; ++i)
+  {
+    leaf.actors[i] = items[i].actor;
+    leaf.boxes[i] = items[i].box;
+    prims[i] = items[i].primitive;
+    leafOf[items[i].actor] = l;
+  }
+  leaf.packed.pack(prims, count);
+}
+
+// Recupera os itens da folha l (ator, caixa e forma empacotada).
+int DynamicBVH::Tree::leafItems(int l, Item* items) const
+{
+  const Leaf& leaf = leaves[l];
+  PackedPrimitive prims[maxLeafSize];
+  int n = leaf.packed.unpack(prims);
+
+  for (int i = 0; i < leaf.count; ++i)
+  {
+    items[i].actor = leaf.actors[i];
+    items[i].box = leaf.boxes[i];
+    for (int j = 0; j < n; ++j)
+      if (prims[j].actor == leaf.actors[i])
+      {
+        items[i].primitive = prims[j];
+        break;
+      }
+  }
+  return leaf.count;
+}
+
+// Construção top-down com SAH em caixas (binned SAH) nos três eixos.
+int DynamicBVH::Tree::buildRange(Item* items, int count, int parent, int depth)
+{
+  AABB box, centroids;
+
+  for (int i = 0; i < count; ++i)
+  {
+    box.expand(items[i].box);
+    centroids.expand(items[i].box.center());
+  }
+  if (count == 1)
+    return makeLeaf(items, count, parent);
+
+  int mid = -1;
+
+  if (depth < SAH_MAX_DEPTH)
+  {
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    int bestBin = -1;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      float lo = centroids.min[axis];
+      float extent = centroids.max[axis] - lo;
+
+      if (extent <= 0)
+        continue;
+
+      int binCount[SAH_BINS] = {};
+      AABB binBox[SAH_BINS];
+      float scale = SAH_BINS / extent;
+
+      for (int i = 0; i < count; ++i)
+      {
+        int b = std::min(SAH_BINS - 1, (int)((items[i].box.center()[axis] - lo) * scale));
+
+        ++binCount[b];
+        binBox[b].expand(items[i].box);
+      }
+
+      // Varredura da direita para a esquerda acumulando as áreas dos sufixos.
+      float rightArea[SAH_BINS];
+      int rightCount[SAH_BINS];
+      AABB acc;
+      int n = 0;
+
+      for (int b = SAH_BINS - 1; b > 0; --b)
+      {
+        acc.expand(binBox[b]);
+        n += binCount[b];
+        rightArea[b] = acc.area();
+        rightCount[b] = n;
+      }
+      acc = AABB{};
+      n = 0;
+      for (int b = 0; b < SAH_BINS - 1; ++b)
+      {
+        acc.expand(binBox[b]);
+        n += binCount[b];
+        if (n == 0 || rightCount[b + 1] == 0)
+          continue;
+
+        float cost = n * acc.area() + rightCount[b + 1] * rightArea[b + 1];
+
+        if (cost < bestCost)
+        {
+          bestCost = cost;
+          bestAxis = axis;
+          bestBin = b;
+        }
+      }
+    }
+
+    float area = box.area();
+    float splitCost = area > 0 ? SAH_TRAVERSAL_COST + bestCost / area : (float)count;
+
+    if (count <= leafSize && (bestAxis < 0 || count <= splitCost))
+      return makeLeaf(items, count, parent);
+    if (bestAxis >= 0)
+    {
+      float lo = centroids.min[bestAxis];
+      float scale = SAH_BINS / (centroids.max[bestAxis] - lo);
+      Item* split = std::partition(items, items + count, [&](const Item& item)
+      {
+        return std::min(SAH_BINS - 1, (int)((item.box.center()[bestAxis] - lo) * scale)) <= bestBin;
+      });
+
+      mid = (int)(split - items);
+    }
+  }
+  else if (count <= leafSize)
+    return makeLeaf(items, count, parent);
+
+  if (mid <= 0 || mid >= count)
+  {
+    // Centroides coincidentes ou árvore profunda demais: divisão pela mediana do maior eixo.
+    vec3f d = centroids.max - centroids.min;
+    int axis = d.x > d.y ? (d.x > d.z ? 0 : 2) : (d.y > d.z ? 1 : 2);
+
+    mid = count / 2;
+    std::nth_element(items, items + mid, items + count, [axis](const Item& a, const Item& b)
+    {
+      return a.box.center()[axis] < b.box.center()[axis];
+    });
+  }
+
+  int n = allocNode();
+  int c0 = buildRange(items, mid, n, depth + 1);
+  int c1 = buildRange(items + mid, count - mid, n, depth + 1);
+  Node& node = nodes[n];
+
+  node.box = box;
+  node.parent = parent;
+  node.child[0] = c0;
+  node.child[1] = c1;
+  setBuiltCost(n);
+  return n;
+}
+
+void DynamicBVH::Tree::build(std::vector<Item>& items)
+{
+  clear();
+  if (items.empty())
+    return;
+
+  int leafCount = ((int)items.size() + leafSize - 1) / leafSize;
+
+  nodes.reserve(4 * leafCount);
+  leaves.reserve(2 * leafCount);
+  leafOf.reserve(items.size());
+  root = buildRange(items.data(), (int)items.size(), -1, 0);
+}
+
+int DynamicBVH::Tree::depthOf(int n) const
+{
+  int depth = 0;
+
+  while ((n = nodes[n].parent) >= 0)
+    ++depth;
+  return depth;
+}
+
+// Recalcula as caixas de n até a raiz; para assim que uma caixa não muda.
+void DynamicBVH::Tree::refitUp(int n)
+{
+  while (n >= 0)
+  {
+    Node& node = nodes[n];
+    AABB box;
+
+    if (node.isLeaf())
+    {
+      const Leaf& leaf = leaves[node.leaf];
+
+      for (int i = 0; i < leaf.count; ++i)
+        box.expand(leaf.boxes[i]);
+    }
+    else
+      box = AABB::merge(nodes[node.child[0]].box, nodes[node.child[1]].box);
+    if (box == node.box)
+      break;
+    node.box = box;
+    n = node.parent;
+  }
+}
+
+// Toma o custo atual do nó n, composto com o custo de construção dos filhos, como referência de degradação.
+void DynamicBVH::Tree::setBuiltCost(int n)
+{
+  Node& node = nodes[n];
+  float area = node.box.area();
+
+  if (node.isLeaf())
+    node.builtCost = (float)leaves[node.leaf].count;
+  else if (area > 0)
+  {
+    const Node& c0 = nodes[node.child[0]];
+    const Node& c1 = nodes[node.child[1]];
+
+    node.builtCost = SAH_TRAVERSAL_COST + (c0.box.area() * c0.builtCost + c1.box.area() * c1.builtCost) / area;
+  }
+  else
+    node.builtCost = 0;
+}
+
+void DynamicBVH::Tree::refitLeaf(int n)
+{
+  const Leaf& leaf = leaves[nodes[n].leaf];
+  AABB box;
+
+  for (int i = 0; i < leaf.count; ++i)
+    box.expand(leaf.boxes[i]);
+  nodes[n].box = box;
+}
+
+// Insere o ator descendo pelo filho de menor aumento de área; divide a folha se estiver cheia.
+void DynamicBVH::Tree::insert(const Item& item)
+{
+  const AABB& box = item.box;
+
+  if (root < 0)
+  {
+    root = makeLeaf(&item, 1, -1);
+    return;
+  }
+
+  int n = root;
+
+  while (!nodes[n].isLeaf())
+  {
+    const Node& node = nodes[n];
+    int c0 = node.child[0];
+    int c1 = node.child[1];
+    float a0 = nodes[c0].box.area();
+    float a1 = nodes[c1].box.area();
+    float d0 = AABB::merge(nodes[c0].box, box).area() - a0;
+    float d1 = AABB::merge(nodes[c1].box, box).area() - a1;
+
+    n = d0 < d1 || (d0 == d1 && a0 <= a1) ? c0 : c1;
+  }
+
+  int l = nodes[n].leaf;
+  Item items[maxLeafSize + 1];
+  int count = leafItems(l, items);
+
+  items[count++] = item;
+  if (count <= leafSize)
+  {
+    fillLeaf(l, items, count);
+    refitUp(n);
+    return;
+  }
+
+  // Folha cheia: redistribui os atores em duas folhas filhas (SAH sobre o maior eixo).
+  AABB centroids;
+
+  for (int i = 0; i < count; ++i)
+    centroids.expand(items[i].box.center());
+
+  vec3f d = centroids.max - centroids.min;
+  int axis = d.x > d.y ? (d.x > d.z ? 0 : 2) : (d.y > d.z ? 1 : 2);
+
+  // No máximo maxLeafSize + 1 itens: ordenação por inserção.
+  for (int i = 1; i < count; ++i)
+  {
+    Item t = items[i];
+    float c = t.box.center()[axis];
+    int j = i;
+
+    for (; j > 0 && items[j - 1].box.center()[axis] > c; --j)
+      items[j] = items[j - 1];
+    items[j] = t;
+  }
+
+  float rightArea[maxLeafSize + 1];
+  AABB acc;
+
+  for (int i = count - 1; i > 0; --i)
+  {
+    acc.expand(items[i].box);
+    rightArea[i] = acc.area();
+  }
+  acc = AABB{};
+
+  float bestCost = std::numeric_limits<float>::max();
+  int mid = count / 2;
+
+  for (int i = 1; i < count; ++i)
+  {
+    acc.expand(items[i - 1].box);
+
+    float cost = i * acc.area() + (count - i) * rightArea[i];
+
+    if (cost < bestCost)
+    {
+      bestCost = cost;
+      mid = i;
+    }
+  }
+  freeLeaf(l);
+
+  int c0 = makeLeaf(items, mid, n);
+  int c1 = makeLeaf(items + mid, count - mid, n);
+  Node& node = nodes[n];
+
+  node.leaf = -1;
+  node.child[0] = c0;
+  node.child[1] = c1;
+  refitUp(n);
+  setBuiltCost(n);
+}
+
+// Remove o nó n (folha vazia) e promove o irmão ao lugar do pai.
+void DynamicBVH::Tree::removeNode(int n)
+{
+  int p = nodes[n].parent;
+
+  freeNode(n);
+  if (p < 0)
+  {
+    root = -1;
+    return;
+  }
+
+  int sibling = nodes[p].child[0] == n ? nodes[p].child[1] : nodes[p].child[0];
+  int g = nodes[p].parent;
+
+  nodes[sibling].parent = g;
+  freeNode(p);
+  if (g < 0)
+  {
+    root = sibling;
+    return;
+  }
+  nodes[g].child[nodes[g].child[0] == p ? 0 : 1] = sibling;
+  refitUp(g);
+}
+
+void DynamicBVH::Tree::remove(PBRActor* actor)
+{
+  auto it = leafOf.find(actor);
+
+  if (it == leafOf.end())
+    return;
+
+  int l = it->second;
+  int n = leaves[l].node;
+  Item items[maxLeafSize];
+  int count = leafItems(l, items);
+
+  leafOf.erase(it);
+  for (int i = 0; i < count; ++i)
+    if (items[i].actor == actor)
+    {
+      items[i] = items[--count];
+      break;
+    }
+  fillLeaf(l, items, count);
+  if (count > 0)
+    refitUp(n);
+  else
+  {
+    freeLeaf(l);
+    removeNode(n);
+  }
+}
+
+// Refit da folha do ator; se a nova caixa escapou muito da vizinhança, o ator é reinserido.
+void DynamicBVH::Tree::update(const Item& item)
+{
+  auto it = leafOf.find(item.actor);
+
+  if (it == leafOf.end())
+    return;
+
+  int l = it->second;
+  int n = leaves[l].node;
+  float oldArea = nodes[n].box.area();
+  Item items[maxLeafSize];
+  int count = leafItems(l, items);
+
+  for (int i = 0; i < count; ++i)
+    if (items[i].actor == item.actor)
+    {
+      items[i] = item;
+      break;
+    }
+  fillLeaf(l, items, count);
+  refitLeaf(n);
+
+  const AABB& leafBox = nodes[n].box;
+  int p = nodes[n].parent;
+  bool escaped = count > 1 && leafBox.area() > 2 * oldArea;
+
+  if (!escaped && p >= 0 && !nodes[p].box.contains(leafBox))
+    escaped = AABB::merge(nodes[p].box, leafBox).area() > 2 * nodes[p].box.area();
+  if (escaped)
+  {
+    remove(item.actor);
+    insert(item);
+  }
+  else if (p >= 0)
+    refitUp(p);
+}
+
+DynamicBVH::Item DynamicBVH::Tree::itemOf(PBRActor* actor) const
+{
+  auto it = leafOf.find(actor);
+
+  if (it != leafOf.end())
+  {
+    Item items[maxLeafSize];
+    int count = leafItems(it->second, items);
+
+    for (int i = 0; i < count; ++i)
+      if (items[i].actor == actor)
+        return items[i];
+  }
+  return Item{actor, AABB{}, PackedPrimitive{}};
+}
+
+// Custo SAH: soma das áreas dos nós internos (travessia) e das folhas ponderadas pelo número de atores.
+float DynamicBVH::Tree::sahCost() const
+{
+  if (root < 0)
+    return 0;
+
+  float rootArea = nodes[root].box.area();
+
+  if (rootArea <= 0)
+    return 0;
+
+  std::vector<int> stack{root};
+  float cost = 0;
+
+  while (!stack.empty())
+  {
+    const Node& node = nodes[stack.back()];
+
+    stack.pop_back();
+    if (node.isLeaf())
+      cost += node.box.area() * leaves[node.leaf].count;
+    else
+    {
+      cost += node.box.area() * SAH_TRAVERSAL_COST;
+      stack.push_back(node.child[0]);
+      stack.push_back(node.child[1]);
+    }
+  }
+  return cost / rootArea;
+}
+
+// Custo SAH (não normalizado) da subárvore de n; costs recebe o custo de cada nó da subárvore.
+float DynamicBVH::Tree::subtreeCost(int n, std::vector<float>& costs) const
+{
+  const Node& node = nodes[n];
+  float area = node.box.area();
+
+  if (node.isLeaf())
+    return costs[n] = area * leaves[node.leaf].count;
+  return costs[n] = area * SAH_TRAVERSAL_COST
+    + subtreeCost(node.child[0], costs)
+    + subtreeCost(node.child[1], costs);
+}
+
+// Quanto o custo da subárvore de n excede o da sua construção.
+float DynamicBVH::Tree::excessCost(int n, const std::vector<float>& costs) const
+{
+  return costs[n] - nodes[n].builtCost * nodes[n].box.area();
+}
+
+int DynamicBVH::Tree::actorCount(int n) const
+{
+  std::vector<int> stack{n};
+  int count = 0;
+
+  while (!stack.empty())
+  {
+    const Node& node = nodes[stack.back()];
+
+    stack.pop_back();
+    if (node.isLeaf())
+      count += leaves[node.leaf].count;
+    else
+    {
+      stack.push_back(node.child[0]);
+      stack.push_back(node.child[1]);
+    }
+  }
+  return count;
+}
+
+// Reconstrói com SAH, no lugar, a subárvore de n; os atores são os mesmos, então as caixas dos
+// ancestrais não mudam.
+void DynamicBVH::Tree::rebuildSubtree(int n)
+{
+  int parent = nodes[n].parent;
+  int slot = parent >= 0 && nodes[parent].child[1] == n ? 1 : 0;
+  int depth = depthOf(n);
+  std::vector<Item> items;
+  std::vector<int> stack{n};
+  Item buffer[maxLeafSize];
+
+  while (!stack.empty())
+  {
+    int m = stack.back();
+    const Node& node = nodes[m];
+
+    stack.pop_back();
+    if (node.isLeaf())
+    {
+      items.insert(items.end(), buffer, buffer + leafItems(node.leaf, buffer));
+      freeLeaf(node.leaf);
+    }
+    else
+    {
+      stack.push_back(node.child[0]);
+      stack.push_back(node.child[1]);
+    }
+    freeNode(m);
+  }
+
+  int m = buildRange(items.data(), (int)items.size(), parent, depth);
+
+  if (parent < 0)
+    root = m;
+  else
+    nodes[parent].child[slot] = m;
+}
+
+void DynamicBVH::Tree::collect(std::vector<Item>& items) const
+{
+  Item buffer[maxLeafSize];
+
+  items.reserve(leafOf.size());
+  for (int l = 0; l < (int)leaves.size(); ++l)
+    if (leaves[l].node >= 0)
+      items.insert(items.end(), buffer, buffer + leafItems(l, buffer));
+}
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// DynamicBVH implementation
+//
+DynamicBVH::DynamicBVH(int leafSize, float rebuildThreshold):
+  _rebuildThreshold{std::max(rebuildThreshold, 1.0f)}
+{
+  _tree.leafSize = std::clamp(leafSize, 1, maxLeafSize);
+}
+
+DynamicBVH::~DynamicBVH()
+{
+  if (_rebuild.valid())
+    _rebuild.wait();
+}
+
+void DynamicBVH::build(const std::vector<PBRActor*>& actors)
+{
+  if (_rebuild.valid())
+  {
+    _rebuild.wait();
+    _rebuild = {};
+  }
+  _edited.clear();
+
+  std::vector<Item> items;
+
+  items.reserve(actors.size());
+  for (auto actor : actors)
+    if (actor != nullptr && actor->shape() != nullptr)
+      items.push_back(makeItem(actor));
+  partition(items);
+}
+
+void DynamicBVH::setLargeFraction(float fraction)
+{
+  if (_rebuild.valid())
+  {
+    _rebuild.wait();
+    _rebuild = {};
+  }
+  _edited.clear();
+
+  std::vector<Item> items;
+
+  _tree.collect(items);
+  items.insert(items.end(), _large.begin(), _large.end());
+  _largeFraction = std::max(fraction, 0.0f);
+  partition(items);
+}
+
+AABB DynamicBVH::bounds() const
+{
+  AABB box = _tree.root < 0 ? AABB{} : _tree.nodes[_tree.root].box;
+
+  for (const auto& item : _large)
+    if (std::isfinite(item.box.area()))
+      box.expand(item.box);
+  return box;
+}
+
+bool DynamicBVH::isLarge(const AABB& box, float sceneArea) const
+{
+  float area = box.area();
+
+  // Limites ilimitados (área infinita ou NaN) nunca entram na hierarquia.
+  if (!std::isfinite(area))
+    return true;
+  return _largeFraction > 0 && area > _largeFraction * sceneArea;
+}
+
+int DynamicBVH::largeIndex(PBRActor* actor) const
+{
+  for (int i = 0; i < (int)_large.size(); ++i)
+    if (_large[i].actor == actor)
+      return i;
+  return -1;
+}
+
+void DynamicBVH::packLarge()
+{
+  PackedPrimitive prims[maxLargeActors];
+  int count = 0;
+
+  _largeBox = AABB{};
+  _largeUnbounded = false;
+  for (const auto& item : _large)
+  {
+    prims[count++] = item.primitive;
+    _largeBox.expand(item.box);
+    _largeUnbounded |= !std::isfinite(item.box.area());
+  }
+  _largePacked.pack(prims, count);
+}
+
+void DynamicBVH::partition(std::vector<Item>& items)
+{
+  AABB scene;
+
+  for (const auto& item : items)
+    if (std::isfinite(item.box.area()))
+      scene.expand(item.box);
+
+  float sceneArea = scene.area();
+  auto mid = std::stable_partition(items.begin(), items.end(), [&](const Item& item)
+  {
+    return isLarge(item.box, sceneArea);
+  });
+
+  // Acima do limite da lista, somente os maiores ficam fora da hierarquia.
+  if (mid - items.begin() > maxLargeActors)
+  {
+    std::sort(items.begin(), mid, [](const Item& a, const Item& b)
+    {
+      float aa = a.box.area(), ba = b.box.area();
+      return !std::isfinite(aa) ? std::isfinite(ba) : aa > ba;
+    });
+    mid = items.begin() + maxLargeActors;
+  }
+  _large.assign(items.begin(), mid);
+  packLarge();
+  items.erase(items.begin(), mid);
+  _tree.build(items);
+  _dirty = false;
+}
+
+void DynamicBVH::place(const Item& item)
+{
+  float sceneArea = AABB::merge(bounds(), item.box).area();
+
+  if ((int)_large.size() < maxLargeActors && isLarge(item.box, sceneArea))
+  {
+    _large.push_back(item);
+    packLarge();
+    return;
+  }
+  _tree.insert(item);
+  if (_tree.depthOf(_tree.leaves[_tree.leafOf[item.actor]].node) > maxDepth)
+    rebuildNow();
+}
+
+DynamicBVH::Item DynamicBVH::makeItem(PBRActor* actor)
+{
+  return Item{actor, AABB{actor->bounds()}, PackedPrimitive{actor}};
+}
+
+void DynamicBVH::markEdited(PBRActor* actor)
+{
+  _dirty = true;
+  if (_rebuild.valid())
+    _edited.insert(actor);
+}
+
+void DynamicBVH::insert(PBRActor* actor)
+{
+  if (actor == nullptr || actor->shape() == nullptr || contains(actor))
+    return;
+  markEdited(actor);
+  place(makeItem(actor));
+}
+
+void DynamicBVH::remove(PBRActor* actor)
+{
+  if (!contains(actor))
+    return;
+  markEdited(actor);
+  if (int i = largeIndex(actor); i >= 0)
+  {
+    _large.erase(_large.begin() + i);
+    packLarge();
+  }
+  else
+    _tree.remove(actor);
+}
+
+void DynamicBVH::update(PBRActor* actor)
+{
+  if (!contains(actor))
+    return;
+  markEdited(actor);
+
+  Item item = makeItem(actor);
+  int i = largeIndex(actor);
+  bool large = isLarge(item.box, AABB::merge(bounds(), item.box).area());
+
+  if (i >= 0 && large)
+  {
+    _large[i] = item;
+    packLarge();
+  }
+  else if (i < 0 && (!large || (int)_large.size() == maxLargeActors))
+  {
+    _tree.update(item);
+    if (_tree.depthOf(_tree.leaves[_tree.leafOf[actor]].node) > maxDepth)
+      rebuildNow();
+  }
+  else
+  {
+    // A classificação do ator mudou: troca entre a lista e a hierarquia.
+    if (i >= 0)
+    {
+      _large.erase(_large.begin() + i);
+      packLarge();
+    }
+    else
+      _tree.remove(actor);
+    place(item);
+  }
+}
+
+// Reconstrução síncrona (usada quando a árvore excede a profundidade máxima de travessia).
+void DynamicBVH::rebuildNow()
+{
+  std::vector<Item> items;
+
+  if (_rebuild.valid())
+  {
+    _rebuild.wait();
+    _rebuild = {};
+  }
+  _edited.clear();
+  _tree.collect(items);
+  _tree.build(items);
+  _dirty = false;
+}
+
+// Quando o custo SAH da árvore degrada além do limiar, reconstrói só a menor subárvore que concentra
+// 90% do aumento de custo (edições de um ator ou de uma região degradam o caminho até ela). Se essa
+// subárvore tem até um oitavo dos atores, a reconstrução é feita no lugar, com custo proporcional aos
+// seus atores; se a degradação está espalhada pela árvore, ela é reconstruída em segundo plano.
+void DynamicBVH::rebuildDegraded()
+{
+  if (_tree.root < 0)
+    return;
+
+  const Node& root = _tree.nodes[_tree.root];
+  std::vector<float> costs(_tree.nodes.size());
+  float cost = _tree.subtreeCost(_tree.root, costs);
+
+  if (cost <= _rebuildThreshold * root.builtCost * root.box.area())
+    return;
+
+  int n = _tree.root;
+
+  while (!_tree.nodes[n].isLeaf())
+  {
+    const Node& node = _tree.nodes[n];
+    int c0 = node.child[0];
+    int c1 = node.child[1];
+    int c = _tree.excessCost(c0, costs) > _tree.excessCost(c1, costs) ? c0 : c1;
+
+    if (_tree.excessCost(c, costs) < 0.9f * _tree.excessCost(n, costs))
+      break;
+    n = c;
+  }
+
+  int count = _tree.actorCount(n);
+
+  if (n == _tree.root || 8 * count > (int)_tree.leafOf.size())
+  {
+    startRebuild();
+    return;
+  }
+  CG_TRACE_SCOPE("BVH subtree rebuild", "scene", "actors", (int64_t)count);
+  _tree.rebuildSubtree(n);
+}
+
+void DynamicBVH::startRebuild()
+{
+  std::vector<Item> items;
+  int leafSize = _tree.leafSize;
+
+  _tree.collect(items);
+  _edited.clear();
+  _rebuild = std::async(std::launch::async, [items = std::move(items), leafSize]() mutable
+  {
+    CG_TRACE_SCOPE("BVH rebuild", "scene", "actors", (int64_t)items.size());
+    Tree tree;
+
+    tree.leafSize = leafSize;
+    tree.build(items);
+    return tree;
+  });
+}
+
+void DynamicBVH::commit()
+{
+  if (_rebuild.valid() && _rebuild.wait_for(std::chrono::seconds{0}) == std::future_status::ready)
+  {
+    Tree tree = _rebuild.get();
+    bool tooDeep = false;
+
+    // Reaplica na nova árvore as edições feitas enquanto ela era construída
+    // (atores que passaram para a lista de atores grandes ficam fora dela).
+    for (auto actor : _edited)
+    {
+      tree.remove(actor);
+      if (_tree.leafOf.count(actor) != 0)
+      {
+        tree.insert(_tree.itemOf(actor));
+        tooDeep |= tree.depthOf(tree.leaves[tree.leafOf[actor]].node) > maxDepth;
+      }
+    }
+    _edited.clear();
+    _tree = std::move(tree);
+    if (tooDeep)
+      rebuildNow();
+    _dirty = false;
+  }
+  if (_dirty && !_rebuild.valid())
+  {
+    _dirty = false;
+    rebuildDegraded();
+  }
+}
+
+bool DynamicBVH::intersect(const Ray3f& ray, Intersection& hit, CostMap::Counters* cost) const
+{
+  struct Entry
+  {
+    int node;
+    float t;
+  };
+
+  const auto& nodes = _tree.nodes;
+  const vec3f& O = ray.origin;
+  const vec3f invD{1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z};
+  Ray3f r = ray;
+  bool found = false;
+  Entry stack[maxDepth + 32];
+  int top = 0;
+  float tNear;
+
+  // Atores grandes primeiro: um hit (tipicamente no chão) já encurta o raio para a travessia.
+  // A caixa que os envolve descarta, por exemplo, raios de sombra que partem do chão para cima.
+  if (!_large.empty() && (_largeUnbounded || slabTest(_largeBox, O, invD, r.tMin, r.tMax, tNear)))
+  {
+    found = _largePacked.intersect(r, hit);
+    if (cost != nullptr)
+      cost->primitives += (uint32_t)_large.size();
+  }
+  if (_tree.root < 0 || !slabTest(nodes[_tree.root].box, O, invD, r.tMin, r.tMax, tNear))
+    return found;
+  stack[top++] = Entry{_tree.root, tNear};
+  while (top > 0)
+  {
+    Entry e = stack[--top];
+
+    // O hit mais próximo pode ter sido encontrado depois do empilhamento.
+    if (e.t > r.tMax)
+      continue;
+
+    const Node& node = nodes[e.node];
+
+    if (cost != nullptr)
+    {
+      ++cost->nodes;
+      if (node.isLeaf())
+        cost->primitives += (uint32_t)_tree.leaves[node.leaf].count;
+    }
+    if (node.isLeaf())
+    {
+      // Kernels em lote por tipo de forma; reduzem r.tMax ao hit mais próximo.
+      found |= _tree.leaves[node.leaf].packed.intersect(r, hit);
+      continue;
+    }
+
+    float t0 = 0, t1 = 0;
+    int c0 = node.child[0];
+    int c1 = node.child[1];
+    bool hit0 = slabTest(nodes[c0].box, O, invD, r.tMin, r.tMax, t0);
+    bool hit1 = slabTest(nodes[c1].box, O, invD, r.tMin, r.tMax, t1);
+
+    // Empilha o filho mais distante primeiro para visitar o mais próximo antes.
+    if (hit0 && hit1)
+    {
+      if (t0 > t1)
+      {
+        std::swap(c0, c1);
+        std::swap(t0, t1);
+      }
+      stack[top++] = Entry{c1, t1};
+      stack[top++] = Entry{c0, t0};
+    }
+    else if (hit0)
+      stack[top++] = Entry{c0, t0};
+    else if (hit1)
+      stack[top++] = Entry{c1, t1};
+  }
+  return found;
+}
+
+}
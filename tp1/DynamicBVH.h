@@ -0,0 +1,250 @@
+#pragma once
+
+#include "PBRActor.h"
+#include "PackedLeaf.h"
+#include "CostMap.h"
+#include "geometry/Ray.h"
+#include "geometry/Intersection.h"
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace cg
+{
+
+// Caixa alinhada aos eixos usada internamente pela BVH dinâmica.
+struct AABB
+{
+  vec3f min{+std::numeric_limits<float>::infinity()};
+  vec3f max{-std::numeric_limits<float>::infinity()};
+
+  AABB() = default;
+
+  AABB(const vec3f& p1, const vec3f& p2):
+    min{p1},
+    max{p2}
+  {
+  }
+
+  AABB(const Bounds3f& b):
+    min{b.min()},
+    max{b.max()}
+  {
+  }
+
+  bool empty() const { return min.x > max.x; }
+
+  vec3f center() const { return (min + max) * 0.5f; }
+
+  void expand(const vec3f& p)
+  {
+    min = vec3f{std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z)};
+    max = vec3f{std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z)};
+  }
+
+  void expand(const AABB& b)
+  {
+    if (b.empty())
+      return;
+    expand(b.min);
+    expand(b.max);
+  }
+
+  bool contains(const AABB& b) const
+  {
+    return min.x <= b.min.x && min.y <= b.min.y && min.z <= b.min.z
+        && max.x >= b.max.x && max.y >= b.max.y && max.z >= b.max.z;
+  }
+
+  bool operator ==(const AABB& b) const
+  {
+    return min.x == b.min.x && min.y == b.min.y && min.z == b.min.z
+        && max.x == b.max.x && max.y == b.max.y && max.z == b.max.z;
+  }
+
+  // Área de superfície (base do custo SAH).
+  float area() const
+  {
+    if (empty())
+      return 0;
+
+    vec3f d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  }
+
+  static AABB merge(const AABB& a, const AABB& b)
+  {
+    AABB c = a;
+    c.expand(b);
+    return c;
+  }
+};
+
+// BVH dinâmica de atores (Bounding Volume Hierarchy incremental).
+// Além da construção completa com SAH, suporta inserção, remoção e refit de atores em O(log N),
+// permitindo edições interativas sem reconstruir a hierarquia. Cada nó guarda o custo SAH da sua
+// subárvore na última construção; quando o custo da árvore degrada além de um limiar, commit()
+// reconstrói apenas a subárvore que concentra o aumento. Se ela contém mais de um oitavo dos atores,
+// uma nova hierarquia é construída em segundo plano e substitui a atual em um commit() seguinte.
+// As folhas guardam as formas analíticas empacotadas (PackedLeaf); por isso toda alteração de
+// transformação de um ator deve ser notificada por update().
+// Atores grandes em relação à cena (como o plano do chão) ou de limites ilimitados ficam fora da
+// hierarquia, em uma lista pequena testada diretamente por todo raio: na árvore, suas caixas
+// inflariam os nós ancestrais e fariam quase todo raio descer até a folha que os contém.
+class DynamicBVH
+{
+public:
+  // Número máximo de atores por folha.
+  static constexpr int maxLeafSize = 8;
+
+  // Profundidade máxima admitida (limita a pilha de travessia).
+  static constexpr int maxDepth = 96;
+
+  // Número máximo de atores mantidos fora da hierarquia.
+  static constexpr int maxLargeActors = 16;
+
+  DynamicBVH(int leafSize = maxLeafSize, float rebuildThreshold = 1.3f);
+  ~DynamicBVH();
+
+  // Constrói a hierarquia completa (SAH) a partir dos atores; descarta reconstruções pendentes.
+  void build(const std::vector<PBRActor*>& actors);
+
+  void insert(PBRActor* actor);
+  void remove(PBRActor* actor);
+
+  // Atualiza os limites do ator após mudança de transformação (refit ou reinserção).
+  void update(PBRActor* actor);
+
+  bool contains(PBRActor* actor) const { return _tree.leafOf.count(actor) != 0 || largeIndex(actor) >= 0; }
+  bool empty() const { return _tree.root < 0 && _large.empty(); }
+  int size() const { return (int)(_tree.leafOf.size() + _large.size()); }
+  AABB bounds() const;
+
+  // Custo SAH (da hierarquia, sem os atores grandes) normalizado pela área da raiz.
+  float sahCost() const { return _tree.sahCost(); }
+
+  // Fração da área de superfície da cena a partir da qual um ator fica fora da hierarquia
+  // (0 desabilita; atores de limites ilimitados ficam sempre fora). Reclassifica os atores.
+  float largeFraction() const { return _largeFraction; }
+  void setLargeFraction(float fraction);
+
+  // Número de atores mantidos fora da hierarquia.
+  int largeCount() const { return (int)_large.size(); }
+
+  // Limiar relativo ao custo de construção da árvore que dispara a reconstrução.
+  float rebuildThreshold() const { return _rebuildThreshold; }
+  void setRebuildThreshold(float t) { _rebuildThreshold = std::max(t, 1.0f); }
+
+  bool isRebuilding() const { return _rebuild.valid(); }
+
+  // Ponto de sincronização entre quadros: adota a hierarquia reconstruída em segundo plano
+  // (reaplicando as edições feitas durante a construção) e reconstrói a subárvore degradada.
+  void commit();
+
+  // Interseção do raio com os atores da hierarquia (hit mais próximo). Com cost, soma os nós
+  // visitados e os atores testados (inclusive os de fora da hierarquia).
+  bool intersect(const Ray3f& ray, Intersection& hit, CostMap::Counters* cost = nullptr) const;
+
+private:
+  struct Node
+  {
+    AABB box;
+    int parent = -1;
+    int child[2] = {-1, -1};
+    int leaf = -1; // índice em Tree::leaves quando o nó é folha
+    float builtCost = 0; // custo SAH da subárvore, normalizado pela área do nó, na sua construção
+
+    bool isLeaf() const { return leaf >= 0; }
+  };
+
+  struct Leaf
+  {
+    int node = -1;
+    int count = 0;
+    PBRActor* actors[maxLeafSize];
+    AABB boxes[maxLeafSize];
+    PackedLeaf packed;
+  };
+
+  struct Item
+  {
+    PBRActor* actor;
+    AABB box;
+    PackedPrimitive primitive;
+  };
+
+  struct Tree
+  {
+    std::vector<Node> nodes;
+    std::vector<Leaf> leaves;
+    std::vector<int> freeNodes;
+    std::vector<int> freeLeaves;
+    std::unordered_map<PBRActor*, int> leafOf;
+    int root = -1;
+    int leafSize = maxLeafSize;
+
+    void clear();
+    void build(std::vector<Item>& items);
+    void insert(const Item& item);
+    void remove(PBRActor* actor);
+    void update(const Item& item);
+    Item itemOf(PBRActor* actor) const;
+    float sahCost() const;
+    float subtreeCost(int n, std::vector<float>& costs) const;
+    float excessCost(int n, const std::vector<float>& costs) const;
+    int actorCount(int n) const;
+    void rebuildSubtree(int n);
+    void collect(std::vector<Item>& items) const;
+
+    int allocNode();
+    int allocLeaf();
+    void freeNode(int n);
+    void freeLeaf(int l);
+    int makeLeaf(const Item* items, int count, int parent);
+    void fillLeaf(int l, const Item* items, int count);
+    int leafItems(int l, Item* items) const;
+    int buildRange(Item* items, int count, int parent, int depth);
+    int depthOf(int n) const;
+    void removeNode(int n);
+    void refitLeaf(int n);
+    void refitUp(int n);
+    void setBuiltCost(int n);
+  };
+
+  Tree _tree;
+  std::vector<Item> _large;  // atores fora da hierarquia
+  PackedLeaf _largePacked;
+  AABB _largeBox;          // caixa dos atores grandes (vazia se algum for ilimitado)
+  bool _largeUnbounded = false;
+  float _largeFraction = 0.25f;
+  float _rebuildThreshold;
+  bool _dirty = false;
+  std::future<Tree> _rebuild;
+  std::unordered_set<PBRActor*> _edited; // edições ocorridas durante a reconstrução
+
+  // Limites e forma empacotada do ator (lidos na thread principal).
+  static Item makeItem(PBRActor* actor);
+
+  // Verifica se a caixa deve ficar fora da hierarquia em uma cena com área de superfície sceneArea.
+  bool isLarge(const AABB& box, float sceneArea) const;
+
+  int largeIndex(PBRActor* actor) const;
+
+  // Adiciona o item à lista de atores grandes ou à hierarquia, conforme a classificação.
+  void place(const Item& item);
+
+  // Distribui os itens entre a lista de atores grandes e a hierarquia, construída do zero.
+  void partition(std::vector<Item>& items);
+
+  void packLarge();
+
+  void startRebuild();
+  void rebuildNow();
+  void rebuildDegraded();
+  void markEdited(PBRActor* actor);
+};
+
+}
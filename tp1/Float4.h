@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TP1_SSE 1
+#endif
+
+namespace cg
+{
+
+namespace simd
+{
+
+// Vetor de 4 floats: registradores SSE quando disponíveis, laço escalar caso contrário.
+// Comparações produzem máscaras com todos os bits da faixa ligados.
+#ifdef TP1_SSE
+
+struct Float4
+{
+  __m128 v;
+
+  Float4() = default;
+  Float4(__m128 x): v{x} {}
+  Float4(float s): v{_mm_set1_ps(s)} {}
+
+  // Faixas (a, b, c, d).
+  static Float4 set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+  static Float4 load(const float* p) { return _mm_load_ps(p); }
+  void store(float* p) const { _mm_store_ps(p, v); }
+};
+
+inline Float4 operator +(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+inline Float4 operator -(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+inline Float4 operator *(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+inline Float4 operator /(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+inline Float4 operator <(Float4 a, Float4 b) { return _mm_cmplt_ps(a.v, b.v); }
+inline Float4 operator <=(Float4 a, Float4 b) { return _mm_cmple_ps(a.v, b.v); }
+inline Float4 operator >(Float4 a, Float4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+inline Float4 operator >=(Float4 a, Float4 b) { return _mm_cmpge_ps(a.v, b.v); }
+inline Float4 operator &(Float4 a, Float4 b) { return _mm_and_ps(a.v, b.v); }
+inline Float4 operator |(Float4 a, Float4 b) { return _mm_or_ps(a.v, b.v); }
+inline Float4 sqrt(Float4 a) { return _mm_sqrt_ps(a.v); }
+inline Float4 abs(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+inline Float4 min(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+inline Float4 max(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+inline Float4 select(Float4 mask, Float4 a, Float4 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+}
+inline int bits(Float4 mask) { return _mm_movemask_ps(mask.v); }
+
+#else
+
+struct Float4
+{
+  float v[4];
+
+  Float4() = default;
+  Float4(float s): v{s, s, s, s} {}
+
+  static Float4 set(float a, float b, float c, float d) { return Float4{a, b, c, d}; }
+  static Float4 load(const float* p) { return Float4{p[0], p[1], p[2], p[3]}; }
+  void store(float* p) const { std::copy(v, v + 4, p); }
+
+private:
+  Float4(float a, float b, float c, float d): v{a, b, c, d} {}
+};
+
+template <typename F>
+inline Float4 lanes(Float4 a, Float4 b, F f)
+{
+  Float4 r;
+
+  for (int i = 0; i < 4; ++i)
+    r.v[i] = f(a.v[i], b.v[i]);
+  return r;
+}
+
+inline float laneMask(bool b) { return std::bit_cast<float>(b ? ~0u : 0u); }
+
+inline Float4 operator +(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return x + y; }); }
+inline Float4 operator -(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return x - y; }); }
+inline Float4 operator *(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return x * y; }); }
+inline Float4 operator /(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return x / y; }); }
+inline Float4 operator <(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return laneMask(x < y); }); }
+inline Float4 operator <=(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return laneMask(x <= y); }); }
+inline Float4 operator >(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return laneMask(x > y); }); }
+inline Float4 operator >=(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return laneMask(x >= y); }); }
+inline Float4 operator &(Float4 a, Float4 b)
+{
+  return lanes(a, b, [](float x, float y)
+  {
+    return std::bit_cast<float>(std::bit_cast<uint32_t>(x) & std::bit_cast<uint32_t>(y));
+  });
+}
+inline Float4 operator |(Float4 a, Float4 b)
+{
+  return lanes(a, b, [](float x, float y)
+  {
+    return std::bit_cast<float>(std::bit_cast<uint32_t>(x) | std::bit_cast<uint32_t>(y));
+  });
+}
+inline Float4 sqrt(Float4 a) { return lanes(a, a, [](float x, float) { return std::sqrt(x); }); }
+inline Float4 abs(Float4 a) { return lanes(a, a, [](float x, float) { return std::abs(x); }); }
+inline Float4 min(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return x < y ? x : y; }); }
+inline Float4 max(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return x > y ? x : y; }); }
+inline Float4 select(Float4 mask, Float4 a, Float4 b)
+{
+  Float4 r;
+
+  for (int i = 0; i < 4; ++i)
+    r.v[i] = std::bit_cast<uint32_t>(mask.v[i]) ? a.v[i] : b.v[i];
+  return r;
+}
+inline int bits(Float4 mask)
+{
+  int m = 0;
+
+  for (int i = 0; i < 4; ++i)
+    m |= (std::bit_cast<uint32_t>(mask.v[i]) >> 31) << i;
+  return m;
+}
+
+#endif
+
+} // end namespace simd
+
+}
@@ -3,6 +3,7 @@
 #include "Scene.h"
 #include "graphics/Camera.h"
 #include "PBRActor.h"
+#include "TraceRecorder.h"
 
 namespace cg
 {
@@ -71,18 +72,122 @@ void GUIInitializer::drawRendererControls()
   if (ImGui::Checkbox("Use Ray Caster", &useRayCaster))
     _window.setUseRayCaster(useRayCaster);
   
-  ImGui::Text("Active Renderer: %s", useRayCaster ? "RayCaster (with BVH)" : "PBRRenderer (OpenGL)");
+  ImGui::Text("Active Renderer: %s", useRayCaster ? "RayCaster (with BVH)" :
+    _window.useSoftwareRaster() ? "SoftwareRenderer (CPU)" : "PBRRenderer (OpenGL)");
   
   if (useRayCaster)
   {
     ImGui::TextColored(ImVec4(0.5f, 1.0f, 0.5f, 1.0f), "RayCaster rendering active");
     ImGui::Text("BVH acceleration enabled");
+
+    // Buffer de IDs por pixel: seleção por consulta direta em vez de Ray Picking.
+    if (auto rayCaster = _window.rayCaster())
+    {
+      bool idBuffer = rayCaster->idBufferEnabled();
+      if (ImGui::Checkbox("Object-ID Picking Buffer", &idBuffer))
+        rayCaster->setIdBufferEnabled(idBuffer);
+
+      // Prévia em baixa resolução durante a interação, refinada quando a câmera para.
+      bool progressive = rayCaster->progressive();
+      if (ImGui::Checkbox("Progressive Preview", &progressive))
+        rayCaster->setProgressive(progressive);
+
+      if (progressive)
+      {
+        float budget = rayCaster->frameBudget();
+        if (ImGui::SliderFloat("Frame Budget (ms)", &budget, 8.0f, 100.0f, "%.0f"))
+          rayCaster->setFrameBudget(budget);
+      }
+
+      // Reaproveitamento do quadro anterior durante pequenos movimentos de câmera.
+      bool reprojection = rayCaster->reprojectionEnabled();
+      if (ImGui::Checkbox("Temporal Reprojection", &reprojection))
+        rayCaster->setReprojectionEnabled(reprojection);
+
+      if (reprojection)
+      {
+        float tolerance = rayCaster->reprojectionTolerance();
+        if (ImGui::SliderFloat("View Angle Tolerance", &tolerance, 0.0f, 10.0f, "%.1f deg"))
+          rayCaster->setReprojectionTolerance(tolerance);
+        ImGui::Text("Reused pixels: %.0f%%", rayCaster->reuseRatio() * 100.0f);
+      }
+
+      // Amostras extras apenas nos pixels de borda (ator ou normal diferente do vizinho).
+      static const int aaSamples[] = {1, 4, 8, 16};
+      int aa = 0;
+      while (aa < 3 && aaSamples[aa] < rayCaster->aaSamples())
+        ++aa;
+      if (ImGui::Combo("Edge Antialiasing", &aa, "Off\0" "4x\0" "8x\0" "16x\0"))
+        rayCaster->setAASamples(aaSamples[aa]);
+      if (aa > 0)
+        ImGui::Text("Edge pixels: %.1f%%", rayCaster->aaEdgeRatio() * 100.0f);
+
+      // Atores grandes (como o chão) testados fora da BVH; 0 mantém todos na hierarquia.
+      float large = rayCaster->largeFraction();
+      if (ImGui::SliderFloat("Out-of-BVH Size", &large, 0.0f, 1.0f, "%.2f of scene"))
+        rayCaster->setLargeFraction(large);
+      ImGui::Text("Out-of-BVH actors: %d", rayCaster->bvh().largeCount());
+
+      // Tempo por estágio do último quadro apresentado (somado entre as threads).
+      if (Profiler::enabled && ImGui::TreeNode("Profiler"))
+      {
+        const auto& stats = rayCaster->profiler().lastFrame();
+        const double total = stats.totalTime();
+
+        for (int i = 0; i < Profiler::stageCount; ++i)
+          ImGui::Text("%-20s %9.3f ms %5.1f%%", Profiler::stageName((Profiler::Stage)i), stats.time[i],
+            total > 0 ? stats.time[i] * 100 / total : 0.0);
+        ImGui::Text("Wall time: %.3f ms (%d threads)", stats.wallTime, stats.threadCount);
+        // Os estágios por raio são estimados a partir de uma amostra dos pixels.
+        ImGui::Text("Sampled pixels: %llu of %llu", (unsigned long long)stats.sampledPixels,
+          (unsigned long long)stats.pixels);
+        if (ImGui::Button("Export JSON"))
+          rayCaster->profiler().writeJSON("profile.json");
+        ImGui::TreePop();
+      }
+
+      // Custo por pixel do último quadro completo, gravado em PFM e em PNG de cores falsas.
+      bool costMap = rayCaster->costMapEnabled();
+      if (ImGui::Checkbox("Record Cost Map", &costMap))
+        rayCaster->setCostMapEnabled(costMap);
+      if (!rayCaster->costMap().empty())
+      {
+        ImGui::SameLine();
+        if (ImGui::Button("Save Cost Map"))
+          rayCaster->costMap().write("cost");
+      }
+    }
   }
   else
   {
-    ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.5f, 1.0f), "OpenGL rendering active");
+    // Rasterização em CPU com o mesmo shading do pbrFragmentShader, sem limite de luzes.
+    bool softwareRaster = _window.useSoftwareRaster();
+    if (ImGui::Checkbox("Software Rasterizer", &softwareRaster))
+      _window.setUseSoftwareRaster(softwareRaster);
+
+    if (softwareRaster)
+    {
+      ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.5f, 1.0f), "CPU rasterization active");
+      if (auto renderer = _window.softwareRenderer())
+        ImGui::Text("Triangles: %d", renderer->triangleCount());
+    }
+    else
+      ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.5f, 1.0f), "OpenGL rendering active");
     ImGui::Text("Click on objects to select them");
   }
+
+  // Linha do tempo das threads (formato Chrome trace, abre no Perfetto).
+  auto& recorder = TraceRecorder::instance();
+  bool recording = recorder.recording();
+
+  if (ImGui::Checkbox("Record Timeline", &recording))
+    recording ? recorder.start() : recorder.stop();
+  ImGui::SameLine();
+  if (ImGui::Button("Save Timeline"))
+  {
+    recorder.stop();
+    recorder.writeJSON("timeline.json");
+  }
 }
 
 void GUIInitializer::drawSceneControls()
@@ -102,7 +207,7 @@ void GUIInitializer::drawSceneControls()
   // Edição da cor de fundo (Background).
   float bg[3] = { scene->backgroundColor.r, scene->backgroundColor.g, scene->backgroundColor.b };
   if (ImGui::ColorEdit3("Background", bg))
-    scene->backgroundColor = Color(bg[0], bg[1], bg[2]);
+    editScene([&]() { scene->backgroundColor = Color(bg[0], bg[1], bg[2]); });
 
   ImGui::Spacing();
   if (ImGui::Button("Reset Scene Geometry"))
@@ -170,18 +275,18 @@ void GUIInitializer::drawLightControls()
     if (ImGui::TreeNode(light->name()))
     {
       bool on = light->isTurnedOn();
-      if(ImGui::Checkbox("Enabled", &on)) light->turnOn(on);
+      if(ImGui::Checkbox("Enabled", &on)) editScene([&]() { light->turnOn(on); });
 
       vec3f pos = light->position();
-      if (ImGui::DragFloat3("Pos", (float*)&pos, 0.1f)) light->setPosition(pos);
+      if (ImGui::DragFloat3("Pos", (float*)&pos, 0.1f)) editScene([&]() { light->setPosition(pos); });
 
       float col[3] = { light->color.r, light->color.g, light->color.b };
-      if (ImGui::ColorEdit3("Color", col)) light->color = Color(col[0], col[1], col[2]);
+      if (ImGui::ColorEdit3("Color", col)) editScene([&]() { light->color = Color(col[0], col[1], col[2]); });
 
       // Seleção do tipo de decaimento (atenuação) da luz.
       int falloff = (int)light->falloff;
       if(ImGui::Combo("Falloff", &falloff, "None\0Linear\0Quadratic\0"))
-        light->falloff = (Light::Falloff)falloff;
+        editScene([&]() { light->falloff = (Light::Falloff)falloff; });
 
       ImGui::TreePop();
     }
@@ -220,6 +325,20 @@ void GUIInitializer::drawMaterialControls()
     ImGui::EndCombo();
   }
 
+  // Atores da última seleção retangular (Shift + arrasto na viewport).
+  const auto& rectActors = _window.selectedActors();
+  if (!rectActors.empty())
+  {
+    ImGui::Text("Rectangle selection: %d actors", (int)rectActors.size());
+    for (const auto& a : rectActors)
+      if (ImGui::Selectable(a->name(), a.get() == _window.selectedActor()))
+      {
+        _window.setSelectedActor(a.get());
+        PBRRenderer* renderer = _window.pbrRenderer();
+        if (renderer) renderer->setSelectedActor(a.get());
+      }
+  }
+
   PBRActor* actor = getSelectedActor();
   if (!actor) return;
 
@@ -229,39 +348,68 @@ void GUIInitializer::drawMaterialControls()
   PBRMaterial* mat = actor->pbrMaterial();
 
   float od[3] = { mat->Od.r, mat->Od.g, mat->Od.b };
-  if (ImGui::ColorEdit3("Albedo (Od)", od)) mat->Od = Color(od[0], od[1], od[2]);
+  if (ImGui::ColorEdit3("Albedo (Od)", od)) editScene([&]() { mat->Od = Color(od[0], od[1], od[2]); });
 
   float os[3] = { mat->Os.r, mat->Os.g, mat->Os.b };
-  if (ImGui::ColorEdit3("F0 (Os)", os)) mat->Os = Color(os[0], os[1], os[2]);
+  if (ImGui::ColorEdit3("F0 (Os)", os)) editScene([&]() { mat->Os = Color(os[0], os[1], os[2]); });
+
+  float roughness = mat->roughness;
+  if (ImGui::SliderFloat("Roughness", &roughness, 0.01f, 1.0f)) editScene([&]() { mat->roughness = roughness; });
 
-  ImGui::SliderFloat("Roughness", &mat->roughness, 0.01f, 1.0f);
-  ImGui::SliderFloat("Metallic", &mat->metalness, 0.0f, 1.0f);
+  float metalness = mat->metalness;
+  if (ImGui::SliderFloat("Metallic", &metalness, 0.0f, 1.0f)) editScene([&]() { mat->metalness = metalness; });
 
   // Aplicação de Materiais Predefinidos.
   ImGui::Separator();
     ImGui::Text("Presets:");
   float r = mat->roughness;
-  if (ImGui::Button("Gold")) actor->setPBRMaterial(PBRMaterial::gold(r));
+  PBRMaterial* preset = nullptr;
+  if (ImGui::Button("Gold")) preset = PBRMaterial::gold(r);
   ImGui::SameLine();
-  if (ImGui::Button("Silver")) actor->setPBRMaterial(PBRMaterial::silver(r));
+  if (ImGui::Button("Silver")) preset = PBRMaterial::silver(r);
   ImGui::SameLine();
-  if (ImGui::Button("Copper")) actor->setPBRMaterial(PBRMaterial::copper(r));
+  if (ImGui::Button("Copper")) preset = PBRMaterial::copper(r);
   ImGui::SameLine();
-  if (ImGui::Button("Aluminum")) actor->setPBRMaterial(PBRMaterial::aluminum(r));
+  if (ImGui::Button("Aluminum")) preset = PBRMaterial::aluminum(r);
   
-  if (ImGui::Button("Titanium")) actor->setPBRMaterial(PBRMaterial::titanium(r));
+  if (ImGui::Button("Titanium")) preset = PBRMaterial::titanium(r);
   ImGui::SameLine();
-  if (ImGui::Button("Plastic")) actor->setPBRMaterial(PBRMaterial::dielectric(Color(0.8f, 0.2f, 0.2f), r));
+  if (ImGui::Button("Plastic")) preset = PBRMaterial::dielectric(Color(0.8f, 0.2f, 0.2f), r);
+  if (preset != nullptr)
+    editScene([&]() { actor->setPBRMaterial(preset); });
   
   // Controle simples de Transformação (Translação).
   ImGui::Separator();
   vec3f pos = actor->position();
   if (ImGui::DragFloat3("Actor Pos", (float*)&pos, 0.1f))
-    actor->setPosition(pos);
+    editActor(actor, [&]() { actor->setPosition(pos); });
 
   bool visible = actor->isVisible();
   if (ImGui::Checkbox("Visible", &visible))
-    actor->setVisible(visible);
+    editActor(actor, [&]() { actor->setVisible(visible); });
+}
+
+// O estágio progressivo em andamento é cancelado antes da alteração, pois ele lê a cena.
+void GUIInitializer::editActor(PBRActor* actor, const std::function<void()>& change)
+{
+  auto rayCaster = _window.rayCaster();
+
+  if (rayCaster)
+    rayCaster->cancel();
+  change();
+  if (rayCaster)
+    rayCaster->updateActor(actor);
+}
+
+void GUIInitializer::editScene(const std::function<void()>& change)
+{
+  auto rayCaster = _window.rayCaster();
+
+  if (rayCaster)
+    rayCaster->cancel();
+  change();
+  if (rayCaster)
+    rayCaster->touch();
 }
 
 PBRActor* GUIInitializer::getSelectedActor()
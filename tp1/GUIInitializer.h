@@ -3,6 +3,7 @@
 #include "graphics/Application.h"
 #include "graphics/Camera.h"
 #include "PBRActor.h"
+#include <functional>
 
 namespace cg
 {
@@ -31,6 +32,10 @@ private:
   void drawMaterialControls();
   
   PBRActor* getSelectedActor();
+
+  // Aplica uma edição do inspetor e notifica o Ray Caster (BVH incremental e nova renderização).
+  void editActor(PBRActor* actor, const std::function<void()>& change);
+  void editScene(const std::function<void()>& change);
 };
 
 }
\ No newline at end of file
@@ -14,12 +14,17 @@
 
 #include "graphics/Application.h"
 #include "MainWindow.h"
+#include "Benchmark.h"
 
 using namespace cg;
 
 int
 main(int argc, char** argv)
 {
+  // Modo benchmark (sem janela): tp1 --bench [opções].
+  if (Benchmark::requested(argc, argv))
+    return Benchmark::run(argc, argv);
+
   puts("==============================================");
   puts("  PBR Rendering - Trabalho Prático 1");
   puts("  Computação Gráfica - UFMS");
@@ -40,6 +45,10 @@ main(int argc, char** argv)
   puts("  - Multiple sphere actors with varying materials");
   puts("  - Interactive GUI for lights and materials");
   puts("  - Real-time parameter adjustment\n");
+
+  puts("Benchmark (headless):");
+  puts("  tp1 --bench [--counts 1000,10000] [--dist uniform,clustered,floor]");
+  puts("              [--res 640x360,1280x720] [--lights 3] [--out bench.csv]\n");
   
   puts("Starting application...\n");
   
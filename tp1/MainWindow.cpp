@@ -2,6 +2,8 @@
 #include "PBRActor.h"
 #include "imgui.h"
 #include "GUIInitializer.h"
+#include <chrono>
+#include <cstdlib>
 
 namespace cg
 {
@@ -30,6 +32,10 @@ void MainWindow::initialize()
     _renderer = new PBRRenderer{*_scene, *camera};
     _renderer->setImageSize(width(), height());
 
+    // Rasterizador em CPU equivalente, usado sem OpenGL ou como referência.
+    _softwareRenderer = new SoftwareRenderer{*_scene, *camera};
+    _softwareRenderer->setImageSize(width(), height());
+
     // Inicialização do pipeline de Ray Casting (CPU) para seleção e renderização alternativa.
     _rayCaster = new RayCaster{*_scene, *camera};
     _rayCaster->setImageSize(width(), height());
@@ -55,6 +61,8 @@ void MainWindow::resetScene()
 {
     _resetRequested = false;
     _selectedActor = nullptr;
+    _selectedActors.clear();
+    _isRectSelecting = false;
 
     if (_rayCaster)
     {
@@ -68,14 +76,21 @@ void MainWindow::resetScene()
         _renderer = nullptr;
     }
 
+    delete _softwareRenderer;
+    _softwareRenderer = nullptr;
+
     _scene = SceneBuilder::buildDefaultScene();
    
     auto currentCam = this->camera();
     _renderer = new PBRRenderer{*_scene, *currentCam};
     _renderer->setImageSize(width(), height());
+
+    _softwareRenderer = new SoftwareRenderer{*_scene, *currentCam};
+    _softwareRenderer->setImageSize(width(), height());
     
     _rayCaster = new RayCaster{*_scene, *currentCam };
     _rayCaster->setImageSize(width(), height());
+    _image = nullptr; // Força nova renderização da cena recriada.
 }
 
 bool MainWindow::windowResizeEvent(int width, int height)
@@ -91,6 +106,8 @@ bool MainWindow::windowResizeEvent(int width, int height)
     // Atualização das dimensões de viewport nos renderizadores.
     if (_renderer)
         _renderer->setImageSize(width, height);
+    if (_softwareRenderer)
+        _softwareRenderer->setImageSize(width, height);
     if (_rayCaster)
         _rayCaster->setImageSize(width, height);
 
@@ -135,6 +152,24 @@ bool MainWindow::mouseButtonInputEvent(int button, int action, int mods)
 {
     if (ImGui::GetIO().WantCaptureMouse) return false;
 
+    // Shift + Botão Esquerdo: Seleção retangular (Drag).
+    if (button == GLFW_MOUSE_BUTTON_LEFT && (action == GLFW_PRESS ? (mods & GLFW_MOD_SHIFT) != 0 : _isRectSelecting))
+    {
+        if (action == GLFW_PRESS)
+        {
+            _isRectSelecting = true;
+            cursorPosition(_rectX0, _rectY0);
+            _rectX1 = _rectX0;
+            _rectY1 = _rectY0;
+        }
+        else if (action == GLFW_RELEASE)
+        {
+            _isRectSelecting = false;
+            selectRectangle();
+        }
+        return true;
+    }
+
     // Botão Esquerdo: Seleção (Press) ou Pan (Drag).
     if (button == GLFW_MOUSE_BUTTON_LEFT)
     {
@@ -181,6 +216,13 @@ bool MainWindow::mouseButtonInputEvent(int button, int action, int mods)
 
 bool MainWindow::mouseMoveEvent(double xPos, double yPos)
 {
+    if (_isRectSelecting)
+    {
+        _rectX1 = (int)xPos;
+        _rectY1 = (int)yPos;
+        return true;
+    }
+
     if (ImGui::GetIO().WantCaptureMouse) return false;
 
     if (_isDragging)
@@ -252,9 +294,9 @@ bool MainWindow::onMouseLeftPress(int x, int y)
     }
     
     // Conversão de coordenadas: Sistema de Janela (Top-Left) para OpenGL (Bottom-Left).
-    int glY = height() - y;
+    int glY = height() - 1 - y;
     
-    // Executa Ray Picking usando a estrutura de aceleração (BVH) do RayCaster.
+    // Executa o picking: leitura do buffer de IDs do último quadro ou Ray Picking via BVH.
     _selectedActor = _rayCaster->selectActor(x, glY);
     
     // Sincroniza a seleção com o renderizador OpenGL para feedback visual (e.g., Bounding Box).
@@ -267,6 +309,30 @@ bool MainWindow::onMouseLeftPress(int x, int y)
     return false;
 }
 
+void MainWindow::selectRectangle()
+{
+    if (_rayCaster == nullptr) 
+    {
+        printf("Error: RayCaster not initialized.\n");
+        return;
+    }
+
+    // Varre o buffer de IDs (ou lança um raio por pixel) no retângulo, em coordenadas OpenGL.
+    auto start = std::chrono::steady_clock::now();
+    auto actors = _rayCaster->selectActors(_rectX0, height() - 1 - _rectY0, _rectX1, height() - 1 - _rectY1);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    _selectedActors.assign(actors.begin(), actors.end());
+    _selectedActor = actors.empty() ? nullptr : actors.front();
+
+    // O renderizador OpenGL destaca apenas o primeiro ator da seleção.
+    if (_renderer)
+        _renderer->setSelectedActor(_selectedActor);
+
+    printf("Rectangle selection: %zu actors in %.2f ms (%dx%d pixels)\n",
+        actors.size(), ms, std::abs(_rectX1 - _rectX0) + 1, std::abs(_rectY1 - _rectY0) + 1);
+}
+
 Camera* MainWindow::getCamera()
 {
     return camera();
@@ -292,25 +358,50 @@ void MainWindow::render()
 
             bool imageInvalid = (!_image || _image->width() != width() || _image->height() != height());
             uint32_t currentStamp = camera->timestamp();
-            static uint32_t lastCameraTimestamp = 0; 
-            bool cameraChanged = (currentStamp != lastCameraTimestamp);
+            bool cameraChanged = (currentStamp != _cameraTimestamp);
+            bool sceneChanged = (_rayCaster->sceneVersion() != _sceneVersion);
 
-            if (imageInvalid || cameraChanged)
+            if (imageInvalid || cameraChanged || sceneChanged)
             {
                 if (imageInvalid)
                 {
                     _image = new GLImage(width(), height());
                     _rayCaster->setImageSize(width(), height());
                 }
-                _rayCaster->renderImage(camera, _image);
-                lastCameraTimestamp = currentStamp;
+
+                // Modo progressivo: prévia em baixa resolução dentro do orçamento de tempo e
+                // refinamento em segundo plano (cancelado se a câmera ou a cena mudarem de novo).
+                if (_rayCaster->progressive())
+                {
+                    int step = _rayCaster->renderPreview(camera, _image);
+                    if (step > 1)
+                        _rayCaster->startStage(camera, step / 2);
+                }
+                else
+                    _rayCaster->renderImage(camera, _image);
+                _cameraTimestamp = currentStamp;
+                _sceneVersion = _rayCaster->sceneVersion();
             }
+            else if (int step = _rayCaster->pollStage(_image); step > 1)
+                _rayCaster->startStage(camera, step / 2);
             
             // Exibe o buffer de imagem gerado como uma textura OpenGL.
             if (_image)
                 _image->draw(0, 0);
         }
     }
+    else if (_useSoftwareRaster)
+    {
+        // Pipeline de Rasterização em CPU: o buffer de cor é exibido como textura.
+        if (_softwareRenderer != nullptr)
+        {
+            if (!_rasterImage || _rasterImage->width() != width() || _rasterImage->height() != height())
+                _rasterImage = new GLImage(width(), height());
+            _softwareRenderer->setSelectedActor(_selectedActor);
+            _softwareRenderer->render(_rasterImage);
+            _rasterImage->draw(0, 0);
+        }
+    }
     else
     {
         // Pipeline de Rasterização padrão (OpenGL).
@@ -322,11 +413,26 @@ void MainWindow::render()
 void MainWindow::gui()
 {
     if (_gui) _gui->draw();
+
+    // Contorno do retângulo de seleção enquanto o usuário arrasta o mouse.
+    if (_isRectSelecting)
+    {
+        auto* drawList = ImGui::GetForegroundDrawList();
+        ImVec2 a{(float)std::min(_rectX0, _rectX1), (float)std::min(_rectY0, _rectY1)};
+        ImVec2 b{(float)std::max(_rectX0, _rectX1), (float)std::max(_rectY0, _rectY1)};
+        drawList->AddRectFilled(a, b, IM_COL32(80, 160, 255, 40));
+        drawList->AddRect(a, b, IM_COL32(80, 160, 255, 255));
+    }
 }
 
 void MainWindow::terminate()
 {
+    // Interrompe o refinamento progressivo antes que a cena seja liberada.
+    if (_rayCaster)
+        _rayCaster->cancel();
     delete _renderer;
+    // Libera as formas compartilhadas enquanto o contexto OpenGL ainda existe.
+    ShapeCache::clear();
     printf("MainWindow terminated\n");
 }
 
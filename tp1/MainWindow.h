@@ -4,6 +4,7 @@
 #include "graphics/GLRenderWindow3.h"
 #include "PBRRenderer.h"
 #include "RayCaster.h"
+#include "SoftwareRenderer.h"
 #include "SceneBuilder.h"
 #include "GUIInitializer.h"
 
@@ -31,6 +32,7 @@ public:
   {
     delete _gui;
     delete _renderer;
+    delete _softwareRenderer;
     delete _scene;
   }
 
@@ -51,6 +53,9 @@ public:
   
   PBRActor* selectedActor() const { return _selectedActor; }
   void setSelectedActor(PBRActor* actor) { _selectedActor = actor; }
+
+  // Atores marcados pela última seleção retangular (Shift + arrasto).
+  const std::vector<Reference<PBRActor>>& selectedActors() const { return _selectedActors; }
   
   // Reinicia a geometria da cena para o estado inicial.
   void resetScene();
@@ -59,8 +64,13 @@ public:
   // Controle de alternância entre pipelines de renderização.
   bool useRayCaster() const { return _enableRayCaster; }
   void setUseRayCaster(bool use) { _enableRayCaster = use; }
+
+  // Rasterização em CPU no lugar do OpenGL (mesma imagem do PBRRenderer).
+  bool useSoftwareRaster() const { return _useSoftwareRaster; }
+  void setUseSoftwareRaster(bool use) { _useSoftwareRaster = use; }
   
   PBRRenderer* pbrRenderer() const { return _renderer; }
+  SoftwareRenderer* softwareRenderer() const { return _softwareRenderer; }
   RayCaster* rayCaster() const { return _rayCaster; }
 
 protected:
@@ -82,14 +92,19 @@ protected:
 private:
   PBRRenderer* _renderer;   // Pipeline de Rasterização (OpenGL)
   RayCaster* _rayCaster;    // Pipeline de Ray Casting (CPU)
+  SoftwareRenderer* _softwareRenderer = nullptr; // Pipeline de Rasterização (CPU)
   GUIInitializer* _gui;
   Reference<Scene> _scene;
   Reference<GLImage> _image;
+  Reference<GLImage> _rasterImage; // Quadro do rasterizador em CPU
   Reference<PBRActor> _selectedActor = nullptr;
+  std::vector<Reference<PBRActor>> _selectedActors;
   
   uint32_t _cameraTimestamp = 0;
+  uint32_t _sceneVersion = 0;
   
   bool _enableRayCaster = false; // Flag de controle do renderizador ativo.
+  bool _useSoftwareRaster = false;
   bool _resetRequested = false;
 
   // Variáveis de estado para controle de câmera e input.
@@ -98,6 +113,14 @@ private:
   int _dragButton = -1;
   double _lastX = 0.0;
   double _lastY = 0.0;
+
+  // Retângulo de seleção em coordenadas de janela (Top-Left).
+  bool _isRectSelecting = false;
+  int _rectX0 = 0, _rectY0 = 0;
+  int _rectX1 = 0, _rectY1 = 0;
+
+  // Seleciona os atores visíveis no retângulo arrastado pelo usuário.
+  void selectRectangle();
 };
 
 }
\ No newline at end of file
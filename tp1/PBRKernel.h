@@ -0,0 +1,257 @@
+#pragma once
+
+#include "PBRMaterial.h"
+#include "graphics/Color.h"
+#include "math/Vector3.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TP1_SSE 1
+#endif
+
+namespace cg
+{
+
+// Kernel do BRDF Cook-Torrance do RayCaster (GGX, Smith/Schlick-GGX e Fresnel-Schlick).
+// As constantes do material (alfa², k, F0, albedo) são calculadas uma vez por hit em Surface;
+// as luzes que passam no teste de sombra são acumuladas em LightBatch (estrutura de arrays) e
+// avaliadas 4 por vez com SSE, com a potência de Schlick calculada como x²·x²·x.
+// O resultado difere do kernel escalar de referência apenas pela ordem das operações em ponto
+// flutuante: erro por canal abaixo de PBRKernel::tolerance, relativo ao valor de referência (absoluto
+// para valores menores que 1), verificado por tp1 --bench --shading.
+namespace PBRKernel
+{
+
+constexpr float pi = 3.14159265359f;
+constexpr float minSpec = 0.04f; // Reflectância base para dielétricos (F0)
+constexpr float tolerance = 1e-4f;
+constexpr float specEpsilon = 1e-6f;  // Guarda do denominador especular do RayCaster
+constexpr float glslEpsilon = 1e-4f;  // Guarda usada por pbrFragmentShader (PBRRenderer)
+
+// Constantes de shading de um hit.
+struct Surface
+{
+  vec3f N;
+  vec3f V;
+  float NdotV;
+  float a2;        // alfa² (alfa = roughness²)
+  float k;         // Parâmetro de Schlick-GGX
+  float F0[3];
+  float albedo[3]; // Albedo corrigido pela metalicidade
+  float dielectric; // 1 - metalness
+  float epsilon;    // Guarda do denominador 4 (N·V)(N·L) do termo especular
+
+  Surface(const vec3f& normal, const vec3f& view, const PBRMaterial* material, float epsilon = specEpsilon):
+    epsilon{epsilon}
+  {
+    const float m = material->metalness;
+    const float a = material->roughness * material->roughness;
+    const float r1 = material->roughness + 1.0f;
+
+    N = normal.versor();
+    V = view;
+    NdotV = std::max(N.dot(V), 0.0f);
+    a2 = a * a;
+    k = r1 * r1 / 8.0f;
+    dielectric = 1.0f - m;
+    F0[0] = material->Os.r * m + minSpec * dielectric;
+    F0[1] = material->Os.g * m + minSpec * dielectric;
+    F0[2] = material->Os.b * m + minSpec * dielectric;
+    albedo[0] = material->Od.r * dielectric;
+    albedo[1] = material->Od.g * dielectric;
+    albedo[2] = material->Od.b * dielectric;
+  }
+};
+
+// Luzes visíveis de um hit: direção unitária L, N·L > 0 e radiância.
+struct LightBatch
+{
+  static constexpr int capacity = 16; // Múltiplo da largura do lote
+
+  alignas(16) float lx[capacity];
+  alignas(16) float ly[capacity];
+  alignas(16) float lz[capacity];
+  alignas(16) float NdotL[capacity];
+  alignas(16) float r[capacity];
+  alignas(16) float g[capacity];
+  alignas(16) float b[capacity];
+  int count = 0;
+
+  bool full() const { return count == capacity; }
+
+  void add(const vec3f& L, float cosTheta, const Color& radiance)
+  {
+    // Ao iniciar um grupo de 4, zera suas faixas: as excedentes ficam como luzes nulas
+    // (contribuição zero, sem NaN) e o kernel em lote lê sempre grupos completos.
+    if (count % 4 == 0)
+      for (float* lane : {lx, ly, lz, NdotL, r, g, b})
+        std::fill_n(lane + count, 4, 0.0f);
+    lx[count] = L.x;
+    ly[count] = L.y;
+    lz[count] = L.z;
+    NdotL[count] = cosTheta;
+    r[count] = radiance.r;
+    g[count] = radiance.g;
+    b[count] = radiance.b;
+    ++count;
+  }
+};
+
+// Kernel escalar de referência: mesma expressão do RayCaster original, luz a luz, com std::pow.
+inline vec3f evaluateReference(const Surface& s, const LightBatch& lights)
+{
+  const vec3f F0{s.F0[0], s.F0[1], s.F0[2]};
+  const vec3f albedo{s.albedo[0], s.albedo[1], s.albedo[2]};
+  vec3f Lo{0, 0, 0};
+
+  for (int i = 0; i < lights.count; ++i)
+  {
+    const vec3f L{lights.lx[i], lights.ly[i], lights.lz[i]};
+    const float NdotL = lights.NdotL[i];
+    const vec3f H = (s.V + L).versor();
+    const float NdotH = std::max(s.N.dot(H), 0.0f);
+    const float VdotH = std::max(s.V.dot(H), 0.0f);
+
+    // Distribuição Normal (NDF) - Trowbridge-Reitz GGX.
+    const float NdotH2 = NdotH * NdotH;
+    const float denom = (NdotH2 * (s.a2 - 1.0f) + 1.0f);
+    const float D = s.a2 / (pi * denom * denom);
+
+    // Função de Geometria (G) - Smith com aproximação Schlick-GGX.
+    const float G1V = s.NdotV / (s.NdotV * (1.0f - s.k) + s.k);
+    const float G1L = NdotL / (NdotL * (1.0f - s.k) + s.k);
+    const float G = G1V * G1L;
+
+    // Fresnel (F) - Aproximação de Schlick.
+    const vec3f F = F0 + (vec3f{1, 1, 1} - F0) * std::pow(1.0f - VdotH, 5.0f);
+
+    // BRDF Especular (Cook-Torrance) e difuso de Lambert com kD = (1 - kS)(1 - metalness).
+    const vec3f specular = F * (D * G / (4.0f * s.NdotV * NdotL + s.epsilon));
+    const vec3f kD = (vec3f{1, 1, 1} - F) * s.dielectric;
+    const vec3f radiance{lights.r[i], lights.g[i], lights.b[i]};
+
+    Lo += (kD * albedo * (1.0f / pi) + specular) * radiance * NdotL;
+  }
+  return Lo;
+}
+
+#ifdef TP1_SSE
+
+// Soma horizontal das 4 faixas.
+inline float horizontalSum(__m128 v)
+{
+  __m128 t = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+  t = _mm_add_ss(t, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 0, 3, 2)));
+  return _mm_cvtss_f32(t);
+}
+
+// Avalia as luzes do lote 4 a 4.
+inline vec3f evaluate(const Surface& s, const LightBatch& lights)
+{
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 nx = _mm_set1_ps(s.N.x), ny = _mm_set1_ps(s.N.y), nz = _mm_set1_ps(s.N.z);
+  const __m128 vx = _mm_set1_ps(s.V.x), vy = _mm_set1_ps(s.V.y), vz = _mm_set1_ps(s.V.z);
+  const __m128 a2 = _mm_set1_ps(s.a2);
+  const __m128 a2m1 = _mm_set1_ps(s.a2 - 1.0f);
+  const __m128 k = _mm_set1_ps(s.k);
+  const __m128 onemk = _mm_set1_ps(1.0f - s.k);
+  const __m128 G1V = _mm_set1_ps(s.NdotV / (s.NdotV * (1.0f - s.k) + s.k));
+  const __m128 fourNdotV = _mm_set1_ps(4.0f * s.NdotV);
+  const __m128 eps = _mm_set1_ps(s.epsilon);
+  const __m128 dielectric = _mm_set1_ps(s.dielectric);
+  const __m128 piv = _mm_set1_ps(pi);
+  __m128 sum[3] = {zero, zero, zero};
+
+  for (int i = 0; i < lights.count; i += 4)
+  {
+    const __m128 lx = _mm_load_ps(lights.lx + i);
+    const __m128 ly = _mm_load_ps(lights.ly + i);
+    const __m128 lz = _mm_load_ps(lights.lz + i);
+    const __m128 NdotL = _mm_load_ps(lights.NdotL + i);
+
+    // H = (V + L) * (1 / |V + L|), como em versor().
+    __m128 hx = _mm_add_ps(vx, lx);
+    __m128 hy = _mm_add_ps(vy, ly);
+    __m128 hz = _mm_add_ps(vz, lz);
+    const __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(hx, hx), _mm_mul_ps(hy, hy)), _mm_mul_ps(hz, hz)));
+    const __m128 invLen = _mm_div_ps(one, len);
+
+    hx = _mm_mul_ps(hx, invLen);
+    hy = _mm_mul_ps(hy, invLen);
+    hz = _mm_mul_ps(hz, invLen);
+
+    const __m128 NdotH = _mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, hx), _mm_mul_ps(ny, hy)), _mm_mul_ps(nz, hz)), zero);
+    const __m128 VdotH = _mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, hx), _mm_mul_ps(vy, hy)), _mm_mul_ps(vz, hz)), zero);
+
+    // D = a² / (pi (NdotH² (a² - 1) + 1)²).
+    const __m128 denom = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(NdotH, NdotH), a2m1), one);
+    const __m128 D = _mm_div_ps(a2, _mm_mul_ps(piv, _mm_mul_ps(denom, denom)));
+
+    // G = G1(V) G1(L).
+    const __m128 G1L = _mm_div_ps(NdotL, _mm_add_ps(_mm_mul_ps(NdotL, onemk), k));
+    const __m128 G = _mm_mul_ps(G1V, G1L);
+
+    // (1 - VdotH)^5 = x²·x²·x.
+    const __m128 x = _mm_sub_ps(one, VdotH);
+    const __m128 x2 = _mm_mul_ps(x, x);
+    const __m128 x5 = _mm_mul_ps(_mm_mul_ps(x2, x2), x);
+
+    const __m128 spec = _mm_div_ps(_mm_mul_ps(D, G), _mm_add_ps(_mm_mul_ps(fourNdotV, NdotL), eps));
+    const __m128 radiance[3] = {_mm_load_ps(lights.r + i), _mm_load_ps(lights.g + i), _mm_load_ps(lights.b + i)};
+
+    for (int c = 0; c < 3; ++c)
+    {
+      const __m128 F0 = _mm_set1_ps(s.F0[c]);
+      const __m128 F = _mm_add_ps(F0, _mm_mul_ps(_mm_sub_ps(one, F0), x5));
+      const __m128 kD = _mm_mul_ps(_mm_sub_ps(one, F), dielectric);
+      const __m128 diffuse = _mm_div_ps(_mm_mul_ps(kD, _mm_set1_ps(s.albedo[c])), piv);
+      const __m128 brdf = _mm_add_ps(diffuse, _mm_mul_ps(F, spec));
+
+      sum[c] = _mm_add_ps(sum[c], _mm_mul_ps(_mm_mul_ps(brdf, radiance[c]), NdotL));
+    }
+  }
+  return vec3f{horizontalSum(sum[0]), horizontalSum(sum[1]), horizontalSum(sum[2])};
+}
+
+#else
+
+// Sem SSE: kernel escalar com as constantes por hit e a potência de Schlick sem std::pow.
+inline vec3f evaluate(const Surface& s, const LightBatch& lights)
+{
+  const float G1V = s.NdotV / (s.NdotV * (1.0f - s.k) + s.k);
+  float sum[3] = {0, 0, 0};
+
+  for (int i = 0; i < lights.count; ++i)
+  {
+    const vec3f H = (s.V + vec3f{lights.lx[i], lights.ly[i], lights.lz[i]}).versor();
+    const float NdotL = lights.NdotL[i];
+    const float NdotH = std::max(s.N.dot(H), 0.0f);
+    const float VdotH = std::max(s.V.dot(H), 0.0f);
+    const float denom = NdotH * NdotH * (s.a2 - 1.0f) + 1.0f;
+    const float D = s.a2 / (pi * denom * denom);
+    const float G = G1V * NdotL / (NdotL * (1.0f - s.k) + s.k);
+    const float x = 1.0f - VdotH;
+    const float x2 = x * x;
+    const float x5 = x2 * x2 * x;
+    const float spec = D * G / (4.0f * s.NdotV * NdotL + s.epsilon);
+    const float radiance[3] = {lights.r[i], lights.g[i], lights.b[i]};
+
+    for (int c = 0; c < 3; ++c)
+    {
+      const float F = s.F0[c] + (1.0f - s.F0[c]) * x5;
+      const float diffuse = (1.0f - F) * s.dielectric * s.albedo[c] / pi;
+
+      sum[c] += (diffuse + F * spec) * radiance[c] * NdotL;
+    }
+  }
+  return vec3f{sum[0], sum[1], sum[2]};
+}
+
+#endif
+
+} // PBRKernel
+
+}
@@ -210,11 +210,13 @@ PBRRenderer::~PBRRenderer()
 void PBRRenderer::update()
 {
   glViewport(0, 0, _viewport.w, _viewport.h);
+  // Atores visíveis, luzes acesas e fundo do quadro, percorridos sem contagem de referências.
+  _snapshot.capture(*_scene);
 }
 
 void PBRRenderer::beginRender()
 {
-  const auto& bc = _scene->backgroundColor;
+  const auto& bc = _snapshot.background;
   glClearColor(bc.r, bc.g, bc.b, 1.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   _pbrData->program.use();
@@ -231,9 +233,9 @@ void PBRRenderer::renderLights()
   const auto& vm = _camera->worldToCameraMatrix();
   int nl = 0;
   
-  for(auto light : _scene->lights())
+  for(auto light : _snapshot.lights)
   {
-    if(!light->isTurnedOn() || nl >= 3) break;
+    if(nl >= 3) break;
       
     const auto p = vm.transform3x4(light->position());
     
@@ -247,20 +249,15 @@ void PBRRenderer::renderLights()
 
 void PBRRenderer::renderActors()
 {
-  for(auto actor : _scene->actors())
+  for(const auto& entry : _snapshot.actors)
   {
-    if(!actor->isVisible()) continue;
-
-    auto shape = actor->shape();
-    if(shape == nullptr) continue;
-    
-    const auto mesh = shape->mesh(); 
+    const auto mesh = entry.shape->mesh(); 
     if(mesh)
     {
       drawMeshPBR(*mesh, 
-                  *actor->pbrMaterial(), 
-                  actor->transform(),   
-                  actor->normalMatrix() 
+                  *entry.material, 
+                  entry.actor->transform(),   
+                  entry.actor->normalMatrix() 
       );
     }
   }
@@ -2,6 +2,7 @@
 
 #include "graphics/Camera.h"
 #include "Scene.h"
+#include "SceneSnapshot.h"
 #include "PBRMaterial.h"
 #include "geometry/TriangleMesh.h"
 #include "core/Globals.h"
@@ -51,6 +52,7 @@ namespace cg
         Scene* _scene;
         Camera* _camera;
         Viewport _viewport;
+        SceneSnapshot _snapshot;
 
         void update();
         void beginRender();
@@ -0,0 +1,232 @@
+#include "PackedLeaf.h"
+#include "Sphere.h"
+#include "Box.h"
+#include "Plane.h"
+#include "Float4.h"
+#include <algorithm>
+#include <cmath>
+
+namespace cg
+{
+
+using simd::Float4;
+
+PackedPrimitive::PackedPrimitive(PBRActor* actor):
+  actor{actor},
+  p{0, 0, 0}
+{
+  const auto& inv = actor->inverseTransform();
+
+  for (int c = 0; c < 4; ++c)
+  {
+    m[c] = inv[c].x;
+    m[4 + c] = inv[c].y;
+    m[8 + c] = inv[c].z;
+  }
+  if (!actor->isVisible())
+    return;
+
+  const Shape3* shape = actor->shape();
+
+  if (auto sphere = dynamic_cast<const Sphere*>(shape))
+  {
+    kind = Kind::Sphere;
+    p[0] = sphere->radius() * sphere->radius();
+  }
+  else if (auto box = dynamic_cast<const Box*>(shape))
+  {
+    vec3f h = box->size() * 0.5f;
+
+    kind = Kind::Box;
+    p[0] = h.x;
+    p[1] = h.y;
+    p[2] = h.z;
+  }
+  else if (auto plane = dynamic_cast<const Plane*>(shape))
+  {
+    kind = Kind::Plane;
+    p[0] = plane->width() / 2.0f;
+    p[1] = plane->height() / 2.0f;
+  }
+}
+
+void PackedLeaf::pack(const PackedPrimitive* prims, int count)
+{
+  using Kind = PackedPrimitive::Kind;
+
+  _groups.clear();
+  for (Kind kind : {Kind::Sphere, Kind::Box, Kind::Plane, Kind::Generic})
+  {
+    Group* g = nullptr;
+
+    for (int i = 0; i < count; ++i)
+    {
+      if (prims[i].kind != kind)
+        continue;
+      if (g == nullptr || g->count == width)
+      {
+        g = &_groups.emplace_back();
+        g->count = 0;
+        g->kind = kind;
+
+        // Faixas vazias: matriz nula (direção local nula, nenhum hit).
+        for (auto& row : g->m)
+          std::fill_n(row, width, 0.0f);
+        for (auto& row : g->p)
+          std::fill_n(row, width, 0.0f);
+      }
+
+      int lane = g->count++;
+
+      for (int k = 0; k < 12; ++k)
+        g->m[k][lane] = prims[i].m[k];
+      for (int k = 0; k < 3; ++k)
+        g->p[k][lane] = prims[i].p[k];
+      g->actors[lane] = prims[i].actor;
+    }
+  }
+}
+
+int PackedLeaf::unpack(PackedPrimitive* prims) const
+{
+  int n = 0;
+
+  for (const auto& g : _groups)
+    for (int lane = 0; lane < g.count; ++lane, ++n)
+    {
+      prims[n].actor = g.actors[lane];
+      prims[n].kind = g.kind;
+      for (int k = 0; k < 12; ++k)
+        prims[n].m[k] = g.m[k][lane];
+      for (int k = 0; k < 3; ++k)
+        prims[n].p[k] = g.p[k][lane];
+    }
+  return n;
+}
+
+bool PackedLeaf::intersect(Ray3f& ray, Intersection& hit) const
+{
+  const vec3f& O = ray.origin;
+  const vec3f& D = ray.direction;
+  const float length = D.length();
+  bool found = false;
+
+  for (const auto& g : _groups)
+  {
+    if (g.kind == PackedPrimitive::Kind::Generic)
+    {
+      for (int i = 0; i < g.count; ++i)
+      {
+        Intersection h;
+
+        h.distance = ray.tMax;
+        if (g.actors[i]->intersect(ray, h) && h.distance < ray.tMax)
+        {
+          ray.tMax = h.distance;
+          hit.object = h.object;
+          hit.distance = h.distance;
+          found = true;
+        }
+      }
+      continue;
+    }
+
+    Float4 m[12];
+
+    for (int k = 0; k < 12; ++k)
+      m[k] = Float4::load(g.m[k]);
+
+    // Raio no espaço local de cada ator: origem transformada e direção normalizada.
+    Float4 ox = m[0] * O.x + m[1] * O.y + m[2] * O.z + m[3];
+    Float4 oy = m[4] * O.x + m[5] * O.y + m[6] * O.z + m[7];
+    Float4 oz = m[8] * O.x + m[9] * O.y + m[10] * O.z + m[11];
+    Float4 dx = m[0] * D.x + m[1] * D.y + m[2] * D.z;
+    Float4 dy = m[4] * D.x + m[5] * D.y + m[6] * D.z;
+    Float4 dz = m[8] * D.x + m[9] * D.y + m[10] * D.z;
+    Float4 invLength = Float4{1.0f} / sqrt(dx * dx + dy * dy + dz * dz);
+
+    dx = dx * invLength;
+    dy = dy * invLength;
+    dz = dz * invLength;
+
+    const Float4 zero{0.0f};
+    const Float4 tMax{ray.tMax};
+    Float4 t;
+    Float4 valid;
+
+    switch (g.kind)
+    {
+      case PackedPrimitive::Kind::Sphere:
+      {
+        // Equação quadrática, como em Sphere::intersect.
+        Float4 a = dx * dx + dy * dy + dz * dz;
+        Float4 b = Float4{2.0f} * (ox * dx + oy * dy + oz * dz);
+        Float4 c = ox * ox + oy * oy + oz * oz - Float4::load(g.p[0]);
+        Float4 disc = b * b - Float4{4.0f} * a * c;
+        Float4 s = sqrt(max(disc, zero));
+        Float4 twoA = Float4{2.0f} * a;
+        Float4 t1 = (zero - b - s) / twoA;
+        Float4 t2 = (zero - b + s) / twoA;
+
+        t = select(t1 > zero, t1, t2);
+        valid = disc >= zero;
+        break;
+      }
+      case PackedPrimitive::Kind::Box:
+      {
+        // Slabs da caixa centrada na origem, recortadas por [tMin, tMax] como em Bounds3::intersect.
+        const Float4 o[3] = {ox, oy, oz};
+        const Float4 d[3] = {dx, dy, dz};
+        Float4 tNear{ray.tMin};
+        Float4 tFar = tMax;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          Float4 h = Float4::load(g.p[axis]);
+          Float4 inv = Float4{1.0f} / d[axis];
+          Float4 t0 = (zero - h - o[axis]) * inv;
+          Float4 t1 = (h - o[axis]) * inv;
+
+          tNear = max(tNear, min(t0, t1));
+          tFar = min(tFar, max(t0, t1));
+        }
+        t = select(tNear > zero, tNear, tFar);
+        valid = tNear <= tFar;
+        break;
+      }
+      default:
+      {
+        // Plano y = 0 limitado por largura e altura, como em Plane::intersect.
+        t = (zero - oy) / dy;
+        valid = (abs(dy) >= Float4{1e-6f})
+              & (abs(ox + dx * t) <= Float4::load(g.p[0]))
+              & (abs(oz + dz * t) <= Float4::load(g.p[1]));
+      }
+    }
+
+    // Limites em coordenadas locais e no mundo (PBRActor::intersect).
+    Float4 distance = t * (Float4{length} * invLength);
+
+    valid = valid & (t > zero) & (t < tMax) & (distance < tMax) & (distance > Float4{ray.tMin});
+
+    int mask = bits(valid) & ((1 << g.count) - 1);
+
+    if (mask == 0)
+      continue;
+
+    alignas(16) float d[width];
+
+    distance.store(d);
+    for (int i = 0; i < g.count; ++i)
+      if ((mask >> i & 1) && d[i] < ray.tMax)
+      {
+        ray.tMax = d[i];
+        hit.object = g.actors[i];
+        hit.distance = d[i];
+        found = true;
+      }
+  }
+  return found;
+}
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "PBRActor.h"
+#include "geometry/Ray.h"
+#include "geometry/Intersection.h"
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{
+
+// Forma analítica de um ator preparada para a interseção em lote: tipo da forma, linhas da
+// transformação inversa (3x4) e parâmetros da forma. É copiada do ator na thread principal,
+// de modo que reconstruções da BVH em segundo plano não leiam atores em edição.
+struct PackedPrimitive
+{
+  enum class Kind : uint8_t
+  {
+    Sphere,  // p = {raio²}
+    Box,     // p = {meia largura, meia altura, meia profundidade}
+    Plane,   // p = {meia largura, meia altura}
+    Generic  // Outras formas ou ator invisível: interseção pelo próprio ator
+  };
+
+  PBRActor* actor = nullptr;
+  Kind kind = Kind::Generic;
+  float m[12]; // Inversa da transformação, por linhas
+  float p[3];
+
+  PackedPrimitive() = default;
+
+  explicit PackedPrimitive(PBRActor* actor);
+};
+
+// Folha da BVH empacotada: os atores são agrupados por tipo de forma em grupos de 4, com
+// transformações e parâmetros em arrays SoA. Cada grupo é intersectado por um único kernel
+// SIMD do tipo (SSE quando disponível), sem chamadas virtuais nem leitura das matrizes dos atores.
+// O kernel reproduz PBRActor::intersect: raio local com direção normalizada, teste analítico
+// da forma e distância no mundo dada pelo fator de escala |D| / |M^-1 D|.
+class PackedLeaf
+{
+public:
+  static constexpr int width = 4;
+
+  // Reempacota a folha com as primitivas dadas.
+  void pack(const PackedPrimitive* prims, int count);
+
+  // Copia as primitivas empacotadas para prims; retorna o número de atores.
+  int unpack(PackedPrimitive* prims) const;
+
+  // Interseção do raio com os atores da folha; em um hit mais próximo, atualiza hit e ray.tMax.
+  bool intersect(Ray3f& ray, Intersection& hit) const;
+
+private:
+  struct Group
+  {
+    alignas(16) float m[12][width];
+    alignas(16) float p[3][width];
+    PBRActor* actors[width];
+    int count;
+    PackedPrimitive::Kind kind;
+  };
+
+  std::vector<Group> _groups;
+};
+
+}
@@ -13,9 +13,11 @@ public:
     _height{height},
     _normal{0, 1, 0} // Normal padrão orientada para +y.
   {
-    generateMesh();
   }
 
+  float width() const { return _width; }
+  float height() const { return _height; }
+
   // Retorna a normal constante da superfície plana.
   vec3f normalAt(const vec3f& P) const override
   {
@@ -59,7 +61,7 @@ private:
   float _width, _height;
   vec3f _normal = {0.0f, 1.0f, 0.0f};
 
-  void generateMesh() override
+  TriangleMesh* generateMesh() const override
   {
     const int vertexCount = 8;
     const int triangleCount = 4;
@@ -104,7 +106,7 @@ private:
       triangles
     };
 
-    _mesh = new TriangleMesh{std::move(data)};
+    return new TriangleMesh{std::move(data)};
   }
 
 };
@@ -1,34 +1,101 @@
 #include "RayCaster.h"
+#include "PBRKernel.h"
+#include "TraceRecorder.h"
 #include "graphics/Light.h"
 #include <cmath>
 #include <limits>
 #include <thread>
 #include <vector>
 #include <atomic>
+#include <algorithm>
+#include <chrono>
 
 namespace cg
 {
 
 constexpr float PI = 3.14159265359f;
-constexpr float MIN_SPEC = 0.04f; // Reflectância base para dielétricos (F0)
 constexpr float EPSILON = 1e-4f;  // Bias para evitar auto-interseção (Shadow Acne)
 
+// Soma ao mapa de custo, no fim do escopo, os contadores e o tempo gasto no pixel (x, y).
+// Sem mapa, counters() é nulo e nada é medido.
+class PixelCost
+{
+public:
+  PixelCost(CostMap* map, int x, int y):
+    _map{map},
+    _x{x},
+    _y{y}
+  {
+    if (_map != nullptr)
+      _start = std::chrono::steady_clock::now();
+  }
+
+  ~PixelCost()
+  {
+    if (_map != nullptr)
+    {
+      std::chrono::duration<float, std::nano> t = std::chrono::steady_clock::now() - _start;
+      _map->add(_x, _y, _counters, t.count());
+    }
+  }
+
+  CostMap::Counters* counters() { return _map != nullptr ? &_counters : nullptr; }
+
+private:
+  CostMap* _map;
+  int _x, _y;
+  CostMap::Counters _counters;
+  std::chrono::steady_clock::time_point _start;
+};
+
 void RayCaster::buildBVH()
 {
-  std::vector<Reference<PBRActor>> actors;
+  std::vector<PBRActor*> actors;
   
-  for (auto actor : _scene->actors())
+  for (const auto& actor : _scene->actors())
   {
     if (actor->isVisible())
       actors.push_back(actor);
   }
   
-  if (!actors.empty())
-  {
-    // Inicializa BVH.
-    _bvh = new BVH<PBRActor>{std::move(actors), 8, BVHBase::SplitMethod::SAH};
-    auto bounds = _bvh->bounds();
-  }
+  // Inicializa BVH.
+  CG_PROFILE_SCOPE(_profiler, Profiler::BVHBuild);
+  CG_TRACE_SCOPE("BVH build", "scene", "actors", (int64_t)actors.size());
+  _bvh.build(actors);
+}
+
+void RayCaster::updateActor(PBRActor* actor)
+{
+  if (actor == nullptr)
+    return;
+  touch();
+
+  CG_PROFILE_SCOPE(_profiler, Profiler::BVHBuild);
+  if (!actor->isVisible())
+    _bvh.remove(actor);
+  else if (_bvh.contains(actor))
+    _bvh.update(actor);
+  else
+    _bvh.insert(actor);
+}
+
+void RayCaster::addActor(PBRActor* actor)
+{
+  if (actor == nullptr)
+    return;
+  touch();
+
+  CG_PROFILE_SCOPE(_profiler, Profiler::BVHBuild);
+  if (actor->isVisible())
+    _bvh.insert(actor);
+}
+
+void RayCaster::removeActor(PBRActor* actor)
+{
+  touch();
+
+  CG_PROFILE_SCOPE(_profiler, Profiler::BVHBuild);
+  _bvh.remove(actor);
 }
 
 // Gera o raio primário a partir da câmera para as coordenadas de pixel (x, y).
@@ -82,29 +149,29 @@ vec3f RayCaster::imageToWindow(float x, float y) const
 }
 
 // Realiza o teste de interseção do raio com a cena.
-bool RayCaster::intersect(const Ray3f& ray, Intersection& hit)
+bool RayCaster::intersect(const Ray3f& ray, Intersection& hit, CostMap::Counters* cost)
 {
   hit.object = nullptr;
   hit.distance = ray.tMax;
   
-  if (!_bvh || _bvh->empty())
+  if (_bvh.empty())
     return false;
   
   // Tentativa de interseção via BVH.
-  bool found = _bvh->intersect(ray, hit);
+  bool found = _bvh.intersect(ray, hit, cost);
   
-  if (!found && _bruteIntersect) // Deixei _bruteforce configurado em true (sinceramente não é ideal mas pra isso aq ta ok)
+  if (!found && _bruteIntersect) // A BVH acompanha as edições da cena; a busca linear fica só para depuração.
   {
-    // Fallback: Busca linear para garantir robustez caso o BVH falhe ou não cubra objetos dinâmicos.
+    // Fallback: Busca linear (O(N) por raio que não atinge nada).
     PBRActor* closestActor = nullptr;
     float closestDistance = ray.tMax;
 
-    for (const auto& actorRef : _scene->actors())
-    {
-      PBRActor* actor = actorRef.get();
+    if (cost != nullptr)
+      cost->primitives += (uint32_t)_snapshot.actors.size();
 
-      if (!actor->isVisible())
-        continue;
+    for (const auto& entry : _snapshot.actors)
+    {
+      PBRActor* actor = entry.actor;
       
       Intersection tempHit;
       tempHit.distance = closestDistance;
@@ -130,32 +197,25 @@ bool RayCaster::intersect(const Ray3f& ray, Intersection& hit)
 }
 
 // Implementação do modelo de iluminação PBR.
-Color RayCaster::calculatePBR(const vec3f& P, const vec3f& N, const PBRMaterial* material)
+// As constantes do material são calculadas uma vez por hit; o BRDF das luzes visíveis é avaliado em lotes.
+Color RayCaster::calculatePBR(const vec3f& P, const vec3f& N, const PBRMaterial* material,
+  CostMap::Counters* cost)
 {
-  vec3f V = (_camera->position() - P).versor(); // Vetor View
-  vec3f normal = N.versor();
-  
-  // Cálculo da refletância base (F0).
-  vec3f F0 = vec3f{material->Os.r, material->Os.g, material->Os.b} * material->metalness + vec3f{MIN_SPEC, MIN_SPEC, MIN_SPEC} * (1.0f - material->metalness);
-  
-  // Albedo corrigido pela metalicidade.
-  vec3f albedo = vec3f{material->Od.r, material->Od.g, material->Od.b} * (1.0f - material->metalness);
-  
-  Color Lo{0, 0, 0};
+  // V: posição da câmera no início do quadro.
+  PBRKernel::Surface surface{N, (_eye - P).versor(), material};
+  PBRKernel::LightBatch lights;
+  vec3f Lo{0, 0, 0};
   
   // Integração da contribuição das luzes analíticas.
-  for (const auto& light : _scene->lights())
+  for (auto light : _snapshot.lights)
   {
-    if (!light->isTurnedOn())
-      continue;
-    
     vec3f L; // Vetor Light
     float d;
     
     if (!light->lightVector(P, L, d))
       continue;
     
-    float NdotL = normal.dot(L);
+    float NdotL = surface.N.dot(L);
     if (NdotL <= 0)
       continue;
     
@@ -164,118 +224,92 @@ Color RayCaster::calculatePBR(const vec3f& P, const vec3f& N, const PBRMaterial*
     shadowRay.tMax = d;
     
     Intersection shadowHit;
-    if (intersect(shadowRay, shadowHit))
+    bool occluded;
+    {
+      CG_PROFILE_SAMPLED_SCOPE(_profiler, Profiler::ShadowTraversal);
+      occluded = intersect(shadowRay, shadowHit, cost);
+    }
+    if (cost != nullptr)
+      ++cost->rays;
+    if (occluded)
       continue; // Ponto ocluído.
     
-    Color radiance = light->lightColor(d);
-    
-    // Vetor Halfway (H) para o modelo de microfacetas.
-    vec3f H = (V + L).versor();
-    float NdotV = std::max(normal.dot(V), 0.0f);
-    float NdotH = std::max(normal.dot(H), 0.0f);
-    float VdotH = std::max(V.dot(H), 0.0f);
-    
-    // Parâmetro de rugosidade alfa.
-    float a = material->roughness * material->roughness;
-    float a2 = a * a;
-    
-    // Distribuição Normal (NDF) - Trowbridge-Reitz GGX.
-    float NdotH2 = NdotH * NdotH;
-    float denom = (NdotH2 * (a2 - 1.0f) + 1.0f);
-    float D = a2 / (PI * denom * denom);
-    
-    // Função de Geometria (G) - Smith com aproximação Schlick-GGX.
-    float k = (material->roughness + 1.0f) * (material->roughness + 1.0f) / 8.0f;
-    float G1V = NdotV / (NdotV * (1.0f - k) + k);
-    float G1L = NdotL / (NdotL * (1.0f - k) + k);
-    float G = G1V * G1L;
-    
-    // Fresnel (F) - Aproximação de Schlick.
-    vec3f F = F0 + (vec3f{1, 1, 1} - F0) * std::pow(1.0f - VdotH, 5.0f);
-    
-    // BRDF Especular (Cook-Torrance).
-    float denomSpec = 4.0f * NdotV * NdotL + 1e-6f; 
-    vec3f specular = F * (D * G / denomSpec);
-    
-    // Conservação de energia: kD + kS = 1.
-    vec3f kS = F;
-    vec3f kD = (vec3f{1, 1, 1} - kS) * (1.0f - material->metalness);
-    
-    // Equação de renderização final para esta luz.
-    vec3f radianceVec = vec3f{radiance.r, radiance.g, radiance.b};
-    vec3f diffuseTerm = kD * albedo * (1.0f / PI); // Lambertian Diffuse.
-    vec3f contribution = (diffuseTerm + specular) * radianceVec * NdotL;
-    
-    Lo.r += contribution.x;
-    Lo.g += contribution.y;
-    Lo.b += contribution.z;
+    lights.add(L, NdotL, light->lightColor(d));
+    if (lights.full())
+    {
+      Lo += PBRKernel::evaluate(surface, lights);
+      lights.count = 0;
+    }
   }
+  if (lights.count > 0)
+    Lo += PBRKernel::evaluate(surface, lights);
   
   // Termo de luz ambiente simples (substituto para IBL/Global Illumination).
-  vec3f ambient = vec3f{0.03f, 0.03f, 0.03f} * albedo;
-  Lo.r += ambient.x;
-  Lo.g += ambient.y;
-  Lo.b += ambient.z;
+  Lo += vec3f{surface.albedo[0], surface.albedo[1], surface.albedo[2]} * 0.03f;
   
-  return Lo;
+  return Color{Lo.x, Lo.y, Lo.z};
 }
 
 // Determina a cor de um ponto dado uma interseção (Cálculo de Shading).
-Color RayCaster::shade(const Ray3f& ray, const Intersection& hit)
+Color RayCaster::shade(const Ray3f& ray, const Intersection& hit, vec3f* normal, CostMap::Counters* cost)
 {
   auto actor = (PBRActor*)hit.object;
-  if (actor == nullptr)
+  if (actor == nullptr || actor->shape() == nullptr)
     return background();
   
   vec3f P = ray(hit.distance);
+  vec3f N = surfaceNormal(actor, P);
+
+  if (normal != nullptr)
+    *normal = N;
   
-  auto shape = actor->shape();
-  if (shape == nullptr)
-    return background();
+  const auto * material = actor->pbrMaterial();
   
+  return calculatePBR(P, N, material, cost);
+}
+
+// Normal em espaço do mundo no ponto P da superfície do ator.
+vec3f RayCaster::surfaceNormal(const PBRActor* actor, const vec3f& P) const
+{
   // Transformação Espaço Mundo -> Espaço Objeto.
   const auto& invTransform = actor->inverseTransform();
   vec3f localP = invTransform.transform3x4(P);
   
-  vec3f localN = shape->normalAt(localP);
+  vec3f localN = actor->shape()->normalAt(localP);
   
   // Transformação da normal usando a Matriz Normal (Transposta da Inversa).
   const auto& normalMatrix = actor->normalMatrix();
-  vec3f N = vec3f{
+  return vec3f{
     normalMatrix[0].dot(localN),
     normalMatrix[1].dot(localN),
     normalMatrix[2].dot(localN)
   }.versor();
-  
-  const auto * material = actor->pbrMaterial();
-  
-  return calculatePBR(P, N, material);
 }
 
 Color RayCaster::background() const
 {
-  return _scene->backgroundColor;
+  return _snapshot.background;
 }
 
-// Loop principal de renderização paralelizado.
-void RayCaster::renderImage(Camera* camera, Image* image)
+RayCaster::View RayCaster::makeView(Camera* camera) const
 {
-    if (!camera || !image) return;
-    
-    _camera = camera;
-    const int W = _viewport.w;
-    const int H = _viewport.h;
-    if (W <= 0 || H <= 0) return;
-    
+    View view;
+
+    view.w = _viewport.w;
+    view.h = _viewport.h;
+    view.timestamp = camera->timestamp();
+
     // Câmera
-    const vec3f camPos   = _camera->position();
-    const mat4f& camMat  = _camera->cameraToWorldMatrix();
+    const vec3f camPos   = camera->position();
+    const mat4f& camMat  = camera->cameraToWorldMatrix();
     const vec3f camRight = vec3f{camMat[0].x, camMat[0].y, camMat[0].z};
     const vec3f camUp    = vec3f{camMat[1].x, camMat[1].y, camMat[1].z};
     const vec3f camFwd   = vec3f{camMat[2].x, camMat[2].y, camMat[2].z};
+    const int W = view.w;
+    const int H = view.h;
 
     // Cálculos de Viewport e Aspect Ratio
-    float winHeight = _camera->windowHeight();
+    float winHeight = camera->windowHeight();
     float aspect = (float)W / (float)H;
     float winWidth = winHeight * aspect; 
 
@@ -288,37 +322,112 @@ void RayCaster::renderImage(Camera* camera, Image* image)
         pixelHeightWorld = (winWidth / aspect) / H;
     }
 
-    const vec3f deltaU = camRight * pixelWidthWorld;
-    const vec3f deltaV = camUp * pixelHeightWorld;
-    const vec3f viewDir = -camFwd; 
+    view.deltaU = camRight * pixelWidthWorld;
+    view.deltaV = camUp * pixelHeightWorld;
+    view.viewDir = -camFwd; 
+    view.eye = camPos;
     
     // Define centro do plano de visão
     vec3f viewPlaneCenter;
-    if (_camera->projectionType() == Camera::Perspective)
-        viewPlaneCenter = camPos + (viewDir * _camera->nearPlane());
+    if (camera->projectionType() == Camera::Perspective)
+        viewPlaneCenter = camPos + (view.viewDir * camera->nearPlane());
     else
-        viewPlaneCenter = camPos + (viewDir * 1.0f);
+        viewPlaneCenter = camPos + (view.viewDir * 1.0f);
 
-    const vec3f topLeftPixelCenter = viewPlaneCenter 
-                                   - (camRight * (pixelWidthWorld * W * 0.5f)) 
-                                   - (camUp * (pixelHeightWorld * H * 0.5f))
-                                   + (deltaU * 0.5f) + (deltaV * 0.5f);
+    view.topLeft = viewPlaneCenter 
+                 - (camRight * (pixelWidthWorld * W * 0.5f)) 
+                 - (camUp * (pixelHeightWorld * H * 0.5f))
+                 + (view.deltaU * 0.5f) + (view.deltaV * 0.5f);
 
-    float clipF, clipB;
-    _camera->clippingPlanes(clipF, clipB);
-    
-    const bool isOrthoProjection = (_camera->projectionType() == Camera::Parallel);
+    camera->clippingPlanes(view.clipF, view.clipB);
+    view.ortho = (camera->projectionType() == Camera::Parallel);
+    return view;
+}
+
+// Loop principal de renderização paralelizado.
+// Com step > 1, traça um raio pelo centro de cada bloco de step x step pixels e replica a cor no bloco.
+bool RayCaster::trace(const View& view, int step, Frame& frame)
+{
+    const int W = view.w;
+    const int H = view.h;
+    const vec3f& camPos = view.eye;
+    const vec3f& viewDir = view.viewDir;
+    const vec3f& deltaU = view.deltaU;
+    const vec3f& deltaV = view.deltaV;
+    const vec3f& topLeftPixelCenter = view.topLeft;
+    const float clipF = view.clipF;
+    const float clipB = view.clipB;
+
+    _eye = camPos;
 
     // Setup de Concorrência ---
     const unsigned int hw = std::thread::hardware_concurrency();
-    const int numThreads = std::max(1u, hw ? hw : 1u);
-    const int linesPerThread = std::max(1, H / numThreads);
+    const int rows = (H + step - 1) / step;
+    // Nunca mais threads que linhas de blocos: cada thread recebe ao menos uma linha.
+    const int numThreads = std::max(1, std::min((int)hw, rows));
     
-    ImageBuffer framebuffer(W, H);
-    std::atomic<bool> cancelFlag{ false };
+    frame.step = step;
+    frame.view = view;
+    frame.reused = 0;
+    frame.edges = 0;
+    frame.pixels = std::make_unique<ImageBuffer>(W, H);
+    ImageBuffer& framebuffer = *frame.pixels;
+
+    // Buffers de ID/profundidade do quadro (apenas em resolução completa).
+    // O antialiasing também precisa da normal de cada pixel para detectar as bordas.
+    const bool antialiasing = _aaSamples > 1 && step == 1;
+    const bool writeIds = (_idBufferEnabled || _reprojection || antialiasing) && step == 1;
+    std::vector<vec3f> normals;
+    frame.ids.clear();
+    frame.depth.clear();
+    if (writeIds)
+    {
+        frame.ids.assign((size_t)W * H, nullptr);
+        frame.depth.assign((size_t)W * H, std::numeric_limits<float>::infinity());
+    }
+    if (antialiasing)
+        normals.assign((size_t)W * H, vec3f{0, 0, 0});
+
+    // Mapa de custo por pixel (apenas em resolução completa).
+    const bool costing = _costMapEnabled && step == 1;
+    frame.cost.resize(costing ? W : 0, costing ? H : 0);
+    CostMap* cost = costing ? &frame.cost : nullptr;
+
+    // Reprojeção do último quadro completo (pixel de origem e profundidade esperada por pixel).
+    std::vector<int> source;
+    std::vector<float> sourceDepth;
+    const bool reuse = writeIds && _reprojection && reproject(view, source, sourceDepth);
+    const vec3f oldEye = _idBuffer.view.eye;
+    const float cosTolerance = std::cos(_reprojectionTolerance * PI / 180.0f);
+    std::atomic<int> reusedTotal{0};
+
+    // A vizinhança 3x3 reprojetada deve pertencer ao mesmo ator (rejeita silhuetas e oclusões).
+    auto neighborsAgree = [&](int x, int y, const PBRActor* actor)
+    {
+        int present = 0;
+
+        for (int dy = -1; dy <= 1; ++dy)
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                const int nx = x + dx;
+                const int ny = y + dy;
+
+                if ((dx == 0 && dy == 0) || nx < 0 || ny < 0 || nx >= W || ny >= H)
+                    continue;
+
+                const int s = source[(size_t)ny * W + nx];
+
+                if (s < 0)
+                    continue;
+                if (_idBuffer.actors[s] != actor)
+                    return false;
+                ++present;
+            }
+        return present >= 4;
+    };
 
     // Kernel de Renderização
-    auto renderLoop = [&](auto IsOrthoTag, int y0, int y1) 
+    auto renderLoop = [&](auto IsOrthoTag, int r0, int r1) 
     {
         constexpr bool IsOrtho = decltype(IsOrthoTag)::value;
 
@@ -330,64 +439,544 @@ void RayCaster::renderImage(Camera* camera, Image* image)
         if constexpr (!IsOrtho) ray.origin = camPos; // Se for Perspectiva, a origem é constante.
         if constexpr (IsOrtho)  ray.direction = viewDir; // Se for Orto, a direção é constante.
 
-        for (int y = y0; y < y1; ++y)
+        int reused = 0;
+
+        for (int r = r0; r < r1; ++r)
         {
-            if (cancelFlag.load(std::memory_order_relaxed)) return;
+            if (_cancelFlag.load(std::memory_order_relaxed)) break;
 
-            const vec3f rowStart = topLeftPixelCenter + (deltaV * (float)y);
+            // Um escopo por linha de blocos; os estágios dos raios são cronometrados em uma amostra dos pixels.
+            CG_PROFILE_SCOPE(_profiler, Profiler::Render);
+            const int y0 = r * step;
+            const int y1 = std::min(y0 + step, H);
+            const int sy = std::min(y0 + step / 2, H - 1); // Linha amostrada do bloco
+            const vec3f rowStart = topLeftPixelCenter + (deltaV * (float)sy);
 
-            for (int x = 0; x < W; ++x)
+            for (int x0 = 0; x0 < W; x0 += step)
             {
-                // Cálculo do pixel no mundo
-                const vec3f pixelWorldPos = rowStart + (deltaU * (float)x);
+                CG_PROFILE_PIXEL(_profiler);
+                const int x1 = std::min(x0 + step, W);
+                const int sx = std::min(x0 + step / 2, W - 1);
+                PixelCost pixelCost{cost, x0, y0};
+                CostMap::Counters* counters = pixelCost.counters();
+
+                if (counters != nullptr)
+                    counters->samples = counters->rays = 1;
+
+                {
+                    CG_PROFILE_SAMPLED_SCOPE(_profiler, Profiler::RayGeneration);
+
+                    // Cálculo do pixel no mundo
+                    const vec3f pixelWorldPos = rowStart + (deltaU * (float)sx);
 
-                if constexpr (!IsOrtho) // Perspectiva: Direção varia, Origem fixa
-                  ray.direction = (pixelWorldPos - camPos).versor();
-                else // Ortográfica: Origem varia, Direção fixa
-                    ray.origin = pixelWorldPos;
+                    if constexpr (!IsOrtho) // Perspectiva: Direção varia, Origem fixa
+                      ray.direction = (pixelWorldPos - camPos).versor();
+                    else // Ortográfica: Origem varia, Direção fixa
+                        ray.origin = pixelWorldPos;
+                }
 
                 hit.object = nullptr;
                 hit.distance = ray.tMax;
                 
+                bool found;
+                {
+                    CG_PROFILE_SAMPLED_SCOPE(_profiler, Profiler::PrimaryTraversal);
+                    found = intersect(ray, hit, counters);
+                }
+
+                // Reaproveitamento da cor do quadro anterior (step == 1): o raio novo percorre a cena
+                // inteira e a cor só é reaproveitada se ele atinge o ator em cache na profundidade
+                // reprojetada; economiza o shading e os raios de sombra do pixel.
+                if (reuse && found)
+                {
+                    const size_t j = (size_t)y0 * W + x0;
+                    const int src = source[j];
+                    PBRActor* actor = (PBRActor*)hit.object;
+
+                    if (src >= 0 && _idBuffer.actors[src] == actor && neighborsAgree(x0, y0, actor)
+                        && std::abs(hit.distance - sourceDepth[j]) <= 0.02f * hit.distance + 1e-3f)
+                    {
+                        const vec3f P = ray(hit.distance);
+
+                        if ((oldEye - P).versor().dot((camPos - P).versor()) >= cosTolerance)
+                        {
+                            framebuffer(x0, y0) = (*_idBuffer.pixels)(src % W, src / W);
+                            frame.ids[j] = actor;
+                            frame.depth[j] = hit.distance;
+                            if (antialiasing)
+                                normals[j] = surfaceNormal(actor, P);
+                            ++reused;
+                            continue;
+                        }
+                    }
+                }
+
                 Color finalColor = background();
-                if (intersect(ray, hit))
-                    finalColor = shade(ray, hit);
+                if (found)
+                {
+                    const size_t j = (size_t)y0 * W + x0;
+
+                    CG_PROFILE_SAMPLED_SCOPE(_profiler, Profiler::Shading);
+                    finalColor = shade(ray, hit, antialiasing ? &normals[j] : nullptr, counters);
+
+                    if (writeIds)
+                    {
+                        frame.ids[j] = (PBRActor*)hit.object;
+                        frame.depth[j] = hit.distance;
+                    }
+                }
                 
-                framebuffer(x, y).set(clampColor(finalColor));
+                finalColor = clampColor(finalColor);
+                for (int y = y0; y < y1; ++y)
+                    for (int x = x0; x < x1; ++x)
+                        framebuffer(x, y).set(finalColor);
             }
         }
+        reusedTotal += reused;
     };
 
     // Dispatch
-    auto worker = [&](int y0, int y1) {
-        if (isOrthoProjection)
-            renderLoop(std::true_type{}, y0, y1);  // Instancia versão Orto
+    auto worker = [&](int r0, int r1) {
+        CG_TRACE_SCOPE("rows", "render", "y0", r0 * step, "y1", std::min(r1 * step, H));
+        if (view.ortho)
+            renderLoop(std::true_type{}, r0, r1);  // Instancia versão Orto
         else
-            renderLoop(std::false_type{}, y0, y1); // Instancia versão Perspectiva
+            renderLoop(std::false_type{}, r0, r1); // Instancia versão Perspectiva
     };
 
     std::vector<std::thread> threads;
     for (int i = 0; i < numThreads; ++i) {
-        int y0 = i * linesPerThread;
-        int y1 = (i == numThreads - 1) ? H : y0 + linesPerThread;
-        threads.emplace_back(worker, y0, y1);
+        int r0 = rows * i / numThreads;
+        int r1 = rows * (i + 1) / numThreads;
+        threads.emplace_back(worker, r0, r1);
     }
 
     for (auto& t : threads)
         if (t.joinable()) t.join();
 
-    if (!cancelFlag.load()) image->setData(framebuffer);
+    frame.reused = reusedTotal.load();
+    if (antialiasing && !_cancelFlag.load())
+        frame.edges = antialias(view, normals, frame);
+    return !_cancelFlag.load();
 }
 
-// Executa seleção de objetos via Ray Casting (Picking).
+// Antialiasing guiado por ID: um pixel é de borda quando o ator ou a normal difere de um vizinho
+// (horizontal ou vertical). Apenas esses pixels são reamostrados com _aaSamples raios estratificados
+// (pontos de Hammersley no pixel) e recebem a média das amostras; os demais mantêm a amostra central.
+int RayCaster::antialias(const View& view, const std::vector<vec3f>& normals, Frame& frame)
+{
+    const int W = view.w;
+    const int H = view.h;
+    const auto& ids = frame.ids;
+    std::vector<uint8_t> mask((size_t)W * H, 0);
+
+    auto differs = [&](size_t a, size_t b)
+    {
+        if (ids[a] != ids[b])
+            return true;
+        return ids[a] != nullptr && normals[a].dot(normals[b]) < edgeNormalCos;
+    };
+
+    for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+        {
+            const size_t i = (size_t)y * W + x;
+
+            if (x + 1 < W && differs(i, i + 1))
+                mask[i] = mask[i + 1] = 1;
+            if (y + 1 < H && differs(i, i + W))
+                mask[i] = mask[i + W] = 1;
+        }
+
+    std::vector<int> edges;
+
+    for (size_t i = 0; i < mask.size(); ++i)
+        if (mask[i])
+            edges.push_back((int)i);
+    if (edges.empty())
+        return 0;
+
+    // Posições das amostras no pixel: x estratificado, y pelo inverso radical na base 2.
+    const int n = _aaSamples;
+    float offsetU[maxAASamples];
+    float offsetV[maxAASamples];
+
+    for (int k = 0; k < n; ++k)
+    {
+        uint32_t bits = (uint32_t)k;
+
+        bits = (bits << 16) | (bits >> 16);
+        bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+        bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+        bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+        bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+        offsetU[k] = (k + 0.5f) / n - 0.5f;
+        offsetV[k] = std::fmod(bits * 2.3283064365386963e-10f + 0.5f / n, 1.0f) - 0.5f;
+    }
+
+    ImageBuffer& framebuffer = *frame.pixels;
+    CostMap* cost = frame.cost.empty() ? nullptr : &frame.cost;
+    const float weight = 1.0f / n;
+    constexpr size_t chunk = 256;
+    std::atomic<size_t> next{0};
+
+    // Os pixels de borda são distribuídos dinamicamente: as bordas se concentram em poucas linhas.
+    auto worker = [&]()
+    {
+        CG_TRACE_SCOPE("antialias", "render");
+        Ray3f ray;
+        ray.tMin = view.clipF;
+        ray.tMax = view.clipB;
+        Intersection hit;
+
+        if (view.ortho)
+            ray.direction = view.viewDir;
+        else
+            ray.origin = view.eye;
+
+        for (;;)
+        {
+            if (_cancelFlag.load(std::memory_order_relaxed)) return;
+
+            const size_t b = next.fetch_add(chunk);
+
+            if (b >= edges.size()) return;
+
+            const size_t e = std::min(b + chunk, edges.size());
+            CG_PROFILE_SCOPE(_profiler, Profiler::Render);
+
+            for (size_t k = b; k < e; ++k)
+            {
+                CG_PROFILE_PIXEL(_profiler);
+                const int x = edges[k] % W;
+                const int y = edges[k] / W;
+                PixelCost pixelCost{cost, x, y};
+                CostMap::Counters* counters = pixelCost.counters();
+                Color sum{0, 0, 0};
+
+                if (counters != nullptr)
+                {
+                    counters->samples += n;
+                    counters->rays += n;
+                }
+
+                for (int s = 0; s < n; ++s)
+                {
+                    {
+                        CG_PROFILE_SAMPLED_SCOPE(_profiler, Profiler::RayGeneration);
+
+                        const vec3f p = view.topLeft
+                                      + (view.deltaU * ((float)x + offsetU[s]))
+                                      + (view.deltaV * ((float)y + offsetV[s]));
+
+                        if (view.ortho)
+                            ray.origin = p;
+                        else
+                            ray.direction = (p - view.eye).versor();
+                    }
+
+                    hit.object = nullptr;
+                    hit.distance = ray.tMax;
+
+                    bool found;
+                    {
+                        CG_PROFILE_SAMPLED_SCOPE(_profiler, Profiler::PrimaryTraversal);
+                        found = intersect(ray, hit, counters);
+                    }
+
+                    Color color = background();
+                    if (found)
+                    {
+                        CG_PROFILE_SAMPLED_SCOPE(_profiler, Profiler::Shading);
+                        color = shade(ray, hit, nullptr, counters);
+                    }
+                    sum += clampColor(color) * weight;
+                }
+                framebuffer(x, y).set(sum);
+            }
+        }
+    };
+
+    const unsigned int hw = std::thread::hardware_concurrency();
+    std::vector<std::thread> threads;
+
+    for (unsigned int i = 0, count = std::max(1u, hw); i < count; ++i)
+        threads.emplace_back(worker);
+    for (auto& t : threads)
+        t.join();
+    return (int)edges.size();
+}
+
+bool RayCaster::reproject(const View& view, std::vector<int>& source, std::vector<float>& depth) const
+{
+    const IdBuffer& prev = _idBuffer;
+
+    if (!prev.valid || !prev.pixels || prev.w != view.w || prev.h != view.h || prev.view.ortho != view.ortho)
+        return false;
+
+    const View& old = prev.view;
+    const int W = view.w;
+    const int H = view.h;
+    const float invU = 1.0f / view.deltaU.squaredNorm();
+    const float invV = 1.0f / view.deltaV.squaredNorm();
+    const float planeDistance = (view.topLeft - view.eye).dot(view.viewDir);
+
+    source.assign((size_t)W * H, -1);
+    depth.assign((size_t)W * H, std::numeric_limits<float>::infinity());
+
+    // Dispersão dos hits anteriores na nova vista com teste de profundidade.
+    for (int y = 0; y < H; ++y)
+    {
+        const vec3f rowStart = old.topLeft + (old.deltaV * (float)y);
+
+        for (int x = 0; x < W; ++x)
+        {
+            const int i = y * W + x;
+
+            if (prev.actors[i] == nullptr)
+                continue;
+
+            // Ponto do mundo atingido pelo raio do pixel (x, y) no quadro anterior.
+            const float d = prev.depth[i];
+            const vec3f pixel = rowStart + (old.deltaU * (float)x);
+            const vec3f P = old.ortho ? pixel + old.viewDir * d : old.eye + (pixel - old.eye).versor() * d;
+
+            // Projeção no plano de visão da nova câmera.
+            vec3f X;
+            float t;
+
+            if (view.ortho)
+            {
+                t = (P - view.topLeft).dot(view.viewDir);
+                X = P - view.viewDir * t;
+            }
+            else
+            {
+                const vec3f q = P - view.eye;
+                const float qz = q.dot(view.viewDir);
+
+                if (qz <= 0)
+                    continue;
+                X = view.eye + q * (planeDistance / qz);
+                t = q.length();
+            }
+
+            const vec3f r = X - view.topLeft;
+            const int nx = (int)std::floor(r.dot(view.deltaU) * invU + 0.5f);
+            const int ny = (int)std::floor(r.dot(view.deltaV) * invV + 0.5f);
+
+            if (nx < 0 || ny < 0 || nx >= W || ny >= H)
+                continue;
+
+            const size_t j = (size_t)ny * W + nx;
+
+            if (t < depth[j])
+            {
+                depth[j] = t;
+                source[j] = i;
+            }
+        }
+    }
+    return true;
+}
+
+void RayCaster::present(Frame& frame, Image* image)
+{
+    {
+        CG_PROFILE_SCOPE(_profiler, Profiler::ImageUpload);
+        CG_TRACE_SCOPE("image upload", "render", "step", frame.step);
+        image->setData(*frame.pixels);
+    }
+
+    if (frame.step != 1)
+        return;
+    if (!frame.cost.empty())
+        std::swap(_costMap, frame.cost);
+    _reuseRatio = (float)frame.reused / ((float)frame.view.w * frame.view.h);
+    _aaEdgeRatio = (float)frame.edges / ((float)frame.view.w * frame.view.h);
+    if (!frame.ids.empty())
+    {
+        _idBuffer.w = frame.view.w;
+        _idBuffer.h = frame.view.h;
+        _idBuffer.timestamp = frame.view.timestamp;
+        _idBuffer.view = frame.view;
+        _idBuffer.actors = std::move(frame.ids);
+        _idBuffer.depth = std::move(frame.depth);
+        _idBuffer.pixels = std::move(frame.pixels);
+        _idBuffer.valid = true;
+    }
+    else
+        _idBuffer.valid = false;
+}
+
+// Prepara um quadro na thread principal: adota a BVH reconstruída em segundo plano e captura o
+// snapshot da cena lido pelo traçado (inclusive pelas threads de um estágio em segundo plano).
+bool RayCaster::beginFrame(Camera* camera)
+{
+    cancel();
+    _profiler.beginFrame();
+    _camera = camera;
+    {
+        CG_PROFILE_SCOPE(_profiler, Profiler::BVHBuild);
+        CG_TRACE_SCOPE("BVH commit", "scene");
+        _bvh.commit();
+    }
+    _snapshot.capture(*_scene);
+    return _viewport.w > 0 && _viewport.h > 0;
+}
+
+void RayCaster::renderImage(Camera* camera, Image* image)
+{
+    if (!camera || !image) return;
+    
+    if (!beginFrame(camera)) return;
+
+    Frame frame;
+
+    if (trace(makeView(camera), 1, frame))
+    {
+        present(frame, image);
+        _profiler.endFrame();
+    }
+}
+
+int RayCaster::renderPreview(Camera* camera, Image* image)
+{
+    if (!camera || !image) return 0;
+
+    if (!beginFrame(camera)) return 0;
+
+    const int step = _previewStep;
+    auto start = std::chrono::steady_clock::now();
+    Frame frame;
+
+    trace(makeView(camera), step, frame);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Ajuste do tamanho de bloco para o próximo quadro: cada divisão por 2 custa ~4x mais raios.
+    if (ms > _frameBudget && _previewStep < 16)
+        _previewStep *= 2;
+    else if (ms * 4 < _frameBudget && _previewStep > 1)
+        _previewStep /= 2;
+
+    present(frame, image);
+    _profiler.endFrame();
+    return step;
+}
+
+void RayCaster::startStage(Camera* camera, int step)
+{
+    if (!beginFrame(camera)) return;
+
+    _worker = std::thread([this, view = makeView(camera), step]()
+    {
+        Frame frame;
+
+        if (trace(view, std::max(step, 1), frame))
+        {
+            _stageFrame = std::move(frame);
+            _stageDone.store(true, std::memory_order_release);
+        }
+    });
+}
+
+int RayCaster::pollStage(Image* image)
+{
+    if (!_worker.joinable() || !_stageDone.load(std::memory_order_acquire))
+        return 0;
+
+    _worker.join();
+    _stageDone = false;
+    present(_stageFrame, image);
+    _profiler.endFrame();
+    return _stageFrame.step;
+}
+
+void RayCaster::cancel()
+{
+    if (_worker.joinable())
+    {
+        _cancelFlag = true;
+        _worker.join();
+        _profiler.discard(); // o estágio não será apresentado
+    }
+    _cancelFlag = false;
+    _stageDone = false;
+}
+
+bool RayCaster::idBufferMatches() const
+{
+  return _idBufferEnabled
+      && _idBuffer.valid
+      && _idBuffer.w == _viewport.w
+      && _idBuffer.h == _viewport.h
+      && _idBuffer.timestamp == _camera->timestamp();
+}
+
+// Executa seleção de objetos: consulta direta ao buffer de IDs ou Ray Casting (Picking).
 PBRActor* RayCaster::selectActor(int x, int y)
 {
-  if (!_bvh || _bvh->empty())
+  if (idBufferMatches())
   {
-    buildBVH();
-    if (!_bvh || _bvh->empty())
+    if (x < 0 || y < 0 || x >= _idBuffer.w || y >= _idBuffer.h)
       return nullptr;
+    return _idBuffer.actors[(size_t)y * _idBuffer.w + x];
   }
+  return pickActor(x, y);
+}
+
+// Seleção retangular: varredura do buffer de IDs (ou um raio por pixel, se o buffer estiver desatualizado).
+std::vector<PBRActor*> RayCaster::selectActors(int x0, int y0, int x1, int y1)
+{
+  std::vector<PBRActor*> selected;
+
+  if (x0 > x1) std::swap(x0, x1);
+  if (y0 > y1) std::swap(y0, y1);
+  x0 = std::max(x0, 0);
+  y0 = std::max(y0, 0);
+  x1 = std::min(x1, _viewport.w - 1);
+  y1 = std::min(y1, _viewport.h - 1);
+
+  const bool useBuffer = idBufferMatches();
+
+  // Sem o buffer de IDs, um raio por pixel: o snapshot e a BVH são atualizados uma única vez.
+  if (!useBuffer)
+    preparePicking();
+  for (int y = y0; y <= y1; ++y)
+    for (int x = x0; x <= x1; ++x)
+    {
+      PBRActor* actor = useBuffer ? _idBuffer.actors[(size_t)y * _idBuffer.w + x] : castPickRay(x, y);
+
+      // Atores vizinhos na imagem costumam se repetir; a busca linear é suficiente.
+      if (actor != nullptr && std::find(selected.begin(), selected.end(), actor) == selected.end())
+        selected.push_back(actor);
+    }
+  return selected;
+}
+
+// Executa seleção de objetos via Ray Casting (Picking).
+PBRActor* RayCaster::pickActor(int x, int y)
+{
+  preparePicking();
+  return castPickRay(x, y);
+}
+
+void RayCaster::preparePicking()
+{
+  if (!stageRunning())
+  {
+    _snapshot.capture(*_scene);
+
+    CG_PROFILE_SCOPE(_profiler, Profiler::BVHBuild);
+    _bvh.commit();
+  }
+}
+
+PBRActor* RayCaster::castPickRay(int x, int y)
+{
+  if (_bvh.empty())
+    return nullptr;
   
   Ray3f ray;
   setPixelRay((float)x + 0.5f, (float)y + 0.5f, ray);
@@ -2,14 +2,19 @@
 
 #include "Scene.h"
 #include "PBRActor.h"
+#include "DynamicBVH.h"
+#include "SceneSnapshot.h"
+#include "Profiler.h"
+#include "CostMap.h"
 #include "graphics/Camera.h"
 #include "graphics/GLImage.h"
 #include "geometry/Ray.h"
 #include "geometry/Intersection.h"
-#include "geometry/BVH.h"
+#include <algorithm>
 #include <vector>
 #include <thread>
 #include <atomic>
+#include <memory>
 #include <mutex>
 
 namespace cg
@@ -19,14 +24,14 @@ class RayCaster
 public:
   RayCaster(Scene& scene, Camera& camera):
     _scene{&scene},
-    _camera{&camera},
-    _bvh{nullptr}
+    _camera{&camera}
   {
     buildBVH();
   }
 
   ~RayCaster()
   {
+    cancel();
   }
 
   static inline Color clampColor(const Color& c)
@@ -45,11 +50,146 @@ public:
   // Executa o pipeline de renderização (geração de raios, traçado e shading) para preencher a imagem.
   void renderImage(Camera* camera, Image* image);
 
-  // Executa o algoritmo de picking (seleção) disparando um raio através das coordenadas de tela (x, y).
+  // --- Renderização progressiva ---
+  // Durante a interação, renderPreview traça um raio por bloco de step x step pixels (ampliação por
+  // vizinho mais próximo), escolhendo step de modo a respeitar o orçamento de tempo por quadro.
+  // Quando a câmera para, os estágios seguintes (step/2, ..., 1) são traçados em segundo plano
+  // por startStage e apresentados por pollStage; um estágio desatualizado é cancelado via cancel().
+
+  // Renderiza sincronamente um quadro de prévia e retorna o tamanho de bloco usado.
+  int renderPreview(Camera* camera, Image* image);
+
+  // Inicia em segundo plano o estágio com blocos de step x step pixels.
+  void startStage(Camera* camera, int step);
+
+  // Apresenta o estágio concluído na imagem; retorna o tamanho de bloco do estágio ou 0 se nenhum terminou.
+  int pollStage(Image* image);
+
+  bool stageRunning() const { return _worker.joinable(); }
+
+  // Cancela (e aguarda) o estágio em andamento, descartando seu resultado.
+  void cancel();
+
+  bool progressive() const { return _progressive; }
+  void setProgressive(bool enabled)
+  {
+    cancel();
+    _progressive = enabled;
+  }
+
+  // Orçamento de tempo por quadro da prévia (em ms).
+  float frameBudget() const { return _frameBudget; }
+  void setFrameBudget(float ms) { _frameBudget = std::max(ms, 1.0f); }
+
+  // Executa o algoritmo de picking (seleção) nas coordenadas de tela (x, y).
+  // Consulta o buffer de IDs quando ele corresponde à câmera atual; caso contrário, dispara um raio.
   PBRActor* selectActor(int x, int y);
 
+  // Seleção retangular: retorna os atores distintos visíveis no retângulo [x0, x1] x [y0, y1].
+  std::vector<PBRActor*> selectActors(int x0, int y0, int x1, int y1);
+
+  // Habilita a consulta ao buffer de IDs (ator e profundidade por pixel) na seleção.
+  void setIdBufferEnabled(bool enabled)
+  {
+    _idBufferEnabled = enabled;
+  }
+
+  bool idBufferEnabled() const { return _idBufferEnabled; }
+
+  // --- Cache de reprojeção temporal ---
+  // Em quadros de resolução completa, o quadro anterior (IDs, profundidades e cores) é reprojetado na
+  // nova câmera. Um pixel reaproveita a cor em cache quando o raio novo atinge o mesmo ator na
+  // profundidade reprojetada, a vizinhança 3x3 é consistente e a direção de visão mudou menos que a
+  // tolerância (o shading direto depende da câmera apenas por V). Os demais pixels são traçados.
+  void setReprojectionEnabled(bool enabled)
+  {
+    cancel();
+    _reprojection = enabled;
+  }
+
+  bool reprojectionEnabled() const { return _reprojection; }
+
+  // Tolerância da variação do ângulo de visão (em graus) para reaproveitar um pixel.
+  float reprojectionTolerance() const { return _reprojectionTolerance; }
+  void setReprojectionTolerance(float degrees)
+  {
+    cancel();
+    _reprojectionTolerance = std::clamp(degrees, 0.0f, 45.0f);
+  }
+
+  // Fração dos pixels do último quadro completo reaproveitados da reprojeção.
+  float reuseRatio() const { return _reuseRatio; }
+
+  // --- Antialiasing guiado por ID ---
+  // O quadro de resolução completa é traçado com uma amostra por pixel, registrando ator e normal;
+  // somente os pixels cujo ator ou normal difere de um vizinho recebem aaSamples amostras
+  // estratificadas. Nas bordas a qualidade se aproxima da superamostragem uniforme, com uma fração do custo.
+  static constexpr int maxAASamples = 16;
+
+  int aaSamples() const { return _aaSamples; }
+  void setAASamples(int samples)
+  {
+    touch();
+    _aaSamples = std::clamp(samples, 1, maxAASamples);
+  }
+
+  // Fração dos pixels do último quadro completo reamostrados pelo antialiasing.
+  float aaEdgeRatio() const { return _aaEdgeRatio; }
+
   // Reconstrói a estrutura de aceleração espacial (necessário se a geometria da cena for alterada).
-  void rebuildBVH() { buildBVH(); }
+  void rebuildBVH()
+  {
+    touch();
+    buildBVH();
+  }
+
+  // Fração da área da cena a partir da qual um ator é testado fora da BVH (0 desabilita).
+  float largeFraction() const { return _bvh.largeFraction(); }
+  void setLargeFraction(float fraction)
+  {
+    touch();
+    _bvh.setLargeFraction(fraction);
+  }
+
+  // Atualização incremental da BVH após edição de um ator (transformação ou visibilidade).
+  void updateActor(PBRActor* actor);
+
+  // Inserção/remoção incremental de atores adicionados ou retirados da cena.
+  void addActor(PBRActor* actor);
+  void removeActor(PBRActor* actor);
+
+  // Registra uma alteração da cena que não afeta a geometria (materiais, luzes, fundo).
+  // O estágio em andamento é cancelado: o traçado não pode ler a cena enquanto ela é alterada.
+  // O snapshot é descartado, pois pode apontar para atores ou luzes removidos.
+  void touch()
+  {
+    cancel();
+    ++_sceneVersion;
+    _idBuffer.valid = false;
+    _snapshot.clear();
+  }
+
+  // Versão da cena, incrementada a cada edição (usada para decidir quando renderizar novamente).
+  uint32_t sceneVersion() const { return _sceneVersion; }
+
+  const DynamicBVH& bvh() const { return _bvh; }
+
+  // Tempo por estágio (BVH, linhas de pixels e envio da imagem) e número de raios gerados, traçados e
+  // sombreados do último quadro apresentado; vazio se o projeto não for compilado com CG_PROFILE.
+  const Profiler& profiler() const { return _profiler; }
+
+  // --- Mapa de custo por pixel ---
+  // Nos quadros de resolução completa, registra por pixel as amostras, os raios (primários, de sombra
+  // e do antialiasing), os nós da BVH visitados, os atores testados e o tempo gasto.
+  bool costMapEnabled() const { return _costMapEnabled; }
+  void setCostMapEnabled(bool enabled)
+  {
+    touch();
+    _costMapEnabled = enabled;
+  }
+
+  // Mapa do último quadro completo apresentado com o registro habilitado.
+  const CostMap& costMap() const { return _costMap; }
 
 private:
   struct Viewport
@@ -57,32 +197,137 @@ private:
     int w, h;
   };
 
+  // Parâmetros de visualização copiados da câmera no início do quadro; o traçado não consulta a câmera.
+  struct View
+  {
+    int w = 0, h = 0;
+    uint32_t timestamp = 0;
+    vec3f eye;
+    vec3f viewDir;
+    vec3f topLeft; // centro do pixel (0, 0) no plano de visão
+    vec3f deltaU;
+    vec3f deltaV;
+    float clipF = 0, clipB = 0;
+    bool ortho = false;
+  };
+
+  // Resultado de um estágio de renderização.
+  struct Frame
+  {
+    int step = 0;
+    View view;
+    int reused = 0;
+    int edges = 0;
+    std::unique_ptr<ImageBuffer> pixels;
+    std::vector<PBRActor*> ids;
+    std::vector<float> depth;
+    CostMap cost; // vazio se o registro estiver desabilitado ou step > 1
+  };
+
+  // Buffer auxiliar do último quadro completo: ator atingido, distância do hit e cor por pixel.
+  // Na seleção, só é válido para a câmera (timestamp) e viewport com os quais foi gerado;
+  // como cache de reprojeção, vale até a próxima alteração da cena.
+  struct IdBuffer
+  {
+    int w = 0, h = 0;
+    uint32_t timestamp = 0;
+    bool valid = false;
+    View view;
+    std::vector<PBRActor*> actors;
+    std::vector<float> depth;
+    std::unique_ptr<ImageBuffer> pixels;
+  };
+
   Reference<Camera> _camera;
-  Reference<BVH<PBRActor>> _bvh;
+  DynamicBVH _bvh;
   Reference<Scene> _scene;
+  SceneSnapshot _snapshot; // atores, luzes e fundo do quadro atual, sem contagem de referências
   Viewport _viewport;
-  bool _bruteIntersect = true;
+  IdBuffer _idBuffer;
+  bool _idBufferEnabled = true;
+  uint32_t _sceneVersion = 0;
+  bool _bruteIntersect = false;
+  bool _reprojection = true;
+  float _reprojectionTolerance = 2.0f;
+  float _reuseRatio = 0;
+  int _aaSamples = 8;
+  float _aaEdgeRatio = 0;
+  Profiler _profiler;
+  bool _costMapEnabled = false;
+  CostMap _costMap;
+
+  // Cosseno do maior ângulo entre normais vizinhas de um mesmo ator que não é tratado como borda.
+  static constexpr float edgeNormalCos = 0.9f;
+
+  // Estado da renderização progressiva.
+  std::thread _worker;
+  std::atomic<bool> _cancelFlag{false};
+  std::atomic<bool> _stageDone{false};
+  Frame _stageFrame;
+  vec3f _eye;
+  bool _progressive = true;
+  int _previewStep = 8;
+  float _frameBudget = 33.0f;
 
   // Métodos internos do pipeline de Ray Tracing
 
   void buildBVH();
+
+  // Cancela o estágio em andamento, sincroniza a BVH e captura o snapshot da cena;
+  // retorna false se o viewport for vazio.
+  bool beginFrame(Camera* camera);
+
+  // Copia da câmera os parâmetros do quadro.
+  View makeView(Camera* camera) const;
+
+  // Traça o quadro com um raio por bloco de step x step pixels; retorna false se for cancelado.
+  bool trace(const View& view, int step, Frame& frame);
+
+  // Reamostra os pixels de borda do quadro de resolução completa; retorna o número de pixels de borda.
+  int antialias(const View& view, const std::vector<vec3f>& normals, Frame& frame);
+
+  // Envia o quadro para a imagem e, se for de resolução completa, promove-o a buffer de IDs.
+  void present(Frame& frame, Image* image);
   
   // Gera o raio primário a partir da câmera.
   void setPixelRay(float x, float y, Ray3f& ray);
   
   // Teste de interseção contra a estrutura de aceleração.
-  bool intersect(const Ray3f& ray, Intersection& hit);
+  // Com cost, soma os nós visitados e os atores testados.
+  bool intersect(const Ray3f& ray, Intersection& hit, CostMap::Counters* cost = nullptr);
   
-  // Calcula a cor final de um ponto de interseção.
-  Color shade(const Ray3f& ray, const Intersection& hit);
+  // Calcula a cor final de um ponto de interseção (e, opcionalmente, a normal no ponto).
+  Color shade(const Ray3f& ray, const Intersection& hit, vec3f* normal = nullptr,
+    CostMap::Counters* cost = nullptr);
+
+  // Normal em espaço do mundo no ponto P da superfície do ator.
+  vec3f surfaceNormal(const PBRActor* actor, const vec3f& P) const;
   
   // Aplica o modelo de iluminação Cook-Torrance BRDF.
-  Color calculatePBR(const vec3f& P, const vec3f& N, const PBRMaterial* material);
+  // Com cost, soma os raios de sombra e sua travessia.
+  Color calculatePBR(const vec3f& P, const vec3f& N, const PBRMaterial* material,
+    CostMap::Counters* cost = nullptr);
   
   // Mapeia coordenadas de raster para coordenadas de janela (View Plane).
   vec3f imageToWindow(float x, float y) const;
   
   Color background() const;
+
+  // Verifica se o buffer de IDs pode responder consultas para a câmera atual.
+  bool idBufferMatches() const;
+
+  // Reprojeta os hits do último quadro completo na vista: para cada pixel, o índice do pixel de
+  // origem mais próximo (teste de profundidade) e sua distância na nova vista (-1 onde há buraco).
+  bool reproject(const View& view, std::vector<int>& source, std::vector<float>& depth) const;
+
+  // Dispara um raio pelo centro do pixel (x, y) e retorna o ator atingido.
+  PBRActor* pickActor(int x, int y);
+
+  // Atualiza o snapshot da cena e a BVH antes de uma série de raios de seleção (fora do refinamento).
+  void preparePicking();
+
+  // Raio de seleção pelo centro do pixel (x, y), com a BVH já atualizada por preparePicking().
+  PBRActor* castPickRay(int x, int y);
 };
 
 }
\ No newline at end of file
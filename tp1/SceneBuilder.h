@@ -6,7 +6,9 @@
 #include "Sphere.h"
 #include "Plane.h"
 #include "Box.h"
-#include <cstring>
+#include "ShapeCache.h"
+#include <cstdio>
+#include <functional>
 
 namespace cg
 {
@@ -78,7 +80,7 @@ private:
 
   static void addFloor(Scene* scene)
   {
-    auto shape = new Plane{50.0f, 25.0f};
+    auto shape = ShapeCache::plane(50.0f, 25.0f);
     
     auto material = new PBRMaterial(
         Color{0.2f, 1.0f, 0.9f},
@@ -90,13 +92,6 @@ private:
     auto actor = new PBRActor{"Floor", shape, material};
     actor->setPosition({0.0f, -0.01f, 0.0f});
 
-    if (shape && shape->mesh())
-    {
-        auto mesh = const_cast<TriangleMesh*>(shape->mesh());
-        if (mesh)
-            std::memset(&mesh->userData, 0, sizeof(mesh->userData));
-    }
-
     scene->addActor(actor);
   }
   
@@ -141,18 +136,19 @@ private:
         &PBRMaterial::gold
     };
 
+    // Formas idênticas são compartilhadas via cache (uma malha por forma distinta).
     std::function<Shape3*()> createShape;
     std::string shapeNamePrefix;
 
     if (type == ShapeType::BOX)
     {
       shapeNamePrefix = "Box";
-      createShape = []() { return new Box{boxDimension}; };
+      createShape = []() { return ShapeCache::box(boxDimension); };
     }
     else // SPHERE
     {
       shapeNamePrefix = "Sphere";
-      createShape = []() { return new Sphere{sphereRadius, 3}; };
+      createShape = []() { return ShapeCache::sphere(sphereRadius, 3); };
     }
 
     std::function<PBRMaterial*(int, float)> createMaterial;
@@ -190,13 +186,6 @@ private:
 
       auto actor = new PBRActor{name, shape, material};
       actor->setPosition(position);
-      
-      if (shape && shape->mesh())
-      {
-          auto mesh = const_cast<TriangleMesh*>(shape->mesh());
-          if (mesh)
-              std::memset(&mesh->userData, 0, sizeof(mesh->userData));
-      }
 
       scene->addActor(actor);
     }
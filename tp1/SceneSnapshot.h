@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Scene.h"
+#include "PBRActor.h"
+#include "graphics/Light.h"
+#include <vector>
+
+namespace cg
+{
+
+// Vista não proprietária da cena para os laços quentes da renderização: ponteiros crus para os
+// atores visíveis (com forma e material já resolvidos) e para as luzes acesas, capturados uma vez
+// no início do quadro. Percorrer o snapshot não incrementa nem decrementa contadores de referência.
+// A cena é dona dos objetos: o snapshot deve ser descartado (clear) antes de qualquer edição.
+struct SceneSnapshot
+{
+  struct ActorEntry
+  {
+    PBRActor* actor;
+    Shape3* shape;
+    const PBRMaterial* material;
+  };
+
+  std::vector<ActorEntry> actors;
+  std::vector<const Light*> lights;
+  Color background;
+
+  void capture(const Scene& scene)
+  {
+    clear();
+    actors.reserve(scene.actorCount());
+    for (const auto& actor : scene.actors())
+      if (actor->isVisible() && actor->shape() != nullptr)
+        actors.push_back(ActorEntry{actor.get(), actor->shape(), actor->pbrMaterial()});
+    for (const auto& light : scene.lights())
+      if (light->isTurnedOn())
+        lights.push_back(light.get());
+    background = scene.backgroundColor;
+  }
+
+  void clear()
+  {
+    actors.clear();
+    lights.clear();
+  }
+};
+
+}
@@ -4,6 +4,8 @@
 #include "geometry/TriangleMesh.h"
 #include "graphics/TransformableObject.h"
 #include "math/Vector3.h"
+#include <cstring>
+#include <mutex>
 
 namespace cg
 {
@@ -18,8 +20,15 @@ public:
   }
 
   // Retorna a representação em malha triangular da forma.
+  // A malha só é gerada no primeiro acesso: o Ray Caster interseca as formas analiticamente
+  // e apenas o pipeline de rasterização precisa dela.
   TriangleMesh* mesh() const
   {
+    std::call_once(_meshFlag, [this]()
+    {
+      if ((_mesh = generateMesh()) != nullptr)
+        std::memset(&_mesh->userData, 0, sizeof(_mesh->userData));
+    });
     return _mesh;
   }
 
@@ -34,7 +43,7 @@ public:
   virtual Bounds3f bounds() const = 0;
 
 protected:
-  TriangleMesh* _mesh;
+  mutable TriangleMesh* _mesh;
 
   Shape3():
     _mesh{nullptr}
@@ -42,7 +51,10 @@ protected:
   }
 
   // Método virtual para geração ou tesselação da malha geométrica.
-  virtual void generateMesh() = 0;
+  virtual TriangleMesh* generateMesh() const = 0;
+
+private:
+  mutable std::once_flag _meshFlag;
 
 };
 
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Sphere.h"
+#include "Box.h"
+#include "Plane.h"
+#include <map>
+#include <tuple>
+
+namespace cg
+{
+
+// Cache de formas geométricas indexado pelos parâmetros da forma.
+// Formas idênticas são compartilhadas entre os atores, de modo que cada forma distinta possui
+// uma única TriangleMesh (e um único buffer OpenGL), gerada apenas quando a rasterização a solicita.
+class ShapeCache
+{
+public:
+  static Sphere* sphere(float radius = 1.0f, int subdivisions = 3)
+  {
+    return find<Sphere>(Key{Type::Sphere, radius, radius, radius, subdivisions}, radius, subdivisions);
+  }
+
+  static Box* box(float size = 1.0f)
+  {
+    return box(size, size, size);
+  }
+
+  static Box* box(float width, float height, float depth)
+  {
+    return find<Box>(Key{Type::Box, width, height, depth, 0}, width, height, depth);
+  }
+
+  static Plane* plane(float width = 2.0f, float height = 2.0f)
+  {
+    return find<Plane>(Key{Type::Plane, width, 0.0f, height, 0}, width, height);
+  }
+
+  // Número de formas distintas atualmente em cache.
+  static int size()
+  {
+    return (int)_shapes.size();
+  }
+
+  // Libera as referências do cache (as formas ainda usadas por atores permanecem vivas).
+  static void clear()
+  {
+    _shapes.clear();
+  }
+
+private:
+  enum class Type
+  {
+    Sphere,
+    Box,
+    Plane
+  };
+
+  using Key = std::tuple<Type, float, float, float, int>;
+
+  inline static std::map<Key, Reference<Shape3>> _shapes;
+
+  template <typename S, typename... Args>
+  static S* find(const Key& key, Args... args)
+  {
+    auto it = _shapes.find(key);
+
+    if (it == _shapes.end())
+      it = _shapes.emplace(key, new S{args...}).first;
+    return (S*)it->second.get();
+  }
+};
+
+}
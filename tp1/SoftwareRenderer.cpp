@@ -0,0 +1,473 @@
+#include "SoftwareRenderer.h"
+#include "Float4.h"
+#include "PBRKernel.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <thread>
+
+namespace cg
+{
+
+using simd::Float4;
+
+namespace
+{
+
+// Vértice em espaço de recorte com os atributos interpolados.
+struct ClipVertex
+{
+  float x, y, z, w;
+  vec3f position;
+  vec3f normal;
+};
+
+inline ClipVertex lerp(const ClipVertex& a, const ClipVertex& b, float t)
+{
+  return ClipVertex{
+    a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t,
+    a.position + (b.position - a.position) * t,
+    a.normal + (b.normal - a.normal) * t
+  };
+}
+
+inline void transform(const mat4f& m, const vec3f& p, ClipVertex& v)
+{
+  v.x = m[0].x * p.x + m[1].x * p.y + m[2].x * p.z + m[3].x;
+  v.y = m[0].y * p.x + m[1].y * p.y + m[2].y * p.z + m[3].y;
+  v.z = m[0].z * p.x + m[1].z * p.y + m[2].z * p.z + m[3].z;
+  v.w = m[0].w * p.x + m[1].w * p.y + m[2].w * p.z + m[3].w;
+}
+
+// Recorta o triângulo no plano near (z >= -w); retorna o número de vértices do polígono (0, 3 ou 4).
+int clipNear(const ClipVertex* in, ClipVertex* out)
+{
+  int n = 0;
+
+  for (int i = 0; i < 3; ++i)
+  {
+    const ClipVertex& a = in[i];
+    const ClipVertex& b = in[(i + 1) % 3];
+    float da = a.z + a.w;
+    float db = b.z + b.w;
+
+    if (da >= 0)
+      out[n++] = a;
+    if ((da >= 0) != (db >= 0))
+      out[n++] = lerp(a, b, da / (da - db));
+  }
+  return n;
+}
+
+inline Float4 mask(bool b)
+{
+  return Float4{std::bit_cast<float>(b ? ~0u : 0u)};
+}
+
+} // end namespace
+
+SoftwareRenderer::SoftwareRenderer(Scene& scene, Camera& camera):
+  _scene{&scene},
+  _camera{&camera},
+  _viewport{1280, 720}
+{
+}
+
+void SoftwareRenderer::render(Image* image)
+{
+  render();
+  if (image != nullptr && _color != nullptr)
+    image->setData(*_color);
+}
+
+void SoftwareRenderer::render()
+{
+  const int W = _viewport.w;
+  const int H = _viewport.h;
+
+  if (W <= 0 || H <= 0)
+    return;
+  if (_color == nullptr || _color->width() != W || _color->height() != H)
+    _color = std::make_unique<ImageBuffer>(W, H);
+  _depth.assign((size_t)W * H, 1.0f);
+
+  // Atores, luzes e matrizes do quadro; as luzes são tratadas como pontuais, como no shader.
+  _snapshot.capture(*_scene);
+  _lights.clear();
+  for (auto light : _snapshot.lights)
+    _lights.push_back(Light{light->position(), light->color, (int)light->falloff});
+  _viewProjection = _camera->projectionMatrix() * _camera->worldToCameraMatrix();
+  _eye = _camera->position();
+  _tilesX = (W + tileSize - 1) / tileSize;
+  _tilesY = (H + tileSize - 1) / tileSize;
+
+  const unsigned int hw = std::thread::hardware_concurrency();
+  const int numThreads = std::max(1u, hw ? hw : 1u);
+  const int actorCount = (int)_snapshot.actors.size();
+  const int tileCount = _tilesX * _tilesY;
+
+  _bins.resize(numThreads);
+  for (auto& bin : _bins)
+  {
+    bin.triangles.clear();
+    bin.tiles.resize(tileCount);
+    for (auto& tile : bin.tiles)
+      tile.clear();
+  }
+
+  // Etapa 1: cada thread prepara um intervalo contíguo de atores, preservando a ordem de desenho.
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < numThreads; ++t)
+  {
+    int begin = (int)((long long)actorCount * t / numThreads);
+    int end = (int)((long long)actorCount * (t + 1) / numThreads);
+
+    threads.emplace_back([this, begin, end, t]()
+    {
+      CG_TRACE_SCOPE("setup", "raster", "actors", end - begin);
+      setup(begin, end, _bins[t]);
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+  threads.clear();
+
+  _triangleCount = 0;
+  for (const auto& bin : _bins)
+    _triangleCount += (int)bin.triangles.size();
+
+  // Etapa 2: tiles distribuídos dinamicamente entre as threads.
+  std::atomic<int> next{0};
+
+  for (int t = 0; t < numThreads; ++t)
+    threads.emplace_back([this, &next, tileCount]()
+    {
+      for (int tile; (tile = next.fetch_add(1)) < tileCount;)
+      {
+        CG_TRACE_SCOPE("tile", "raster", "tile", tile);
+        rasterize(tile);
+      }
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  if (_selectedActor != nullptr && _selectedActor->isVisible() && _selectedActor->shape() != nullptr)
+    drawBounds(_selectedActor);
+}
+
+void SoftwareRenderer::setup(int begin, int end, Bin& bin) const
+{
+  const int W = _viewport.w;
+  const int H = _viewport.h;
+  std::vector<ClipVertex> vertices;
+
+  for (int i = begin; i < end; ++i)
+  {
+    const auto& entry = _snapshot.actors[i];
+    const TriangleMesh* mesh = entry.shape->mesh();
+
+    if (mesh == nullptr)
+      continue;
+
+    const auto& data = mesh->data();
+    const mat4f M = entry.actor->transform();
+    const mat3f& N = entry.actor->normalMatrix();
+
+    vertices.resize(data.vertexCount);
+    for (int v = 0; v < data.vertexCount; ++v)
+    {
+      ClipVertex& cv = vertices[v];
+
+      cv.position = M.transform3x4(data.vertices[v]);
+      cv.normal = N * data.vertexNormals[v];
+      transform(_viewProjection, cv.position, cv);
+    }
+
+    for (int k = 0; k < data.triangleCount; ++k)
+    {
+      const int* index = data.triangles[k].v;
+      const ClipVertex in[3] = {vertices[index[0]], vertices[index[1]], vertices[index[2]]};
+
+      // Descarte trivial: os três vértices fora do mesmo plano lateral ou além do far.
+      auto outside = [&](auto f)
+      {
+        return f(in[0]) && f(in[1]) && f(in[2]);
+      };
+
+      if (outside([](const ClipVertex& v) { return v.x > v.w; })
+        || outside([](const ClipVertex& v) { return v.x < -v.w; })
+        || outside([](const ClipVertex& v) { return v.y > v.w; })
+        || outside([](const ClipVertex& v) { return v.y < -v.w; })
+        || outside([](const ClipVertex& v) { return v.z > v.w; }))
+        continue;
+
+      ClipVertex polygon[4];
+      int n = clipNear(in, polygon);
+
+      // Leque do polígono recortado.
+      for (int f = 1; f + 1 < n; ++f)
+      {
+        const ClipVertex* p[3] = {&polygon[0], &polygon[f], &polygon[f + 1]};
+        Triangle t;
+        float sx[3], sy[3], sz[3];
+
+        for (int j = 0; j < 3; ++j)
+        {
+          float invW = 1.0f / p[j]->w;
+
+          sx[j] = (p[j]->x * invW * 0.5f + 0.5f) * W;
+          sy[j] = (p[j]->y * invW * 0.5f + 0.5f) * H;
+          sz[j] = p[j]->z * invW * 0.5f + 0.5f;
+          t.invW[j] = invW;
+          t.position[j] = p[j]->position;
+          t.normal[j] = p[j]->normal;
+        }
+
+        // Face traseira (sentido horário na tela) ou degenerada.
+        float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]);
+
+        if (!(area > 0))
+          continue;
+
+        // Pixels cujo centro (x + 0.5, y + 0.5) está na caixa do triângulo.
+        float minX = std::min({sx[0], sx[1], sx[2]}), maxX = std::max({sx[0], sx[1], sx[2]});
+        float minY = std::min({sy[0], sy[1], sy[2]}), maxY = std::max({sy[0], sy[1], sy[2]});
+
+        t.x0 = std::max(0, (int)std::ceil(minX - 0.5f));
+        t.x1 = std::min(W - 1, (int)std::floor(maxX - 0.5f));
+        t.y0 = std::max(0, (int)std::ceil(minY - 0.5f));
+        t.y1 = std::min(H - 1, (int)std::floor(maxY - 0.5f));
+        if (t.x0 > t.x1 || t.y0 > t.y1)
+          continue;
+
+        t.invArea = 1.0f / area;
+        t.za = t.zb = 0;
+        for (int j = 0; j < 3; ++j)
+        {
+          int a = (j + 1) % 3;
+          int b = (j + 2) % 3;
+          float dx = sx[b] - sx[a];
+          float dy = sy[b] - sy[a];
+
+          // Arestas compartilhadas são percorridas em sentidos opostos pelos dois triângulos:
+          // exatamente um deles inclui os pixels sobre ela.
+          t.a[j] = sy[a] - sy[b];
+          t.b[j] = dx;
+          t.c[j] = sx[a] * sy[b] - sx[b] * sy[a];
+          t.inclusive[j] = dy < 0 || (dy == 0 && dx < 0);
+          t.za += (sz[j] - sz[0]) * t.a[j] * t.invArea;
+          t.zb += (sz[j] - sz[0]) * t.b[j] * t.invArea;
+        }
+        // O plano de profundidade é ancorado no vértice 0: com c_i, cuja magnitude cresce com a
+        // posição na tela, o erro de arredondamento superaria a separação entre superfícies próximas.
+        t.zc = sz[0] - t.za * sx[0] - t.zb * sy[0];
+        t.actor = i;
+
+        int index = (int)bin.triangles.size();
+
+        bin.triangles.push_back(t);
+        for (int ty = t.y0 / tileSize; ty <= t.y1 / tileSize; ++ty)
+          for (int tx = t.x0 / tileSize; tx <= t.x1 / tileSize; ++tx)
+            bin.tiles[ty * _tilesX + tx].push_back(index);
+      }
+    }
+  }
+}
+
+void SoftwareRenderer::rasterize(int tile)
+{
+  const int W = _viewport.w;
+  const int H = _viewport.h;
+  const int tx0 = (tile % _tilesX) * tileSize;
+  const int ty0 = (tile / _tilesX) * tileSize;
+  const int tx1 = std::min(tx0 + tileSize, W);
+  const int ty1 = std::min(ty0 + tileSize, H);
+  alignas(16) float depth[tileSize * tileSize];
+  const Triangle* visible[tileSize * tileSize];
+  const Float4 zero{0.0f};
+  const Float4 one{1.0f};
+  const Float4 offsets = Float4::set(0.5f, 1.5f, 2.5f, 3.5f);
+
+  std::fill_n(depth, tileSize * tileSize, 1.0f);
+  std::fill_n(visible, tileSize * tileSize, nullptr);
+
+  // Visibilidade: grupos de 4 pixels alinhados (tx0 é múltiplo de 4).
+  for (const auto& bin : _bins)
+    for (int index : bin.tiles[tile])
+    {
+      const Triangle& t = bin.triangles[index];
+      const int x0 = std::max(t.x0, tx0) & ~3;
+      const int x1 = std::min(t.x1, tx1 - 1);
+      const int y0 = std::max(t.y0, ty0);
+      const int y1 = std::min(t.y1, ty1 - 1);
+      const Float4 a[3] = {t.a[0], t.a[1], t.a[2]};
+      const Float4 inclusive[3] = {mask(t.inclusive[0]), mask(t.inclusive[1]), mask(t.inclusive[2])};
+      const Float4 za{t.za};
+
+      for (int y = y0; y <= y1; ++y)
+      {
+        const float py = y + 0.5f;
+        const Float4 row[3] = {t.b[0] * py + t.c[0], t.b[1] * py + t.c[1], t.b[2] * py + t.c[2]};
+        const Float4 zrow{t.zb * py + t.zc};
+        float* zline = depth + (y - ty0) * tileSize - tx0;
+        const Triangle** vline = visible + (y - ty0) * tileSize - tx0;
+
+        for (int x = x0; x <= x1; x += 4)
+        {
+          const Float4 px = Float4{(float)x} + offsets;
+          Float4 inside{0.0f};
+
+          for (int j = 0; j < 3; ++j)
+          {
+            const Float4 e = a[j] * px + row[j];
+            const Float4 edge = (e > zero) | ((e >= zero) & inclusive[j]);
+
+            inside = j == 0 ? edge : inside & edge;
+          }
+          if (bits(inside) == 0)
+            continue;
+
+          const Float4 z = za * px + zrow;
+          const Float4 old = Float4::load(zline + x);
+          const Float4 pass = inside & (z < old) & (z >= zero) & (z <= one);
+          const int m = bits(pass);
+
+          if (m == 0)
+            continue;
+          select(pass, z, old).store(zline + x);
+          for (int lane = 0; lane < 4; ++lane)
+            if (m & (1 << lane))
+              vline[x + lane] = &t;
+        }
+      }
+    }
+
+  // Shading: uma avaliação por pixel visível.
+  for (int y = ty0; y < ty1; ++y)
+    for (int x = tx0; x < tx1; ++x)
+    {
+      const int local = (y - ty0) * tileSize + (x - tx0);
+      const Triangle* t = visible[local];
+
+      _depth[(size_t)y * W + x] = depth[local];
+      if (t == nullptr)
+      {
+        (*_color)(x, y).set(_snapshot.background);
+        continue;
+      }
+
+      (*_color)(x, y).set(shade(*t, x + 0.5f, y + 0.5f));
+    }
+}
+
+Color SoftwareRenderer::shade(const Triangle& t, float x, float y) const
+{
+  // Coordenadas baricêntricas com correção de perspectiva.
+  float w[3];
+  float sum = 0;
+
+  for (int j = 0; j < 3; ++j)
+  {
+    w[j] = std::max((t.a[j] * x + t.b[j] * y + t.c[j]) * t.invArea, 0.0f) * t.invW[j];
+    sum += w[j];
+  }
+
+  const float inv = 1.0f / sum;
+  const vec3f P = (t.position[0] * w[0] + t.position[1] * w[1] + t.position[2] * w[2]) * inv;
+  const vec3f N = t.normal[0] * w[0] + t.normal[1] * w[1] + t.normal[2] * w[2];
+  const PBRMaterial* material = _snapshot.actors[t.actor].material;
+
+  // Mesmo modelo do pbrFragmentShader: luzes pontuais com atenuação por falloff.
+  PBRKernel::Surface surface{N, (_eye - P).versor(), material, PBRKernel::glslEpsilon};
+  PBRKernel::LightBatch batch;
+  vec3f Lo{0, 0, 0};
+
+  for (const auto& light : _lights)
+  {
+    vec3f L = light.position - P;
+    float d = L.length();
+
+    L = L * (1.0f / d);
+
+    float NdotL = surface.N.dot(L);
+
+    if (!(NdotL > 0))
+      continue;
+
+    Color radiance = light.color;
+
+    if (light.falloff == 1)
+      radiance = radiance * (1.0f / d);
+    else if (light.falloff == 2)
+      radiance = radiance * (1.0f / (d * d));
+    batch.add(L, NdotL, radiance);
+    if (batch.full())
+    {
+      Lo += PBRKernel::evaluate(surface, batch);
+      batch.count = 0;
+    }
+  }
+  if (batch.count > 0)
+    Lo += PBRKernel::evaluate(surface, batch);
+  Lo += vec3f{surface.albedo[0], surface.albedo[1], surface.albedo[2]} * 0.03f;
+
+  // Saturação e correção gama, como no shader.
+  auto gamma = [](float v) { return std::pow(std::clamp(v, 0.0f, 1.0f), 1.0f / 2.2f); };
+  return Color{gamma(Lo.x), gamma(Lo.y), gamma(Lo.z)};
+}
+
+void SoftwareRenderer::drawBounds(const PBRActor* actor)
+{
+  static const int edges[12][2] = {
+    {0, 1}, {1, 3}, {3, 2}, {2, 0}, {4, 5}, {5, 7}, {7, 6}, {6, 4}, {0, 4}, {1, 5}, {2, 6}, {3, 7}
+  };
+
+  const int W = _viewport.w;
+  const int H = _viewport.h;
+  const Bounds3f bounds = actor->bounds();
+  const vec3f lo = bounds.min();
+  const vec3f hi = bounds.max();
+  ClipVertex corners[8];
+
+  for (int i = 0; i < 8; ++i)
+  {
+    vec3f p{i & 1 ? hi.x : lo.x, i & 2 ? hi.y : lo.y, i & 4 ? hi.z : lo.z};
+    transform(_viewProjection, p, corners[i]);
+  }
+  for (const auto& edge : edges)
+  {
+    ClipVertex a = corners[edge[0]];
+    ClipVertex b = corners[edge[1]];
+    float da = a.z + a.w;
+    float db = b.z + b.w;
+
+    // Recorte no plano near.
+    if (da < 0 && db < 0)
+      continue;
+    if (da < 0)
+      a = lerp(a, b, da / (da - db));
+    else if (db < 0)
+      b = lerp(b, a, db / (db - da));
+
+    float x0 = (a.x / a.w * 0.5f + 0.5f) * W, y0 = (a.y / a.w * 0.5f + 0.5f) * H;
+    float x1 = (b.x / b.w * 0.5f + 0.5f) * W, y1 = (b.y / b.w * 0.5f + 0.5f) * H;
+    int steps = (int)std::ceil(std::max(std::abs(x1 - x0), std::abs(y1 - y0)));
+
+    // Limita o traçado de arestas que se estendem muito além da tela.
+    steps = std::min(steps, 4 * (W + H));
+    for (int s = 0; s <= steps; ++s)
+    {
+      float u = steps > 0 ? (float)s / steps : 0;
+      int x = (int)(x0 + (x1 - x0) * u);
+      int y = (int)(y0 + (y1 - y0) * u);
+
+      if (x >= 0 && x < W && y >= 0 && y < H)
+        (*_color)(x, y).set(Color{1.0f, 1.0f, 0.0f});
+    }
+  }
+}
+
+}
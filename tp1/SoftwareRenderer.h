@@ -0,0 +1,116 @@
+#pragma once
+
+#include "graphics/Camera.h"
+#include "graphics/Image.h"
+#include "Scene.h"
+#include "SceneSnapshot.h"
+#include <memory>
+#include <vector>
+
+namespace cg
+{
+
+// Rasterizador em CPU com a mesma interface do PBRRenderer: prévia da cena sem contexto OpenGL
+// (máquinas headless e CI) e referência para o caminho GL.
+// O quadro é feito em duas etapas paralelas: (1) as malhas dos atores são transformadas, recortadas
+// no plano near, descartadas por face traseira (CCW é frente, como em MainWindow) e distribuídas
+// em tiles de tileSize x tileSize pixels; (2) cada tile resolve a visibilidade com funções de aresta
+// avaliadas 4 pixels por vez (SSE) e teste de profundidade GL_LESS, e então sombreia uma única vez
+// cada pixel visível com o BRDF do pbrFragmentShader (PBRKernel), sem o limite de 3 luzes do shader.
+class SoftwareRenderer
+{
+public:
+  static constexpr int tileSize = 64;
+
+  SoftwareRenderer(Scene& scene, Camera& camera);
+
+  // Rasteriza a cena no buffer de cor.
+  void render();
+
+  // Rasteriza a cena e envia o buffer de cor para a imagem.
+  void render(Image* image);
+
+  Scene* scene() const { return _scene; }
+  Camera* camera() const { return _camera; }
+
+  void setImageSize(int width, int height)
+  {
+    _viewport.w = width;
+    _viewport.h = height;
+  }
+
+  // Ator destacado com sua AABB em wireframe.
+  void setSelectedActor(PBRActor* actor) { _selectedActor = actor; }
+
+  // Resultado do último quadro (linha 0 na base da imagem, como no OpenGL).
+  const ImageBuffer* colorBuffer() const { return _color.get(); }
+
+  // Profundidade em [0, 1] por pixel (1 onde não há geometria).
+  const std::vector<float>& depthBuffer() const { return _depth; }
+
+  // Triângulos que chegaram à rasterização no último quadro.
+  int triangleCount() const { return _triangleCount; }
+
+private:
+  struct Viewport
+  {
+    int w, h;
+  };
+
+  // Triângulo em espaço de tela pronto para a rasterização.
+  struct Triangle
+  {
+    float a[3], b[3], c[3]; // Funções de aresta E_i(x, y) = a_i x + b_i y + c_i (> 0 no interior)
+    float invArea;          // Normaliza E_i em coordenadas baricêntricas
+    bool inclusive[3];      // Regra top-left: pixels sobre a aresta pertencem ao triângulo
+    float za, zb, zc;       // Plano de profundidade
+    float invW[3];
+    vec3f position[3];      // Posições e normais no mundo (interpolação com correção de perspectiva)
+    vec3f normal[3];
+    int actor;              // Índice em SceneSnapshot::actors
+    int x0, y0, x1, y1;     // Pixels cobertos pela caixa do triângulo
+  };
+
+  // Triângulos preparados por uma thread e seus índices por tile, na ordem de desenho.
+  struct Bin
+  {
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<int>> tiles;
+  };
+
+  struct Light
+  {
+    vec3f position;
+    Color color;
+    int falloff;
+  };
+
+  Scene* _scene;
+  Camera* _camera;
+  Viewport _viewport;
+  PBRActor* _selectedActor = nullptr;
+
+  // Estado do quadro.
+  SceneSnapshot _snapshot;
+  std::vector<Light> _lights;
+  std::vector<Bin> _bins;
+  mat4f _viewProjection;
+  vec3f _eye;
+  int _tilesX = 0, _tilesY = 0;
+  std::unique_ptr<ImageBuffer> _color;
+  std::vector<float> _depth;
+  int _triangleCount = 0;
+
+  // Transforma, recorta e distribui nos tiles os triângulos dos atores [begin, end).
+  void setup(int begin, int end, Bin& bin) const;
+
+  // Resolve a visibilidade e sombreia o tile.
+  void rasterize(int tile);
+
+  Color shade(const Triangle& t, float x, float y) const;
+
+  // Desenha as arestas da AABB do ator sobre o buffer de cor.
+  void drawBounds(const PBRActor* actor);
+};
+
+}
@@ -19,7 +19,6 @@ public:
     _radius{radius},
     _subdivisions{subdivisions}
   {
-    generateMesh();
   }
 
   float radius() const { return _radius; }
@@ -76,7 +75,7 @@ protected:
   int _subdivisions;
 
   // Gera a malha poligonal via subdivisão recursiva de um icosaedro.
-  void generateMesh() override
+  TriangleMesh* generateMesh() const override
   {
     const int powerOf4 = 1 << (_subdivisions * 2); // 4^subdivisões
     const int expectedVertices = 10 * powerOf4 + 2;
@@ -181,7 +180,7 @@ protected:
       triangleArray
     };
 
-    _mesh = new TriangleMesh{std::move(data)};
+    return new TriangleMesh{std::move(data)};
   }
 };
 
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "Scene.h"
+#include "graphics/Light.h"
+#include "PBRActor.h"
+#include "ShapeCache.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace cg
+{
+
+// Gerador procedural de cenas de estresse (10^3 a 10^6 atores) para medir a escalabilidade do RayCaster.
+// Formas e materiais vêm de conjuntos pequenos e compartilhados, de modo que o custo de memória
+// por ator é basicamente o do próprio PBRActor.
+class StressSceneBuilder
+{
+public:
+  // Distribuição espacial dos atores.
+  enum class Distribution
+  {
+    Uniform,   // Uniforme em um cubo de densidade constante
+    Clustered, // Aglomerados gaussianos
+    Floor      // Um plano enorme com muitos objetos pequenos sobre ele
+  };
+
+  // Conjunto de materiais sorteados para os atores.
+  enum class MaterialMix
+  {
+    Dielectric,
+    Metal,
+    Mixed
+  };
+
+  struct Params
+  {
+    int actorCount = 1000;
+    Distribution distribution = Distribution::Uniform;
+    MaterialMix materials = MaterialMix::Mixed;
+    int lightCount = 3;
+    unsigned seed = 1;
+    float spacing = 4.0f;        // Distância média entre atores vizinhos
+    float sphereFraction = 0.5f; // Fração de esferas
+    float boxFraction = 0.4f;    // Fração de caixas (o restante são planos)
+  };
+
+  static Scene* build(const Params& p)
+  {
+    char name[64];
+    snprintf(name, sizeof(name), "Stress %s %d", distributionName(p.distribution), p.actorCount);
+
+    auto scene = new Scene{name};
+    std::mt19937 rng{p.seed};
+
+    scene->backgroundColor = Color::gray;
+    addLights(scene, p);
+    addActors(scene, p, rng);
+    return scene;
+  }
+
+  // Meia-aresta do volume ocupado pelos atores (usada para posicionar câmera e luzes).
+  static float extent(const Params& p)
+  {
+    if (p.distribution == Distribution::Floor)
+      return 0.5f * std::sqrt((float)p.actorCount) * p.spacing;
+    return 0.5f * std::cbrt((float)p.actorCount) * p.spacing;
+  }
+
+  static const char* distributionName(Distribution d)
+  {
+    switch (d)
+    {
+      case Distribution::Clustered: return "clustered";
+      case Distribution::Floor: return "floor";
+      default: return "uniform";
+    }
+  }
+
+  static const char* materialMixName(MaterialMix m)
+  {
+    switch (m)
+    {
+      case MaterialMix::Dielectric: return "dielectric";
+      case MaterialMix::Metal: return "metal";
+      default: return "mixed";
+    }
+  }
+
+  static bool parseDistribution(const char* s, Distribution& d)
+  {
+    for (auto v : {Distribution::Uniform, Distribution::Clustered, Distribution::Floor})
+      if (strcmp(s, distributionName(v)) == 0)
+      {
+        d = v;
+        return true;
+      }
+    return false;
+  }
+
+  static bool parseMaterialMix(const char* s, MaterialMix& m)
+  {
+    for (auto v : {MaterialMix::Dielectric, MaterialMix::Metal, MaterialMix::Mixed})
+      if (strcmp(s, materialMixName(v)) == 0)
+      {
+        m = v;
+        return true;
+      }
+    return false;
+  }
+
+private:
+  // Tamanhos discretos para que as formas sejam compartilhadas pelo ShapeCache.
+  static constexpr float shapeSizes[] = {0.5f, 0.75f, 1.0f, 1.5f};
+  static constexpr int sizeCount = sizeof(shapeSizes) / sizeof(float);
+  static constexpr int roughnessLevels = 4;
+
+  static void addLights(Scene* scene, const Params& p)
+  {
+    float e = extent(p);
+    int n = std::max(p.lightCount, 0);
+    float intensity = n > 0 ? std::min(1.0f, 2.0f / n) : 0;
+
+    // Luzes pontuais distribuídas em um círculo acima da cena.
+    for (int i = 0; i < n; ++i)
+    {
+      float angle = 2.0f * 3.14159265f * i / n;
+      char name[32];
+
+      snprintf(name, sizeof(name), "Light %d", i + 1);
+
+      auto light = new Light{};
+      light->setName(name);
+      light->setType(Light::Type::Point);
+      light->setPosition({e * std::cos(angle), 2.0f * e + 10.0f, e * std::sin(angle)});
+      light->color = Color{intensity, intensity, intensity};
+      light->falloff = Light::Falloff::Constant;
+      scene->addLight(light);
+    }
+  }
+
+  // Paleta de materiais compartilhados conforme a mistura escolhida.
+  static std::vector<Reference<PBRMaterial>> makeMaterials(MaterialMix mix)
+  {
+    static const Color dielectricColors[] = {
+      Color{0.8f, 0.2f, 0.2f}, Color{0.2f, 0.8f, 0.2f}, Color{0.2f, 0.2f, 0.8f},
+      Color{0.8f, 0.8f, 0.2f}, Color{0.8f, 0.2f, 0.8f}, Color{0.2f, 0.8f, 0.8f}
+    };
+
+    using MetalFactoryFunc = PBRMaterial*(*)(float);
+    static const MetalFactoryFunc metalFactories[] = {
+      &PBRMaterial::copper, &PBRMaterial::aluminum,
+      &PBRMaterial::silver, &PBRMaterial::titanium,
+      &PBRMaterial::gold
+    };
+
+    std::vector<Reference<PBRMaterial>> materials;
+
+    for (int i = 0; i < roughnessLevels; ++i)
+    {
+      float roughness = 0.1f + 0.8f * i / (roughnessLevels - 1);
+
+      if (mix != MaterialMix::Metal)
+        for (const auto& color : dielectricColors)
+          materials.push_back(PBRMaterial::dielectric(color, roughness));
+      if (mix != MaterialMix::Dielectric)
+        for (auto factory : metalFactories)
+          materials.push_back(factory(roughness));
+    }
+    return materials;
+  }
+
+  static void addActors(Scene* scene, const Params& p, std::mt19937& rng)
+  {
+    auto materials = makeMaterials(p.materials);
+    float e = extent(p);
+    int count = std::max(p.actorCount, 0);
+
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+    std::uniform_real_distribution<float> range{-e, e};
+    std::uniform_int_distribution<int> pickSize{0, sizeCount - 1};
+    std::uniform_int_distribution<int> pickMaterial{0, (int)materials.size() - 1};
+
+    // Centros e dispersão dos aglomerados.
+    std::vector<vec3f> clusters;
+    float sigma = 0;
+
+    if (p.distribution == Distribution::Clustered)
+    {
+      int k = std::max(4, (int)std::sqrt((float)count) / 8);
+
+      for (int i = 0; i < k; ++i)
+        clusters.push_back(vec3f{range(rng), range(rng), range(rng)});
+      sigma = e / (2.0f * std::cbrt((float)k));
+    }
+    std::normal_distribution<float> gauss{0.0f, std::max(sigma, 1e-3f)};
+    std::uniform_int_distribution<int> pickCluster{0, std::max((int)clusters.size() - 1, 0)};
+
+    if (p.distribution == Distribution::Floor)
+    {
+      auto actor = new PBRActor{"Floor", ShapeCache::plane(8.0f * e, 8.0f * e),
+        new PBRMaterial{Color{0.6f, 0.6f, 0.6f}, Color{1.0f, 1.0f, 1.0f}, 0.6f, 0.0f}};
+
+      actor->setPosition({0.0f, -0.01f, 0.0f});
+      scene->addActor(actor);
+      --count;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+      float size = shapeSizes[pickSize(rng)];
+      float u = unit(rng);
+      Shape3* shape;
+      char prefix;
+      float halfHeight;
+
+      if (u < p.sphereFraction)
+      {
+        shape = ShapeCache::sphere(size * 0.5f, 1);
+        prefix = 'S';
+        halfHeight = size * 0.5f;
+      }
+      else if (u < p.sphereFraction + p.boxFraction)
+      {
+        shape = ShapeCache::box(size);
+        prefix = 'B';
+        halfHeight = size * 0.5f;
+      }
+      else
+      {
+        shape = ShapeCache::plane(size, size);
+        prefix = 'P';
+        halfHeight = 0;
+      }
+
+      vec3f position;
+
+      switch (p.distribution)
+      {
+        case Distribution::Clustered:
+        {
+          const vec3f& c = clusters[pickCluster(rng)];
+          position = c + vec3f{gauss(rng), gauss(rng), gauss(rng)};
+          break;
+        }
+        case Distribution::Floor:
+          position = vec3f{range(rng), halfHeight + 0.01f, range(rng)};
+          break;
+        default:
+          position = vec3f{range(rng), range(rng), range(rng)};
+      }
+
+      char name[32];
+      snprintf(name, sizeof(name), "%c_%d", prefix, i);
+
+      auto actor = new PBRActor{name, shape, materials[pickMaterial(rng)]};
+      actor->setPosition(position);
+      scene->addActor(actor);
+    }
+  }
+};
+
+}
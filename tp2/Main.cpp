@@ -32,10 +32,14 @@
 
 #include "graphics/Application.h"
 #include "MainWindow.h"
+#include "reader/LexerBench.h"
 
 int
 main(int argc, char** argv)
 {
+  // Headless scene lexer benchmark: tp2 --lexbench [file] [--iterations n]
+  if (cg::util::LexerBench::requested(argc, argv))
+    return cg::util::LexerBench::run(argc, argv);
   puts("Ds Demo Version 1.4 by Paulo Pagliosa (ppagliosa@gmail.com)\n");
   return cg::Application{new MainWindow{1280, 720}}.run(argc, argv);
 }
@@ -35,6 +35,7 @@
 #include "reader/SceneReader.h"
 #include "SceneWriter.h"
 #include "MainWindow.h"
+#include "TraceRecorder.h"
 
 
 /////////////////////////////////////////////////////////////////////
@@ -142,6 +143,9 @@ MainWindow::readScene(const std::string& filename) try
 {
   util::SceneReader reader;
 
+  reader.setCacheMode((util::SceneReader::CacheMode)_sceneCacheMode);
+  reader.setCacheIncludes(_cacheIncludes);
+  reader.setParallelIncludes(_parallelIncludes);
   reader.setInput(filename);
   reader.execute();
   if (reader.scene() != nullptr)
@@ -188,6 +192,18 @@ MainWindow::fileMenu()
       openSceneCommand();
       ImGui::EndMenu();
     }
+    if (ImGui::BeginMenu("Scene Cache"))
+    {
+      static const char* cacheLabels[]{"Off", "On", "Verify"};
+
+      for (auto i = 0; i < IM_ARRAYSIZE(cacheLabels); ++i)
+        if (ImGui::MenuItem(cacheLabels[i], nullptr, _sceneCacheMode == i))
+          _sceneCacheMode = i;
+      ImGui::Separator();
+      ImGui::MenuItem("Cache Includes", nullptr, &_cacheIncludes);
+      ImGui::MenuItem("Parallel Includes", nullptr, &_parallelIncludes);
+      ImGui::EndMenu();
+    }
     ImGui::Separator();
     if (ImGui::MenuItem("Save"))
       saveScene();
@@ -286,11 +302,43 @@ MainWindow::mainMenu()
         4);
       ImGui::Checkbox("Use Jitter", &_useJitter);
       ImGui::Separator();
+      ImGui::Checkbox("Primary Hits from Visibility Buffer",
+        &_useVisibilityBuffer);
+      ImGui::Separator();
       ImGui::DragFloat("Scene IOR",
         &_sceneIOR,
         0.01f,
         1.0f,
         5.0f);
+      if (Profiler::enabled)
+      {
+        ImGui::Separator();
+        if (ImGui::MenuItem("Save Render Profile",
+          nullptr,
+          false,
+          _rayTracer != nullptr))
+          _rayTracer->profiler().writeJSON("profile.json");
+      }
+      ImGui::Separator();
+      ImGui::Checkbox("Cost-Guided Tile Order", &_tileScheduling);
+      ImGui::Checkbox("Record Cost Map", &_recordCostMap);
+      if (ImGui::MenuItem("Save Cost Map",
+        nullptr,
+        false,
+        _rayTracer != nullptr && !_rayTracer->costMap().empty()))
+        _rayTracer->costMap().write("cost");
+      ImGui::Separator();
+
+      auto& recorder = TraceRecorder::instance();
+
+      if (bool recording = recorder.recording();
+        ImGui::MenuItem("Record Timeline", nullptr, &recording))
+        recording ? recorder.start() : recorder.stop();
+      if (ImGui::MenuItem("Save Timeline"))
+      {
+        recorder.stop();
+        recorder.writeJSON("timeline.json");
+      }
       ImGui::EndMenu();
     }
     if (ImGui::BeginMenu("Tools"))
@@ -367,7 +415,10 @@ MainWindow::renderScene()
     _rayTracer->setAdaptiveThreshold(_adaptiveThreshold);
     _rayTracer->setMaxSubdivisionLevel(_maxSubdivisionLevel);
     _rayTracer->setUseJitter(_useJitter);
+    _rayTracer->setUseVisibilityBuffer(_useVisibilityBuffer);
     _rayTracer->setSceneIOR(_sceneIOR);
+    _rayTracer->setCostMapEnabled(_recordCostMap);
+    _rayTracer->setTileScheduling(_tileScheduling);
     _rayTracer->renderImage(*_image);
   }
   _image->draw(0, 0);
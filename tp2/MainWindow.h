@@ -72,7 +72,13 @@ private:
   float _adaptiveThreshold{0.1f};
   int _maxSubdivisionLevel{2};
   bool _useJitter{false};
+  bool _useVisibilityBuffer{false};
   float _sceneIOR{1.0f};
+  bool _recordCostMap{false};
+  bool _tileScheduling{false};
+  int _sceneCacheMode{0}; // util::SceneReader::CacheMode::Off
+  bool _cacheIncludes{false};
+  bool _parallelIncludes{false};
 
   static MeshMap _defaultMeshes;
 
@@ -33,11 +33,15 @@
 #include "graphics/Camera.h"
 #include "utils/Stopwatch.h"
 #include "RayTracer.h"
+#include "TraceRecorder.h"
 #include <iostream>
 #include <vector>
 #include <cmath>
 #include <cstdlib>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 
@@ -54,9 +58,21 @@ printElapsedTime(const char* s, Stopwatch::ms_time time)
 }
 
 inline auto
-arand()
+arand(minstd_rand& rng)
 {
-  return ((float)rand() / RAND_MAX / 4.0f) - 0.125f;
+  return uniform_real_distribution<float>{-0.125f, 0.125f}(rng);
+}
+
+// Jitter seed of pixel (x, y): the samples of a pixel do not depend on
+// the thread, nor on the tile, that renders it
+inline auto
+jitterSeed(int x, int y)
+{
+  auto s = ((uint64_t)(uint32_t)y << 32 | (uint32_t)x) + 0x9e3779b97f4a7c15ull;
+
+  s = (s ^ (s >> 30)) * 0xbf58476d1ce4e5b9ull;
+  s = (s ^ (s >> 27)) * 0x94d049bb133111ebull;
+  return uint32_t(s ^ (s >> 31));
 }
 
 inline auto
@@ -100,7 +116,8 @@ RayTracer::update()
   auto np = uint32_t(0);
 
   primitives.reserve(_scene->actorCount());
-  for (auto actor : _scene->actors())
+  _primitives.clear();
+  for (const auto& actor : _scene->actors())
     if (actor->visible)
     {
       auto p = actor->mapper()->primitive();
@@ -109,10 +126,22 @@ RayTracer::update()
       if (p->canIntersect())
       {
         primitives.push_back(p);
+        _primitives.push_back(p);
         np++;
       }
     }
-  _bvh = new PrimitiveBVH{move(primitives)};
+  {
+    CG_PROFILE_SCOPE(_profiler, Profiler::BVHBuild);
+    CG_TRACE_SCOPE("BVH build", "scene", "primitives", np);
+    _bvh = new PrimitiveBVH{move(primitives)};
+  }
+
+  // Snapshot of the turned-on lights: shade() runs once per hit and
+  // iterates raw pointers, without touching reference counts
+  _lights.clear();
+  for (const auto& light : _scene->lights())
+    if (light->isTurnedOn())
+      _lights.push_back(light);
 }
 
 void
@@ -126,6 +155,7 @@ RayTracer::renderImage(Image& image)
 {
   Stopwatch timer;
 
+  _profiler.beginFrame();
   update();
   timer.start();
   {
@@ -165,105 +195,350 @@ RayTracer::renderImage(Image& image)
   _pixelRay.tMin = F;
   _pixelRay.tMax = B;
   _pixelRay.set(_camera->position(), -_vrc.n);
-  _numberOfRays = _numberOfHits = 0;
-  scan(image);
+  _numberOfRays = _numberOfHits = _numberOfPrimaryLookups = 0;
+  if (_costMapEnabled)
+    _costMap.resize(w, h);
+  setVisibilityBuffer();
+
+  ImageBuffer frame{w, h};
+
+  scan(frame);
+  {
+    CG_PROFILE_SCOPE(_profiler, Profiler::ImageUpload);
+    CG_TRACE_SCOPE("image upload", "render");
+    image.setData(frame);
+  }
 
   auto et = timer.time();
 
   cout << "\nNumber of rays: " << _numberOfRays;
   cout << "\nNumber of hits: " << _numberOfHits;
+  if (_visibilityReady)
+  {
+    cout << "\nVisibility buffer triangles: " << _visibility.triangleCount();
+    cout << "\nPrimary rays not traced: " << _numberOfPrimaryLookups;
+  }
+  _visibility.clear();
   printElapsedTime("\nDONE! ", et);
+  _profiler.endFrame();
+  if (Profiler::enabled)
+    _profiler.printSummary();
+}
+
+void
+RayTracer::setVisibilityBuffer()
+{
+  _visibilityReady = false;
+  if (!_useVisibilityBuffer || _useJitter)
+    return;
+
+  VisibilityBuffer::View view;
+
+  view.eye = _camera->position();
+  view.u = _vrc.u;
+  view.v = _vrc.v;
+  view.n = _vrc.n;
+  view.Vw = _Vw;
+  view.Vh = _Vh;
+  view.nearPlane = _camera->nearPlane();
+  view.tMin = _pixelRay.tMin;
+  view.perspective = _camera->projectionType() == Camera::Perspective;
+  view.width = _viewport.w;
+  view.height = _viewport.h;
+
+  CG_PROFILE_SCOPE(_profiler, Profiler::PrimaryTraversal);
+  _visibilityReady = _visibility.setup(_primitives,
+    view,
+    _maxSubdivisionLevel);
+  if (!_visibilityReady)
+    cout << "Visibility buffer disabled: primitive without triangle mesh\n";
+}
+
+void
+RayTracer::rasterizeRow(Context& c, const Tile& tile, int j)
+{
+  if (_visibilityReady)
+  {
+    CG_PROFILE_SCOPE(_profiler, Profiler::PrimaryTraversal);
+    c.visibility.rasterize(_visibility, j, tile.x, tile.x + tile.w);
+  }
 }
 
 void
-RayTracer::setPixelRay(float x, float y)
+RayTracer::setPixelRay(Context& c, float x, float y)
 {
+  CG_PROFILE_SAMPLED_SCOPE(_profiler, Profiler::RayGeneration);
+
   auto p = imageToWindow(x, y);
 
   switch (_camera->projectionType())
   {
     case Camera::Perspective:
-      _pixelRay.direction = (p - _camera->nearPlane() * _vrc.n).versor();
+      c.pixelRay.direction = (p - _camera->nearPlane() * _vrc.n).versor();
       break;
 
     case Camera::Parallel:
-      _pixelRay.origin = _camera->position() + p;
+      c.pixelRay.origin = _camera->position() + p;
       break;
   }
 }
 
 void
-RayTracer::scan(Image& image)
+RayTracer::scan(ImageBuffer& frame)
+//[]---------------------------------------------------[]
+//|  Render the tiles of the image in parallel          |
+//|  @param frame: pixels of the image (output)         |
+//[]---------------------------------------------------[]
 {
   int w = _viewport.w;
   int h = _viewport.h;
-  ImageBuffer scanLine{w, 1};
+  auto columns = (w + tileSize - 1) / tileSize;
+  auto rows = (h + tileSize - 1) / tileSize;
+  auto n = max(1u, thread::hardware_concurrency());
+  vector<Tile> tiles;
+
+  if (_tileScheduling && columns == _tileColumns && rows == _tileRows)
+    scheduleTiles(tiles, n);
+  else
+    for (auto y = 0; y < h; y += tileSize)
+      for (auto x = 0; x < w; x += tileSize)
+        tiles.push_back({x, y, min(tileSize, w - x), min(tileSize, h - y)});
+
+  vector<float> times(tiles.size());
+  atomic<size_t> next{0};
+  atomic<size_t> done{0};
+  mutex lock;
+  auto worker = [&]()
+  {
+    Context c;
+
+    c.pixelRay = _pixelRay;
+    for (size_t k; (k = next++) < tiles.size();)
+    {
+      auto start = chrono::steady_clock::now();
+
+      renderTile(c, tiles[k], frame);
+
+      chrono::duration<float, milli> t = chrono::steady_clock::now() - start;
+
+      times[k] = t.count();
+      printf("Rendering tile %zu of %zu\r", ++done, tiles.size());
+    }
+
+    lock_guard guard{lock};
+
+    _numberOfRays += c.numberOfRays;
+    _numberOfHits += c.numberOfHits;
+    _numberOfPrimaryLookups += c.numberOfPrimaryLookups;
+  };
+
+  // The calling thread renders tiles too
+  vector<thread> threads;
+
+  for (auto i = 1u; i < n; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (auto& t : threads)
+    t.join();
+
+  // Split tiles are charged to the cell they came from
+  _tileColumns = columns;
+  _tileRows = rows;
+  _tileTimes.assign((size_t)columns * rows, 0.0f);
+  for (size_t k = 0; k < tiles.size(); ++k)
+  {
+    const auto& t = tiles[k];
+
+    _tileTimes[(t.y / tileSize) * columns + t.x / tileSize] += times[k];
+  }
+}
+
+void
+RayTracer::scheduleTiles(vector<Tile>& tiles, unsigned threadCount) const
+//[]---------------------------------------------------[]
+//|  Queue of tiles ordered by the time of the last     |
+//|  image (longest processing time first)              |
+//|  @param tiles: queue of tiles (output)              |
+//|  @param threadCount: number of render threads       |
+//[]---------------------------------------------------[]
+{
+  struct Entry
+  {
+    Tile tile;
+    float time;
+
+  };
+
+  auto total = 0.0f;
+
+  for (auto t : _tileTimes)
+    total += t;
+
+  // The time of a cell is assumed to be evenly spread over its pixels
+  auto limit = total / threadCount * _tileSplitThreshold;
+  vector<Entry> queue;
+  auto split = [&](auto& self, const Tile& t, float time) -> void
+  {
+    if (time <= limit || t.w < 2 * minTileSize || t.h < 2 * minTileSize)
+    {
+      queue.push_back({t, time});
+      return;
+    }
+
+    auto hw = t.w / 2;
+    auto hh = t.h / 2;
+    auto area = float(t.w * t.h);
+
+    for (const Tile& q : {Tile{t.x, t.y, hw, hh},
+      Tile{t.x + hw, t.y, t.w - hw, hh},
+      Tile{t.x, t.y + hh, hw, t.h - hh},
+      Tile{t.x + hw, t.y + hh, t.w - hw, t.h - hh}})
+      self(self, q, time * (q.w * q.h) / area);
+  };
+  int w = _viewport.w;
+  int h = _viewport.h;
+
+  for (auto y = 0; y < h; y += tileSize)
+    for (auto x = 0; x < w; x += tileSize)
+    {
+      Tile t{x, y, min(tileSize, w - x), min(tileSize, h - y)};
+
+      split(split, t, _tileTimes[(y / tileSize) * _tileColumns + x / tileSize]);
+    }
+  stable_sort(queue.begin(), queue.end(), [](const Entry& a, const Entry& b)
+  {
+    return a.time > b.time;
+  });
+  tiles.clear();
+  tiles.reserve(queue.size());
+  for (const auto& e : queue)
+    tiles.push_back(e.tile);
+}
+
+void
+RayTracer::renderTile(Context& c, const Tile& tile, ImageBuffer& frame)
+//[]---------------------------------------------------[]
+//|  Render a tile                                      |
+//|  @param per-thread state of the render              |
+//|  @param the tile                                    |
+//|  @param pixels of the image (output)                |
+//[]---------------------------------------------------[]
+{
+  // One clock read per tile; the rays are timed in a sample of the pixels
+  CG_PROFILE_SCOPE(_profiler, Profiler::Render);
+  CG_TRACE_SCOPE("tile", "render", "x", tile.x, "y", tile.y);
 
   // Standard non-adaptive scan
   if (_maxSubdivisionLevel == 0)
   {
-    for (auto j = 0; j < h; j++)
+    for (auto j = tile.y; j < tile.y + tile.h; j++)
     {
       auto y = (float)j + 0.5f;
 
-      printf("Scanning line %d of %d\r", j + 1, h);
-      for (auto i = 0; i < w; i++)
-        scanLine[i] = shoot((float)i + 0.5f, y);
-      image.setData(0, j, scanLine);
+      rasterizeRow(c, tile, j);
+      for (auto i = tile.x; i < tile.x + tile.w; i++)
+      {
+        CG_PROFILE_PIXEL(_profiler);
+        beginPixel(c);
+        frame(i, j) = shoot(c, (float)i + 0.5f, y);
+        endPixel(c, i, j);
+      }
     }
     return;
   }
 
   // Adaptive Supersampling
   const int steps = 1 << _maxSubdivisionLevel;
-  _lineBuffer.resize(w * steps + 1);
+  auto& lineBuffer = c.lineBuffer;
+  auto& window = c.window;
+
+  lineBuffer.resize(tile.w * steps + 1);
   
   // Initialize line buffer as Raw
-  for (auto& p : _lineBuffer) 
+  for (auto& p : lineBuffer) 
     p.cooked = false;
 
-  for (auto j = 0; j < h; j++)
+  for (auto j = tile.y; j < tile.y + tile.h; j++)
   {
-    printf("Scanning line %d of %d\r", j + 1, h);
+    rasterizeRow(c, tile, j);
 
     // Reset Left edge of the window to Raw at start of line
     for(int wy = 0; wy <= steps; ++wy)
-      _window[wy][0].cooked = false;
+      window[wy][0].cooked = false;
 
-    for (auto i = 0; i < w; i++)
+    for (auto i = 0; i < tile.w; i++)
     {
+      CG_PROFILE_PIXEL(_profiler);
+
       for (int wx = 0; wx <= steps; ++wx)
       {
         int bufferIndex = i * steps + wx;
-        if (bufferIndex < (int)_lineBuffer.size())
-          _window[0][wx] = _lineBuffer[bufferIndex];
+        if (bufferIndex < (int)lineBuffer.size())
+          window[0][wx] = lineBuffer[bufferIndex];
       }
 
       for (int wy = 1; wy <= steps; ++wy)
         for (int wx = 1; wx <= steps; ++wx)
-          _window[wy][wx].cooked = false;
+          window[wy][wx].cooked = false;
 
       // Compute pixel color using adaptive function
-      scanLine[i] = adapt(0, 0, steps, (float)i, (float)j);
+      auto x = tile.x + i;
 
-      for (int wx = 0; wx <= steps; ++wx)
+      beginPixel(c);
+      if (_useJitter)
+        c.rng.seed(jitterSeed(x, j));
+      frame(x, j) = adapt(c, 0, 0, steps, (float)x, (float)j);
+      endPixel(c, x, j);
+
+      // The bottom-right corner is the top-left one of the next pixel,
+      // which reads it from the line buffer
+      auto last = i + 1 < tile.w ? steps - 1 : steps;
+
+      for (int wx = 0; wx <= last; ++wx)
       {
         int bufferIndex = i * steps + wx;
-        if (bufferIndex < (int)_lineBuffer.size())
-          _lineBuffer[bufferIndex] = _window[steps][wx];
+        if (bufferIndex < (int)lineBuffer.size())
+          lineBuffer[bufferIndex] = window[steps][wx];
       }
 
       for (int wy = 0; wy <= steps; ++wy)
-        _window[wy][0] = _window[wy][steps];
+        window[wy][0] = window[wy][steps];
     }
-    image.setData(0, j, scanLine);
+  }
+}
+
+inline void
+RayTracer::beginPixel(Context& c)
+{
+  if (_costMapEnabled)
+  {
+    c.cost = {};
+    c.pixelStart = chrono::steady_clock::now();
+  }
+}
+
+inline void
+RayTracer::endPixel(Context& c, int x, int y)
+//[]---------------------------------------------------[]
+//|  Add the cost of a pixel to the cost map            |
+//|  @param per-thread state of the render              |
+//|  @param x, y: coordinates of the pixel              |
+//[]---------------------------------------------------[]
+{
+  if (_costMapEnabled)
+  {
+    chrono::duration<float, nano> t = chrono::steady_clock::now() - c.pixelStart;
+
+    // Each pixel is rendered by a single thread
+    _costMap.add(x, y, c.cost, t.count());
   }
 }
 
 Color
-RayTracer::adapt(int i, int j, int step, float x, float y)
+RayTracer::adapt(Context& c, int i, int j, int step, float x, float y)
 //[]---------------------------------------------------[]
 //|  Adaptative recursive sampling                        |
+//|  @param per-thread state of the render              |
 //|  @param i, j: top-left index in the sliding window  |
 //|  @param step: current step size in window indices   |
 //|  @param x, y: origin coordinates of the pixel       |
@@ -287,7 +562,7 @@ RayTracer::adapt(int i, int j, int step, float x, float y)
     int wi = coords[k][0];
     int wj = coords[k][1];
     
-    GridPoint& p = _window[wj][wi];
+    GridPoint& p = c.window[wj][wi];
 
     if (!p.cooked)
     {
@@ -295,10 +570,10 @@ RayTracer::adapt(int i, int j, int step, float x, float y)
       float offsetY = (float)wj * invMaxSteps;
 
       // Apply Jitter if needed.
-      float jx = _useJitter ? arand() : 0.0f;
-      float jy = _useJitter ? arand() : 0.0f;
+      float jx = _useJitter ? arand(c.rng) : 0.0f;
+      float jy = _useJitter ? arand(c.rng) : 0.0f;
 
-      p.color = shoot(x + offsetX + jx, y + offsetY + jy);
+      p.color = shoot(c, x + offsetX + jx, y + offsetY + jy);
       p.cooked = true;
     }
     colors[k] = p.color;
@@ -324,10 +599,10 @@ RayTracer::adapt(int i, int j, int step, float x, float y)
   if (subdivide)
   {
     int newStep = step / 2;
-    Color c1 = adapt(i, j, newStep, x, y);
-    Color c2 = adapt(i + newStep, j, newStep, x, y);
-    Color c3 = adapt(i, j + newStep, newStep, x, y);
-    Color c4 = adapt(i + newStep, j + newStep, newStep, x, y);
+    Color c1 = adapt(c, i, j, newStep, x, y);
+    Color c2 = adapt(c, i + newStep, j, newStep, x, y);
+    Color c3 = adapt(c, i, j + newStep, newStep, x, y);
+    Color c4 = adapt(c, i + newStep, j + newStep, newStep, x, y);
     
     return (c1 + c2 + c3 + c4) * 0.25f;
   }
@@ -336,24 +611,45 @@ RayTracer::adapt(int i, int j, int step, float x, float y)
 }
 
 Color
-RayTracer::shoot(float x, float y)
+RayTracer::shoot(Context& c, float x, float y)
 //[]---------------------------------------------------[]
 //|  Shoot a pixel ray                                  |
+//|  @param per-thread state of the render              |
 //|  @param x coordinate of the pixel                   |
 //|  @param y cordinates of the pixel                   |
 //|  @return RGB color of the pixel                     |
 //[]---------------------------------------------------[]
 {
   // set pixel ray
-  setPixelRay(x, y);
+  setPixelRay(c, x, y);
+  ++c.cost.samples;
 
   // Initialize IOR stack with scene IOR
   vector<float> iorStack;
   iorStack.reserve(8);
   iorStack.push_back(_sceneIOR);
 
-  // trace pixel ray
-  Color color = trace(_pixelRay, 0, 1, iorStack);
+  // Find the first hit of the pixel ray in the visibility buffer or, if
+  // the buffer can't tell, by traversing the BVH
+  Color color;
+  Intersection hit;
+  bool found;
+
+  {
+    CG_PROFILE_SAMPLED_SCOPE(_profiler, Profiler::PrimaryTraversal);
+
+    auto h = primaryHit(c, x, y, hit);
+
+    if (h == PrimaryHit::Unknown)
+    {
+      ++c.numberOfRays;
+      ++c.cost.rays;
+      found = intersect(c, c.pixelRay, hit);
+    }
+    else
+      found = h == PrimaryHit::Hit;
+  }
+  color = found ? shade(c, c.pixelRay, hit, 0, 1, iorStack) : background();
 
   // adjust RGB color
   if (color.r > 1.0f) color.r = 1.0f;
@@ -363,10 +659,78 @@ RayTracer::shoot(float x, float y)
   return color;
 }
 
+RayTracer::PrimaryHit
+RayTracer::primaryHit(Context& c, float x, float y, Intersection& hit)
+//[]---------------------------------------------------[]
+//|  Primary hit from the visibility buffer             |
+//|  @param per-thread state of the render              |
+//|  @param x, y: image position of the pixel ray       |
+//|  @param information on intersection (output)        |
+//|  @return Hit, Miss or Unknown (the ray is traced)   |
+//[]---------------------------------------------------[]
+{
+  if (!_visibilityReady)
+    return PrimaryHit::Unknown;
+
+  auto s = c.visibility.sample(x, y);
+
+  if (s == nullptr)
+    return PrimaryHit::Unknown;
+  ++c.numberOfPrimaryLookups;
+  if (s->primitive == VisibilityBuffer::none)
+    return PrimaryHit::Miss;
+
+  // Exact ray/triangle intersection (Moller-Trumbore) with the visible
+  // triangle; samples the rasterizer and the ray disagree on are traced
+  auto primitive = _visibility.primitive(*s);
+  const auto& data = primitive->tesselate()->data();
+  const auto& m = primitive->localToWorldMatrix();
+  const auto* v = data.triangles[s->triangle].v;
+  auto p0 = m.transform3x4(data.vertices[v[0]]);
+  auto e1 = m.transform3x4(data.vertices[v[1]]) - p0;
+  auto e2 = m.transform3x4(data.vertices[v[2]]) - p0;
+  const auto& ray = c.pixelRay;
+  const auto& D = ray.direction;
+  auto pv = D.cross(e2);
+  auto det = e1.dot(pv);
+
+  if (math::isZero(det))
+  {
+    --c.numberOfPrimaryLookups;
+    return PrimaryHit::Unknown;
+  }
+
+  auto invDet = math::inverse(det);
+  auto tv = ray.origin - p0;
+  auto b1 = tv.dot(pv) * invDet;
+  auto qv = tv.cross(e1);
+  auto b2 = D.dot(qv) * invDet;
+  auto t = e2.dot(qv) * invDet;
+
+  if (b1 < 0 || b2 < 0 || b1 + b2 > 1 || t < ray.tMin)
+  {
+    --c.numberOfPrimaryLookups;
+    return PrimaryHit::Unknown;
+  }
+  if (t > ray.tMax)
+    return PrimaryHit::Miss;
+  hit.object = primitive;
+  hit.distance = t;
+  hit.triangleIndex = (int)s->triangle;
+  hit.p.set(1 - b1 - b2, b1, b2);
+  ++c.numberOfHits;
+  return PrimaryHit::Hit;
+}
+
 Color
-RayTracer::trace(const Ray3f& ray, uint32_t level, float weight, const vector<float>& iorStack)
+RayTracer::trace(Context& c,
+  const Ray3f& ray,
+  uint32_t level,
+  float weight,
+  const vector<float>& iorStack)
 //[]---------------------------------------------------[]
-//|  Trace a ray                                        |
+//|  Trace a reflection or refraction ray               |
+//|  @param per-thread state of the render              |
 //|  @param the ray                                     |
 //|  @param recursion level                             |
 //|  @param ray weight                                  |
@@ -376,17 +740,24 @@ RayTracer::trace(const Ray3f& ray, uint32_t level, float weight, const vector<fl
 {
   if (level > _maxRecursionLevel)
     return Color::black;
-  ++_numberOfRays;
+  ++c.numberOfRays;
+  ++c.cost.rays;
 
   Intersection hit;
+  bool found;
 
-  return intersect(ray, hit) ? shade(ray, hit, level, weight, iorStack) : background();
+  {
+    CG_PROFILE_SAMPLED_SCOPE(_profiler, Profiler::SecondaryTraversal);
+    found = intersect(c, ray, hit);
+  }
+  return found ? shade(c, ray, hit, level, weight, iorStack) : background();
 }
 
 bool
-RayTracer::intersect(const Ray3f& ray, Intersection& hit)
+RayTracer::intersect(Context& c, const Ray3f& ray, Intersection& hit)
 //[]---------------------------------------------------[]
 //|  Ray/object intersection                            |
+//|  @param per-thread state of the render              |
 //|  @param the ray (input)                             |
 //|  @param information on intersection (output)        |
 //|  @return true if the ray intersects an object       |
@@ -394,17 +765,19 @@ RayTracer::intersect(const Ray3f& ray, Intersection& hit)
 {
   hit.object = nullptr;
   hit.distance = ray.tMax;
-  return _bvh->intersect(ray, hit) ? ++_numberOfHits : false;
+  return _bvh->intersect(ray, hit) ? ++c.numberOfHits : false;
 }
 
 Color
-RayTracer::shade(const Ray3f& ray,
+RayTracer::shade(Context& c,
+  const Ray3f& ray,
   Intersection& hit,
   uint32_t level,
   float weight,
   const vector<float>& iorStack)
 //[]---------------------------------------------------[]
 //|  Shade a point P                                    |
+//|  @param per-thread state of the render              |
 //|  @param the ray (input)                             |
 //|  @param information on intersection (input)         |
 //|  @param recursion level                             |
@@ -413,6 +786,8 @@ RayTracer::shade(const Ray3f& ray,
 //|  @return color at point P                           |
 //[]---------------------------------------------------[]
 {
+  CG_PROFILE_SAMPLED_SCOPE(_profiler, Profiler::Shading);
+
   auto primitive = (Primitive*)hit.object;
 
   assert(nullptr != primitive);
@@ -439,11 +814,8 @@ RayTracer::shade(const Ray3f& ray,
   auto P = ray(hit.distance);
 
   // Compute direct lighting
-  for (auto light : _scene->lights())
+  for (auto light : _lights)
   {
-    // If the light is turned off, then continue
-    if (!light->isTurnedOn()) continue;
-
     vec3f L;
     float d;
 
@@ -457,10 +829,11 @@ RayTracer::shade(const Ray3f& ray,
 
     auto lightRay = Ray3f{P + L * rt_eps(), L};
     lightRay.tMax = d;
-    ++_numberOfRays;
+    ++c.numberOfRays;
+    ++c.cost.rays;
     
     // If the point P is shadowed, then continue
-    if (shadow(lightRay)) continue;
+    if (shadow(c, lightRay)) continue;
 
     auto lc = light->lightColor(d);
     color += lc * m->diffuse * NL;
@@ -480,7 +853,7 @@ RayTracer::shade(const Ray3f& ray,
     if (w > _minWeight && level < _maxRecursionLevel)
     {
       auto reflectionRay = Ray3f{P + R * rt_eps(), R};
-      color += m->specular * trace(reflectionRay, level + 1, w, iorStack);
+      color += m->specular * trace(c, reflectionRay, level + 1, w, iorStack);
     }
   }
   
@@ -535,7 +908,7 @@ RayTracer::shade(const Ray3f& ray,
             }
 
         auto refractionRay = Ray3f{P + T * rt_eps(), T};
-        color += m->transparency * trace(refractionRay, level + 1, w, nextStack);
+        color += m->transparency * trace(c, refractionRay, level + 1, w, nextStack);
       }
     }
   }
@@ -554,13 +927,16 @@ RayTracer::background() const
 }
 
 bool
-RayTracer::shadow(const Ray3f& ray)
+RayTracer::shadow(Context& c, const Ray3f& ray)
 //[]---------------------------------------------------[]
 //|  Verifiy if ray is a shadow ray                     |
+//|  @param per-thread state of the render              |
 //|  @param the ray (input)                             |
 //|  @return true if the ray intersects an object       |
 //[]---------------------------------------------------[]
 {
+  CG_PROFILE_SAMPLED_SCOPE(_profiler, Profiler::ShadowTraversal);
+
   Ray3f currentRay = ray;
   Intersection hit;
   
@@ -578,7 +954,7 @@ RayTracer::shadow(const Ray3f& ray)
       auto m = primitive->material();
       if (m->transparency == Color::black)
       {
-        ++_numberOfHits;
+        ++c.numberOfHits;
         return true;
       }
       float newTMin = hit.distance + rt_eps();
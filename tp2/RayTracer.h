@@ -37,8 +37,13 @@
 #include "graphics/Image.h"
 #include "graphics/PrimitiveBVH.h"
 #include "graphics/Renderer.h"
+#include "CostMap.h"
+#include "Profiler.h"
+#include "VisibilityBuffer.h"
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <random>
 
 namespace cg
 { // begin namespace cg
@@ -48,11 +53,26 @@ namespace cg
 //
 // RayTracer: simple ray tracer class
 // =========
+//
+// The image is split into tiles of tileSize x tileSize pixels, taken
+// from a shared queue by one thread per hardware thread. Each thread
+// renders into its own Context (pixel ray, sample window, visibility
+// buffer band and statistics); the scene, BVH and visibility buffer
+// triangles are read-only during the render.
+//
+// The time spent in every tile is kept for the next image. With cost
+// guided tile scheduling, the queue of the next image is sorted from
+// the most to the least expensive tile (longest processing time
+// first), and tiles whose predicted time is above a fraction of the
+// work of a thread are split into quadrants, so that no thread is left
+// alone with an expensive tile at the end of the image.
 class RayTracer: public Renderer
 {
 public:
   static constexpr auto minMinWeight = float(0.001);
   static constexpr auto maxMaxRecursionLevel = uint32_t(20);
+  static constexpr auto tileSize = 32;
+  static constexpr auto minTileSize = 8;
 
   RayTracer(SceneBase&, Camera&);
 
@@ -116,12 +136,77 @@ public:
     _sceneIOR = math::max(ior, 1.0f);
   }
 
+  auto useVisibilityBuffer() const
+  {
+    return _useVisibilityBuffer;
+  }
+
+  // Hybrid mode: primary hits are read from a visibility buffer made
+  // by rasterizing the primitive meshes instead of being traced. Not
+  // used with jitter, since jittered samples are off the lattice.
+  void setUseVisibilityBuffer(bool u)
+  {
+    _useVisibilityBuffer = u;
+  }
+
+  // Time spent in each stage of the last image: tiles are timed, their
+  // rays are counted per kind. The rasterization of the visibility
+  // buffer is charged to the primary traversal, whose work it replaces.
+  // Empty unless built with CG_PROFILE.
+  const Profiler& profiler() const
+  {
+    return _profiler;
+  }
+
+  auto tileScheduling() const
+  {
+    return _tileScheduling;
+  }
+
+  void setTileScheduling(bool s)
+  {
+    _tileScheduling = s;
+  }
+
+  auto tileSplitThreshold() const
+  {
+    return _tileSplitThreshold;
+  }
+
+  // Fraction of the predicted work of a thread above which a tile is
+  // split by the cost guided tile scheduling.
+  void setTileSplitThreshold(float t)
+  {
+    _tileSplitThreshold = math::clamp(t, 0.01f, 1.0f);
+  }
+
+  auto costMapEnabled() const
+  {
+    return _costMapEnabled;
+  }
+
+  void setCostMapEnabled(bool e)
+  {
+    _costMapEnabled = e;
+  }
+
+  // Samples, rays traced and time spent per pixel of the last image
+  // rendered with the cost map enabled. The BVH traversal is done by
+  // PrimitiveBVH, which does not count nodes and primitives: these
+  // channels are left empty.
+  const CostMap& costMap() const
+  {
+    return _costMap;
+  }
+
   void update() override;
   void render() override;
   virtual void renderImage(Image&);
 
 private:
   Reference<PrimitiveBVH> _bvh;
+  std::vector<const Light*> _lights; // turned-on lights, taken by update()
+  std::vector<Primitive*> _primitives; // primitives of the BVH
   struct VRC
   {
     vec3f u;
@@ -135,9 +220,23 @@ private:
   uint32_t _maxSubdivisionLevel{2};
   bool _useJitter{false};
   float _sceneIOR{1.0f};
+  bool _useVisibilityBuffer{false};
+  bool _visibilityReady{false};
+  VisibilityBuffer _visibility;
+  Profiler _profiler;
+  bool _costMapEnabled{false};
+  CostMap _costMap;
+  bool _tileScheduling{false};
+  float _tileSplitThreshold{0.05f};
+  // Time spent in each tileSize x tileSize cell of the last image, in
+  // ms (_tileColumns x _tileRows cells)
+  std::vector<float> _tileTimes;
+  int _tileColumns{};
+  int _tileRows{};
   uint64_t _numberOfRays;
   uint64_t _numberOfHits;
-  Ray3f _pixelRay;
+  uint64_t _numberOfPrimaryLookups;
+  Ray3f _pixelRay; // origin, direction and extent of the pixel rays
   float _Vh;
   float _Vw;
   float _Ih;
@@ -154,19 +253,56 @@ private:
     bool cooked; // true if ray has been traced
   };
 
-  std::vector<GridPoint> _lineBuffer;
-  GridPoint _window[WINDOW_DIM][WINDOW_DIM];
+  struct Tile
+  {
+    int x;
+    int y;
+    int w;
+    int h;
+
+  };
+
+  // Per-thread state of a render
+  struct Context
+  {
+    Ray3f pixelRay;
+    VisibilityBuffer::Band visibility;
+    std::vector<GridPoint> lineBuffer;
+    GridPoint window[WINDOW_DIM][WINDOW_DIM];
+    std::minstd_rand rng; // jitter, seeded per pixel
+    uint64_t numberOfRays{};
+    uint64_t numberOfHits{};
+    uint64_t numberOfPrimaryLookups{};
+    CostMap::Counters cost; // of the current pixel
+    std::chrono::steady_clock::time_point pixelStart;
+
+  };
+
+  enum class PrimaryHit
+  {
+    Hit,
+    Miss,
+    Unknown // must be traced
+
+  };
 
-  void scan(Image& image);
-  void setPixelRay(float x, float y);
-  Color shoot(float x, float y);
-  bool intersect(const Ray3f&, Intersection&);
-  Color trace(const Ray3f& ray, uint32_t level, float weight, const std::vector<float>& iorStack);
-  Color shade(const Ray3f& ray, Intersection& hit, uint32_t level, float weight, const std::vector<float>& iorStack);
-  bool shadow(const Ray3f&);
+  void scan(ImageBuffer& frame);
+  void scheduleTiles(std::vector<Tile>&, unsigned threadCount) const;
+  void renderTile(Context&, const Tile&, ImageBuffer& frame);
+  void beginPixel(Context&);
+  void endPixel(Context&, int x, int y);
+  void setVisibilityBuffer();
+  void rasterizeRow(Context&, const Tile&, int j);
+  void setPixelRay(Context&, float x, float y);
+  PrimaryHit primaryHit(Context&, float x, float y, Intersection&);
+  Color shoot(Context&, float x, float y);
+  bool intersect(Context&, const Ray3f&, Intersection&);
+  Color trace(Context&, const Ray3f& ray, uint32_t level, float weight, const std::vector<float>& iorStack);
+  Color shade(Context&, const Ray3f& ray, Intersection& hit, uint32_t level, float weight, const std::vector<float>& iorStack);
+  bool shadow(Context&, const Ray3f&);
   Color background() const;
   
-  Color adapt(int i, int j, int step, float x, float y);
+  Color adapt(Context&, int i, int j, int step, float x, float y);
 
   vec3f imageToWindow(float x, float y) const
   {
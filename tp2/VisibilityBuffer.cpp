@@ -0,0 +1,345 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: VisibilityBuffer.cpp
+// ========
+// Source file for visibility buffer.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+#include "geometry/TriangleMesh.h"
+#include "VisibilityBuffer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace cg
+{ // begin namespace cg
+
+namespace
+{ // begin namespace
+
+constexpr auto latticeEps = 1e-3f;
+
+inline vec3f
+lerp(const vec3f& a, const vec3f& b, float t)
+{
+  return a + (b - a) * t;
+}
+
+// Clips the triangle, in camera coordinates (x along u, y along v and
+// z along -n), against the plane z = zNear. Returns the number
+// of vertices of the clipped polygon (0, 3 or 4).
+int
+clipNear(const vec3f* in, vec3f* out, float zNear)
+{
+  int n = 0;
+
+  for (int i = 0; i < 3; ++i)
+  {
+    const auto& a = in[i];
+    const auto& b = in[(i + 1) % 3];
+    auto da = a.z - zNear;
+    auto db = b.z - zNear;
+
+    if (da >= 0)
+      out[n++] = a;
+    if ((da >= 0) != (db >= 0))
+      out[n++] = lerp(a, b, da / (da - db));
+  }
+  return n;
+}
+
+} // end namespace
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// VisibilityBuffer implementation
+// ================
+bool
+VisibilityBuffer::setup(const std::vector<Primitive*>& primitives,
+  const View& view,
+  uint32_t level)
+{
+  clear();
+  _steps = 1 << level;
+  _perspective = view.perspective;
+  if (level == 0)
+  {
+    _origin = 0.5f;
+    _columns = view.width;
+  }
+  else
+  {
+    _origin = 0;
+    _columns = view.width * _steps + 1;
+  }
+  _primitives = primitives;
+
+  // Points nearer than tMin along the pixel rays are not visible. In
+  // perspective, z >= tMin * cos(corner angle) keeps all the points whose
+  // distance to the eye may be greater than tMin; the remaining ones are
+  // rejected by the exact ray/triangle test of the ray tracer.
+  auto zNear = view.tMin;
+
+  if (_perspective)
+  {
+    auto hw = view.Vw * 0.5f;
+    auto hh = view.Vh * 0.5f;
+    auto n = view.nearPlane;
+
+    zNear *= n / std::sqrt(n * n + hw * hw + hh * hh);
+  }
+
+  for (uint32_t i = 0; i < (uint32_t)primitives.size(); ++i)
+  {
+    auto primitive = primitives[i];
+    auto mesh = primitive->tesselate();
+
+    if (mesh == nullptr)
+    {
+      clear();
+      return false;
+    }
+
+    const auto& data = mesh->data();
+    const auto& m = primitive->localToWorldMatrix();
+    std::vector<vec3f> vertices(data.vertexCount);
+
+    for (int k = 0; k < data.vertexCount; ++k)
+    {
+      auto q = m.transform3x4(data.vertices[k]) - view.eye;
+
+      vertices[k].set(q.dot(view.u), q.dot(view.v), -q.dot(view.n));
+    }
+    for (int t = 0; t < data.triangleCount; ++t)
+    {
+      const auto* v = data.triangles[t].v;
+      const vec3f in[3]{vertices[v[0]], vertices[v[1]], vertices[v[2]]};
+      vec3f polygon[4];
+      auto nv = clipNear(in, polygon, zNear);
+
+      for (int f = 1; f + 1 < nv; ++f)
+      {
+        const vec3f p[3]{polygon[0], polygon[f], polygon[f + 1]};
+
+        addTriangle(p, view, i, (uint32_t)t);
+      }
+    }
+  }
+  std::stable_sort(_triangles.begin(), _triangles.end(),
+    [](const Triangle& a, const Triangle& b) { return a.y0 < b.y0; });
+  _maxY1.resize(_triangles.size());
+  for (size_t k = 0; k < _triangles.size(); ++k)
+    _maxY1[k] = k ? std::max(_maxY1[k - 1], _triangles[k].y1) : _triangles[k].y1;
+  return true;
+}
+
+void
+VisibilityBuffer::addTriangle(const vec3f* p,
+  const View& view,
+  uint32_t primitive,
+  uint32_t triangle)
+{
+  // Lattice coordinates (lattice sample (i, j) at integer (i, j))
+  double sx[3], sy[3], sz[3];
+
+  for (int k = 0; k < 3; ++k)
+  {
+    auto X = p[k].x;
+    auto Y = p[k].y;
+
+    if (_perspective)
+    {
+      auto s = view.nearPlane / p[k].z;
+
+      X *= s;
+      Y *= s;
+      sz[k] = 1.0 / p[k].z;
+    }
+    else
+      sz[k] = p[k].z;
+    sx[k] = ((X / view.Vw + 0.5) * view.width - _origin) * _steps;
+    sy[k] = ((Y / view.Vh + 0.5) * view.height - _origin) * _steps;
+  }
+
+  // Both faces are visible to the ray tracer: make the triangle CCW
+  auto area = (sx[1] - sx[0]) * (sy[2] - sy[0]) -
+    (sx[2] - sx[0]) * (sy[1] - sy[0]);
+
+  if (area == 0 || !std::isfinite(area))
+    return;
+  if (area < 0)
+  {
+    std::swap(sx[1], sx[2]);
+    std::swap(sy[1], sy[2]);
+    std::swap(sz[1], sz[2]);
+    area = -area;
+  }
+
+  auto rows = _steps == 1 ? view.height : view.height * _steps + 1;
+  Triangle t;
+
+  t.x0 = std::max(0, (int)std::ceil(std::min({sx[0], sx[1], sx[2]})));
+  t.x1 = std::min(_columns - 1, (int)std::floor(std::max({sx[0], sx[1], sx[2]})));
+  t.y0 = std::max(0, (int)std::ceil(std::min({sy[0], sy[1], sy[2]})));
+  t.y1 = std::min(rows - 1, (int)std::floor(std::max({sy[0], sy[1], sy[2]})));
+  if (t.x0 > t.x1 || t.y0 > t.y1)
+    return;
+
+  auto invArea = 1 / area;
+  t.za = t.zb = 0;
+
+  for (int k = 0; k < 3; ++k)
+  {
+    auto a = (k + 1) % 3;
+    auto b = (k + 2) % 3;
+    auto dx = sx[b] - sx[a];
+    auto dy = sy[b] - sy[a];
+
+    // Shared edges are walked in opposite directions by the triangles
+    // that share them: exactly one of the two owns the samples on it
+    t.a[k] = sy[a] - sy[b];
+    t.b[k] = dx;
+    t.c[k] = sx[a] * sy[b] - sx[b] * sy[a];
+    t.inclusive[k] = dy < 0 || (dy == 0 && dx < 0);
+    t.za += (sz[k] - sz[0]) * t.a[k] * invArea;
+    t.zb += (sz[k] - sz[0]) * t.b[k] * invArea;
+  }
+  // Anchored at vertex 0 for precision
+  t.zc = sz[0] - t.za * sx[0] - t.zb * sy[0];
+  t.primitive = primitive;
+  t.triangle = triangle;
+  _triangles.push_back(t);
+}
+
+void
+VisibilityBuffer::clear()
+{
+  _primitives.clear();
+  _triangles.clear();
+  _maxY1.clear();
+}
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// VisibilityBuffer::Band implementation
+// ======================
+void
+VisibilityBuffer::Band::rasterize(const VisibilityBuffer& buffer,
+  int j,
+  int i0,
+  int i1)
+{
+  auto steps = buffer._steps;
+  auto r0 = j * steps;
+  auto rows = steps == 1 ? 1 : steps + 1;
+  auto c0 = i0 * steps;
+  auto columns = steps == 1 ? i1 - i0 : (i1 - i0) * steps + 1;
+  auto sameColumns = &buffer == _buffer && c0 == _column0 && columns == _columns;
+
+  if (sameColumns && r0 == _row0)
+    return;
+  if (!sameColumns || r0 < _row0)
+  {
+    // New tile: skip the triangles that end above the band
+    const auto& m = buffer._maxY1;
+
+    _next = std::lower_bound(m.begin(), m.end(), r0) - m.begin();
+    _active.clear();
+  }
+  _buffer = &buffer;
+  _row0 = r0;
+  _rows = rows;
+  _column0 = c0;
+  _columns = columns;
+  _samples.assign((size_t)columns * rows,
+    Sample{none, none, std::numeric_limits<float>::infinity()});
+
+  const auto& triangles = buffer._triangles;
+  auto r1 = r0 + rows - 1;
+  auto c1 = c0 + columns - 1;
+
+  while (_next < triangles.size() && triangles[_next].y0 <= r1)
+  {
+    const auto& t = triangles[_next];
+
+    // Triangles out of the columns of the band never cover them
+    if (t.y1 >= r0 && t.x1 >= c0 && t.x0 <= c1)
+      _active.push_back((uint32_t)_next);
+    ++_next;
+  }
+  for (size_t k = 0; k < _active.size();)
+  {
+    const auto& t = triangles[_active[k]];
+
+    if (t.y1 < r0)
+    {
+      _active[k] = _active.back();
+      _active.pop_back();
+      continue;
+    }
+    ++k;
+
+    auto y0 = std::max(t.y0, r0);
+    auto y1 = std::min(t.y1, r1);
+    auto x0 = std::max(t.x0, c0);
+    auto x1 = std::min(t.x1, c1);
+
+    for (auto y = y0; y <= y1; ++y)
+    {
+      auto* line = _samples.data() + (size_t)(y - r0) * columns;
+
+      for (auto x = x0; x <= x1; ++x)
+      {
+        auto inside = true;
+
+        for (int e = 0; e < 3 && inside; ++e)
+        {
+          auto E = t.a[e] * x + t.b[e] * y + t.c[e];
+
+          inside = E > 0 || (E == 0 && t.inclusive[e]);
+        }
+        if (!inside)
+          continue;
+
+        auto z = t.za * x + t.zb * y + t.zc;
+
+        if (buffer._perspective)
+          z = 1 / z;
+        if (z < line[x - c0].depth)
+          line[x - c0] = Sample{t.primitive, t.triangle, (float)z};
+      }
+    }
+  }
+}
+
+const VisibilityBuffer::Sample*
+VisibilityBuffer::Band::sample(float x, float y) const
+{
+  if (_buffer == nullptr)
+    return nullptr;
+
+  auto steps = _buffer->_steps;
+  auto sx = (x - _buffer->_origin) * steps;
+  auto sy = (y - _buffer->_origin) * steps;
+  auto i = (int)std::lround(sx);
+  auto j = (int)std::lround(sy);
+
+  if (std::abs(sx - i) > latticeEps || std::abs(sy - j) > latticeEps)
+    return nullptr;
+  i -= _column0;
+  j -= _row0;
+  if (i < 0 || i >= _columns || j < 0 || j >= _rows)
+    return nullptr;
+  return _samples.data() + (size_t)j * _columns + i;
+}
+
+} // end namespace cg
@@ -0,0 +1,143 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: VisibilityBuffer.h
+// ========
+// Class definition for visibility buffer.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+#ifndef __VisibilityBuffer_h
+#define __VisibilityBuffer_h
+
+#include "graphics/Primitive.h"
+#include <cstdint>
+#include <vector>
+
+namespace cg
+{ // begin namespace cg
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// VisibilityBuffer: primitive and triangle seen by each primary ray
+// ================
+//
+// The triangle meshes of the primitives are rasterized on the lattice
+// of image positions sampled by the ray tracer: the pixel centers when
+// there is no supersampling, or the corners of the 2^L x 2^L subpixel
+// grid of the adaptive sampler. The triangles are set up once per
+// frame and sorted by their first lattice row; each rendering thread
+// keeps, in a Band, only the lattice samples of one pixel row (the
+// 2^L + 1 lattice rows it spans) of the image tile it is rendering.
+class VisibilityBuffer
+{
+public:
+  static constexpr auto none = uint32_t(-1);
+
+  // Viewing parameters of the ray tracer (see RayTracer::setPixelRay())
+  struct View
+  {
+    vec3f eye;
+    vec3f u;
+    vec3f v;
+    vec3f n;
+    float Vw;
+    float Vh;
+    float nearPlane;
+    float tMin;
+    bool perspective;
+    int width;
+    int height;
+  };
+
+  struct Sample
+  {
+    uint32_t primitive; // index into the primitive array, or none
+    uint32_t triangle;
+    float depth; // along -n, in world units
+
+  };
+
+  class Band;
+
+  // Sets up the triangles of the primitives for the view. The lattice
+  // has 2^level samples per pixel side; level 0 samples pixel centers.
+  // Returns false (and the buffer cannot be used) if a primitive has
+  // no triangle mesh.
+  bool setup(const std::vector<Primitive*>& primitives,
+    const View& view,
+    uint32_t level);
+
+  auto primitive(const Sample& s) const
+  {
+    return _primitives[s.primitive];
+  }
+
+  auto triangleCount() const
+  {
+    return (uint32_t)_triangles.size();
+  }
+
+  void clear();
+
+private:
+  struct Triangle
+  {
+    double a[3], b[3], c[3]; // edge functions (> 0 inside)
+    bool inclusive[3]; // top-left rule
+    double za, zb, zc; // plane of 1/depth (perspective) or depth
+    uint32_t primitive;
+    uint32_t triangle;
+    int x0, y0, x1, y1; // lattice bounds
+
+  };
+
+  std::vector<Primitive*> _primitives;
+  std::vector<Triangle> _triangles; // sorted by y0
+  std::vector<int> _maxY1; // max y1 of the triangles [0, k]
+  float _origin{}; // image position of the lattice sample 0
+  int _steps{}; // lattice samples per pixel side
+  int _columns{};
+  bool _perspective{};
+
+  void addTriangle(const vec3f* p, const View&, uint32_t, uint32_t);
+
+}; // VisibilityBuffer
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// VisibilityBuffer::Band: lattice samples of a row of a tile
+// ======================
+class VisibilityBuffer::Band
+{
+public:
+  // Rasterizes the lattice samples of the pixels [i0, i1) of row j.
+  // The rows of a tile are expected in increasing order.
+  void rasterize(const VisibilityBuffer& buffer, int j, int i0, int i1);
+
+  // Sample at the image position (x, y), or nullptr if (x, y) is off
+  // the lattice or outside the band.
+  const Sample* sample(float x, float y) const;
+
+private:
+  const VisibilityBuffer* _buffer{};
+  std::vector<uint32_t> _active;
+  std::vector<Sample> _samples;
+  size_t _next{};
+  int _column0{}; // first lattice column in the band
+  int _columns{};
+  int _row0{-1}; // first lattice row in the band
+  int _rows{};
+
+}; // VisibilityBuffer::Band
+
+} // end namespace cg
+
+#endif // __VisibilityBuffer_h
@@ -63,17 +63,8 @@ AbstractParser::execute()
   }
 }
 
-KeywordTableEntry*
-AbstractParser::searchKeyword(KeywordTableEntry* k, const String& name) const
-{
-  for (; k->name != nullptr; k++)
-    if (name == k->name)
-      return k;
-  return nullptr;
-}
-
-KeywordTableEntry*
-AbstractParser::findKeyword(const String&) const
+const KeywordTableEntry*
+AbstractParser::findKeyword(StringView) const
 {
   return nullptr;
 }
@@ -35,25 +35,12 @@
 
 #include "FileBuffer.h"
 #include "ErrorHandler.h"
+#include "KeywordTable.h"
 
 namespace cg::parser
 { // begin namespace cg::parser
 
 
-/////////////////////////////////////////////////////////////////////
-//
-// KeywordTableEntry: keyword table entry class
-// =================
-class KeywordTableEntry
-{
-public:
-  const char* name;
-  int token;
-  void* value;
-
-}; // KeywordTableEntry
-
-
 /////////////////////////////////////////////////////////////////////
 //
 // AbstractParser: generic LL(n) parser
@@ -77,11 +64,21 @@ protected:
 
   virtual int nextToken() = 0;
 
-  virtual KeywordTableEntry* findKeyword(const String&) const;
-  KeywordTableEntry* searchKeyword(KeywordTableEntry*, const String&) const;
+  // Keywords of the class and of its bases (see DEFINE_KEYWORD_TABLE)
+  static constexpr KeywordSet<0> _keywordSet{};
+
+  virtual const KeywordTableEntry* findKeyword(StringView) const;
 
   String errorMessageFormat(const char*) const override;
 
+  // Errors found without parsing (e.g. in a cached include) are
+  // reported at the location the definition came from
+  void setLocation(const String& filename, int lineNumber)
+  {
+    _filename = filename;
+    _lineNumber = lineNumber;
+  }
+
   virtual void initCompilationUnit();
   virtual void terminateCompilationUnit();
 
@@ -94,35 +91,31 @@ private:
 }; // AbstractParser
 
 //
-// Macros to declare a keyword table
+// Macros to define a keyword table, in the declaration of a parser
+// class. The keywords of the class are merged with the ones of the
+// base class into a perfect hash built at compile time
 //
 #define KEYWORD_TABLE cg::parser::KeywordTableEntry
 
-#define DECLARE_KEYWORD_TABLE(cls) \
-private: \
-  static KEYWORD_TABLE _keywords[]; \
+#define DEFINE_KEYWORD_TABLE(cls, base) \
 protected: \
-  KEYWORD_TABLE* findKeyword(const cg::parser::String&) const override
-
-#define DEFINE_KEYWORD_TABLE_ENTRIES(cls) \
-KEYWORD_TABLE cls::_keywords[]{
+  using KeywordTableBase = base; \
+  static constexpr KEYWORD_TABLE _keywords[]{
 
 #define KEYWORD(name, token, value) \
-{name, token, (void*)value},
+{name, token, (intptr_t)value},
 
 #define END_KEYWORD_TABLE \
-{nullptr, -1, nullptr}}
-
-#define DEFINE_KEYWORD_TABLE(cls, base) \
-KEYWORD_TABLE* \
-cls::findKeyword(const cg::parser::String& name) const\
-{ \
-  auto kw = searchKeyword(_keywords, name); \
-  if (nullptr == kw) \
-    kw = base::findKeyword(name); \
-  return kw; \
-} \
-DEFINE_KEYWORD_TABLE_ENTRIES(cls)
+}; \
+  static constexpr auto _keywordSet = cg::parser::keyword::merge< \
+    cg::parser::keyword::mergedSize(_keywords, KeywordTableBase::_keywordSet)>( \
+    _keywords, \
+    KeywordTableBase::_keywordSet); \
+  const KEYWORD_TABLE* findKeyword(cg::parser::StringView name) const override \
+  { \
+    return _keywordHash.find(name); \
+  } \
+  static constexpr cg::parser::KeywordHash _keywordHash{_keywordSet}
 
 } // end namespace cg::parser
 
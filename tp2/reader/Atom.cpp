@@ -0,0 +1,121 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: Atom.cpp
+// ========
+// Source file for atom table.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+
+#include "Atom.h"
+#include "KeywordTable.h"
+#include <algorithm>
+#include <cstring>
+
+namespace cg::parser
+{ // begin namespace cg::parser
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Arena implementation
+// =====
+char*
+Arena::allocate(size_t size)
+{
+  if (size > _available)
+  {
+    // Large requests get a block of their own
+    auto blockSize = std::max(size, _blockSize);
+
+    _blocks.emplace_back(new char[blockSize]);
+    _next = _blocks.back().get();
+    _available = blockSize;
+  }
+
+  auto p = _next;
+
+  _next += size;
+  _available -= size;
+  return p;
+}
+
+void
+Arena::clear()
+{
+  _blocks.clear();
+  _next = nullptr;
+  _available = 0;
+}
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// AtomTable implementation
+// =========
+Atom
+AtomTable::intern(StringView name)
+//[]---------------------------------------------------[]
+//|  Intern a name                                      |
+//|  @param name: name to be interned                   |
+//|  @return atom of the name                           |
+//[]---------------------------------------------------[]
+{
+  if (2 * (_names.size() + 1) > _slots.size())
+    grow();
+
+  auto h = keyword::hash(name.data(), name.size(), 0);
+  auto mask = _slots.size() - 1;
+
+  for (auto i = h & mask;; i = (i + 1) & mask)
+  {
+    if (auto slot = _slots[i]; slot == 0)
+    {
+      auto atom = (Atom)_names.size();
+      auto p = _arena.allocate(name.size() + 1);
+
+      memcpy(p, name.data(), name.size());
+      p[name.size()] = 0;
+      _names.emplace_back(p, name.size());
+      _hashes.push_back(h);
+      _slots[i] = atom + 1;
+      return atom;
+    }
+    else if (_hashes[slot - 1] == h && _names[slot - 1] == name)
+      return slot - 1;
+  }
+}
+
+void
+AtomTable::grow()
+{
+  _slots.assign(std::max<size_t>(64, 2 * _slots.size()), 0);
+
+  auto mask = _slots.size() - 1;
+
+  for (Atom atom = 0; atom < (Atom)_names.size(); ++atom)
+  {
+    auto i = _hashes[atom] & mask;
+
+    while (_slots[i] != 0)
+      i = (i + 1) & mask;
+    _slots[i] = atom + 1;
+  }
+}
+
+void
+AtomTable::clear()
+{
+  _arena.clear();
+  _names.clear();
+  _hashes.clear();
+  _slots.clear();
+}
+
+} // end namespace cg::parser
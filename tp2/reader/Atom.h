@@ -0,0 +1,96 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: Atom.h
+// ========
+// Class definitions for atom table.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+
+#ifndef __Atom_h
+#define __Atom_h
+
+#include "StringRef.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace cg::parser
+{ // begin namespace cg::parser
+
+// Interned name: index of the name in an atom table
+using Atom = uint32_t;
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Arena: memory arena class
+// =====
+//
+// Allocates from large blocks that are released only all at once.
+class Arena
+{
+public:
+  Arena(size_t blockSize = 0x10000):
+    _blockSize{blockSize}
+  {
+    // do nothing
+  }
+
+  char* allocate(size_t size);
+  void clear();
+
+private:
+  size_t _blockSize;
+  std::vector<std::unique_ptr<char[]>> _blocks;
+  char* _next{};
+  size_t _available{};
+
+}; // Arena
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// AtomTable: atom table class
+// =========
+//
+// Maps every distinct name to an atom. The names are copied, null
+// terminated, to an arena and stay valid until the table is cleared,
+// so they can be compared by atom and kept as views.
+class AtomTable
+{
+public:
+  Atom intern(StringView);
+
+  StringView name(Atom atom) const
+  {
+    return _names[atom];
+  }
+
+  auto size() const
+  {
+    return (uint32_t)_names.size();
+  }
+
+  void clear();
+
+private:
+  Arena _arena;
+  std::vector<StringView> _names;
+  std::vector<uint32_t> _hashes;
+  // Open addressing table of atoms + 1 (0 is an empty slot)
+  std::vector<uint32_t> _slots;
+
+  void grow();
+
+}; // AtomTable
+
+} // end namespace cg::parser
+
+#endif // __Atom_h
@@ -55,6 +55,16 @@ public:
 
   String lexeme();
 
+  // Lexeme as a view of the buffer. It is valid until the next token
+  // is read, when the buffer may be flushed.
+  StringView lexemeView()
+  {
+    StringView lexeme{_lexemeBegin, size_t(_current - _lexemeBegin)};
+
+    _lexemeBegin = nullptr;
+    return lexeme;
+  }
+
   void beginLexeme()
   {
     _lexemeBegin = _current;
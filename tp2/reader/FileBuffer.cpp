@@ -31,7 +31,6 @@
 // Last revision: 30/07/2023
 
 #include "FileBuffer.h"
-#include <cassert>
 #include <cstring>
 
 namespace cg::parser
@@ -56,16 +55,18 @@ FileBuffer::FileBuffer(const fs::path& path):
   _path{path},
   _size{}
 {
-  assert(fs::is_regular_file(path));
-  _file.open(path, std::ios::in | std::ios::binary);
-  if (!_file.is_open())
-    return;
-  if ((_size = (size_t)fs::file_size(path) + 1) > maxFileSize)
-    _size = dflBufferSize;
-  if ((_begin = new char[_size]) == nullptr)
-    throw std::runtime_error("No memory for file buffer");
-  *(_current = _end = _begin) = 0;
-  fill(_begin, _size);
+  std::error_code ec;
+
+  if (fs::is_regular_file(path, ec))
+    if (auto fileSize = (size_t)fs::file_size(path, ec); !ec)
+    {
+      if (fileSize + 1 > maxFileSize && map(fileSize))
+        return;
+      // the whole file fits in the buffer: no flushes
+      read(fileSize + 1);
+      return;
+    }
+  read(dflBufferSize);
 }
 
 String
@@ -87,6 +88,42 @@ FileBuffer::advance()
   return *++_current;
 }
 
+bool
+FileBuffer::map(size_t fileSize)
+//[]---------------------------------------------------[]
+//|  Map the file into memory                           |
+//|  @param fileSize: size of the file in bytes         |
+//|  @return true if the file was mapped                |
+//[]---------------------------------------------------[]
+{
+  // The lexer stops at the null character after the input. The tail of
+  // the last page of a mapping is zero filled, but a file whose size is
+  // a multiple of the page size has no tail: read it instead
+  if (fileSize % MappedFile::pageSize() == 0)
+    return false;
+  if (!_mapping.open(_path, true))
+    return false;
+  // The mapping is read-only: the lexer never writes to the buffer
+  _shouldDelete = false;
+  _begin = _current = const_cast<char*>(_mapping.data());
+  _end = _begin + fileSize;
+  _eofRead = true;
+  return true;
+}
+
+void
+FileBuffer::read(size_t bufferSize)
+{
+  _file.open(_path, std::ios::in | std::ios::binary);
+  if (!_file.is_open())
+    return;
+  _size = bufferSize;
+  if ((_begin = new char[_size]) == nullptr)
+    throw std::runtime_error("No memory for file buffer");
+  *(_current = _end = _begin) = 0;
+  fill(_begin, _size);
+}
+
 void
 FileBuffer::flush()
 {
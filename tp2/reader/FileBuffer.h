@@ -34,6 +34,7 @@
 #define __FileBuffer_h
 
 #include "Buffer.h"
+#include "MappedFile.h"
 #include <filesystem>
 #include <fstream>
 
@@ -50,6 +51,10 @@ namespace parser
 //
 // FileBuffer: file buffer class
 // ==========
+//
+// Small files are read at once into the heap. Larger regular files
+// are mapped into memory and scanned in place, with no copies; the
+// chunked reads are used only for inputs that cannot be mapped.
 class FileBuffer: public Buffer
 {
 public:
@@ -62,18 +67,26 @@ public:
     return _path;
   }
 
-  const auto& file() const
+  bool isOpen() const
+  {
+    return _begin != nullptr;
+  }
+
+  bool isMapped() const
   {
-    return _file;
+    return _mapping.isOpen();
   }
 
 private:
   fs::path _path;
   std::ifstream _file;
   size_t _size;
+  MappedFile _mapping;
 
   char advance() override;
 
+  bool map(size_t fileSize);
+  void read(size_t bufferSize);
   void flush();
   void fill(char*, size_t = 0);
 
@@ -0,0 +1,127 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: IncludeCache.cpp
+// ========
+// Source file for parsed include cache.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+#include "IncludeCache.h"
+
+namespace cg::parser
+{ // begin namespace cg::parser
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// IncludeUnit implementation
+// ===========
+IncludeUnit::IncludeUnit(const fs::path& path):
+  _name{path.string()}
+{
+  std::error_code ec;
+  auto size = fs::file_size(path, ec);
+
+  if (!ec)
+    _files.push_back({_name, size, fs::last_write_time(path, ec)});
+  _cacheable = !ec;
+}
+
+bool
+IncludeUnit::isCurrent() const
+{
+  std::error_code ec;
+
+  for (const auto& file : _files)
+  {
+    if (fs::file_size(file.name, ec) != file.size || ec)
+      return false;
+    if (fs::last_write_time(file.name, ec) != file.time || ec)
+      return false;
+  }
+  return true;
+}
+
+void
+IncludeUnit::addUnit(const IncludeUnit& unit)
+{
+  _files.insert(_files.end(), unit._files.begin(), unit._files.end());
+  _names.insert(unit._names.begin(), unit._names.end());
+  if (!unit._cacheable)
+    _cacheable = false;
+}
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// IncludeCache implementation
+// ============
+IncludeCache&
+IncludeCache::instance()
+{
+  static IncludeCache cache;
+  return cache;
+}
+
+inline String
+IncludeCache::key(const fs::path& path)
+{
+  std::error_code ec;
+  auto canonical = fs::weakly_canonical(path, ec);
+
+  return (ec ? path : canonical).string();
+}
+
+IncludeCache::UnitRef
+IncludeCache::find(const fs::path& path)
+{
+  auto k = key(path);
+  std::lock_guard lock{_lock};
+
+  if (auto uit = _units.find(k); uit != _units.end())
+  {
+    if (uit->second->isCurrent())
+    {
+      ++_hits;
+      return uit->second;
+    }
+    _units.erase(uit);
+  }
+  return nullptr;
+}
+
+void
+IncludeCache::add(UnitRef unit)
+{
+  if (unit == nullptr || !unit->isCacheable())
+    return;
+
+  auto k = key(unit->name());
+  std::lock_guard lock{_lock};
+
+  _units[k] = std::move(unit);
+}
+
+void
+IncludeCache::clear()
+{
+  std::lock_guard lock{_lock};
+
+  _units.clear();
+  _hits = 0;
+}
+
+size_t
+IncludeCache::size() const
+{
+  std::lock_guard lock{_lock};
+  return _units.size();
+}
+
+} // end namespace cg::parser
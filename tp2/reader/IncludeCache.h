@@ -0,0 +1,173 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: IncludeCache.h
+// ========
+// Class definitions for parsed include cache.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+
+#ifndef __IncludeCache_h
+#define __IncludeCache_h
+
+#include "core/SharedObject.h"
+#include "Expression.h"
+#include "FileBuffer.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace cg::parser
+{ // begin namespace cg::parser
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// IncludeUnit: definitions of a parsed include file
+// ===========
+//
+// The definitions are kept in the order they were parsed: global
+// symbols, nested includes and reader specific objects (e.g. scene
+// materials), each one with the line it came from. The values are
+// evaluated, so a unit is current only while neither its file nor the
+// files of its nested includes change, and it is not cacheable if it
+// uses a name defined out of them.
+class IncludeUnit
+{
+public:
+  // Definition kinds; readers add their own kinds after lastKind
+  enum
+  {
+    Symbol,
+    Include,
+    lastKind
+  };
+
+  struct Definition
+  {
+    int kind;
+    int line;
+    String name;
+    Expression value;
+    Reference<SharedObject> object;
+
+  }; // Definition
+
+  IncludeUnit(const fs::path& path);
+
+  const auto& name() const
+  {
+    return _name;
+  }
+
+  const auto& definitions() const
+  {
+    return _definitions;
+  }
+
+  auto isCacheable() const
+  {
+    return _cacheable;
+  }
+
+  void setCacheable(bool value)
+  {
+    _cacheable = value;
+  }
+
+  // Returns true if no file of the unit has changed since it was parsed
+  bool isCurrent() const;
+
+  // Returns true if the name is defined by the unit or its includes
+  bool defines(const String& name) const
+  {
+    return _names.find(name) != _names.end();
+  }
+
+  void addSymbol(const String& name, const Expression& value, int line)
+  {
+    _definitions.push_back({Symbol, line, name, value, nullptr});
+    _names.insert(name);
+  }
+
+  // Adds the files and the names of a nested include
+  void addUnit(const IncludeUnit& unit);
+
+  void addInclude(const String& filename, int line)
+  {
+    _definitions.push_back({Include, line, filename, {}, nullptr});
+  }
+
+  // The object must not be shared with the reader: it is a prototype
+  void addObject(int kind, const String& name, SharedObject* object, int line)
+  {
+    _definitions.push_back({kind, line, name, {}, object});
+  }
+
+private:
+  struct File
+  {
+    String name;
+    uintmax_t size;
+    fs::file_time_type time;
+
+  }; // File
+
+  String _name;
+  std::vector<File> _files; // the file of the unit comes first
+  std::vector<Definition> _definitions;
+  std::unordered_set<String> _names;
+  bool _cacheable{true};
+
+}; // IncludeUnit
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// IncludeCache: process-wide cache of parsed include files
+// ============
+//
+// Units are keyed by canonical path and dropped as soon as their files
+// change. A unit is immutable once added, and it can be shared by
+// readers running in different threads.
+class IncludeCache
+{
+public:
+  using UnitRef = std::shared_ptr<const IncludeUnit>;
+
+  static IncludeCache& instance();
+
+  // Returns the unit of a file, if it is cached and current
+  UnitRef find(const fs::path& path);
+  void add(UnitRef unit);
+  void clear();
+
+  size_t size() const;
+
+  auto hits() const
+  {
+    return _hits;
+  }
+
+private:
+  mutable std::mutex _lock;
+  std::unordered_map<String, UnitRef> _units;
+  size_t _hits{};
+
+  IncludeCache() = default;
+
+  static String key(const fs::path&);
+
+}; // IncludeCache
+
+} // end namespace cg::parser
+
+#endif // __IncludeCache_h
@@ -0,0 +1,206 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: KeywordTable.h
+// ========
+// Class definitions for compile time keyword tables.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+
+#ifndef __KeywordTable_h
+#define __KeywordTable_h
+
+#include "StringRef.h"
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace cg::parser
+{ // begin namespace cg::parser
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// KeywordTableEntry: keyword table entry class
+// =================
+class KeywordTableEntry
+{
+public:
+  const char* name;
+  int token;
+  intptr_t value;
+
+}; // KeywordTableEntry
+
+template <size_t N>
+using KeywordSet = std::array<KeywordTableEntry, N>;
+
+namespace keyword
+{ // begin namespace keyword
+
+constexpr size_t
+length(const char* s)
+{
+  size_t n = 0;
+
+  while (s[n] != 0)
+    ++n;
+  return n;
+}
+
+constexpr bool
+equal(const char* a, const char* b)
+{
+  for (; *a != 0 && *a == *b; ++a, ++b)
+    ;
+  return *a == *b;
+}
+
+// FNV-1a followed by a final mix of the high bits into the low ones,
+// which index the table
+constexpr uint32_t
+hash(const char* s, size_t n, uint32_t seed)
+{
+  auto h = 2166136261u ^ seed;
+
+  for (size_t i = 0; i < n; ++i)
+    h = (h ^ (uint8_t)s[i]) * 16777619u;
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  return h ^ (h >> 13);
+}
+
+template <size_t N, size_t M>
+constexpr bool
+contains(const KeywordTableEntry (&keywords)[N], const KeywordSet<M>& base, size_t i)
+{
+  for (const auto& k : keywords)
+    if (equal(k.name, base[i].name))
+      return true;
+  return false;
+}
+
+// Number of keywords of a class and of its base class. A keyword of
+// the class hides a keyword of the base with the same name
+template <size_t N, size_t M>
+constexpr size_t
+mergedSize(const KeywordTableEntry (&keywords)[N], const KeywordSet<M>& base)
+{
+  auto size = N;
+
+  for (size_t i = 0; i < M; ++i)
+    size += !contains(keywords, base, i);
+  return size;
+}
+
+template <size_t S, size_t N, size_t M>
+constexpr auto
+merge(const KeywordTableEntry (&keywords)[N], const KeywordSet<M>& base)
+{
+  KeywordSet<S> set{};
+  size_t size = 0;
+
+  for (const auto& k : keywords)
+    set[size++] = k;
+  for (size_t i = 0; i < M; ++i)
+    if (!contains(keywords, base, i))
+      set[size++] = base[i];
+  return set;
+}
+
+} // end namespace keyword
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// KeywordHash: perfect hash of a keyword set
+// ===========
+//
+// Built at compile time: the seed of the hash function is the first
+// one that maps every keyword to a distinct slot of a table with at
+// least four slots per keyword. Looking up a name takes one hash and
+// one compare.
+template <size_t N>
+class KeywordHash
+{
+public:
+  static_assert(N < 255, "Too many keywords");
+
+  static constexpr size_t slotCount = []()
+  {
+    size_t n = 4;
+
+    while (n < 4 * N)
+      n <<= 1;
+    return n;
+  }();
+
+  constexpr KeywordHash(const KeywordSet<N>& keywords):
+    _keywords{keywords}
+  {
+    for (size_t i = 0; i < N; ++i)
+      _lengths[i] = (uint8_t)keyword::length(keywords[i].name);
+    for (;; ++_seed)
+    {
+      _slots = {};
+
+      size_t i = 0;
+
+      for (; i < N; ++i)
+      {
+        auto& slot = _slots[slotOf(keywords[i].name, _lengths[i])];
+
+        if (slot != 0)
+          break;
+        slot = uint8_t(i + 1);
+      }
+      if (i == N)
+        break;
+    }
+  }
+
+  const KeywordTableEntry* find(const char* name, size_t length) const
+  {
+    if (auto i = _slots[slotOf(name, length)]; i != 0)
+      if (_lengths[--i] == length && !memcmp(_keywords[i].name, name, length))
+        return &_keywords[i];
+    return nullptr;
+  }
+
+  const KeywordTableEntry* find(StringView name) const
+  {
+    return find(name.data(), name.size());
+  }
+
+  const auto& keywords() const
+  {
+    return _keywords;
+  }
+
+  auto seed() const
+  {
+    return _seed;
+  }
+
+private:
+  KeywordSet<N> _keywords;
+  std::array<uint8_t, N> _lengths{};
+  std::array<uint8_t, slotCount> _slots{};
+  uint32_t _seed{};
+
+  constexpr size_t slotOf(const char* name, size_t length) const
+  {
+    return keyword::hash(name, length, _seed) & (slotCount - 1);
+  }
+
+}; // KeywordHash
+
+} // end namespace cg::parser
+
+#endif // __KeywordTable_h
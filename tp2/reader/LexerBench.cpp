@@ -0,0 +1,199 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: LexerBench.cpp
+// ========
+// Source file for scene lexer benchmark.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+
+#include "LexerBench.h"
+#include "SceneReader.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace cg::util
+{ // begin namespace cg::util
+
+namespace
+{ // begin namespace
+
+using Clock = std::chrono::steady_clock;
+
+inline double
+elapsed(Clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Stats
+{
+  size_t tokens;
+  std::vector<parser::String> identifiers;
+
+};
+
+// Parser that only runs the lexer
+class Tokenizer final: public SceneReader::Parser
+{
+public:
+  Tokenizer(SceneReader& reader, Stats& stats):
+    SceneReader::Parser{reader},
+    _stats{&stats}
+  {
+    // do nothing
+  }
+
+  static auto find(parser::StringView name)
+  {
+    return _keywordHash.find(name);
+  }
+
+  static const parser::KeywordTableEntry* search(parser::StringView name)
+  {
+    for (const auto& k : _keywordSet)
+      if (name == k.name)
+        return &k;
+    return nullptr;
+  }
+
+private:
+  Stats* _stats;
+
+  void start() override
+  {
+    auto collect = _stats->identifiers.empty();
+
+    _stats->tokens = 0;
+    while ((_token = nextToken()) != _EOF)
+    {
+      ++_stats->tokens;
+      if (collect && _token != _STRING && !_lexeme.empty() &&
+        (isalpha(_lexeme[0]) || _lexeme[0] == '_'))
+        _stats->identifiers.emplace_back(_lexeme);
+    }
+  }
+
+}; // Tokenizer
+
+class TokenReader final: public SceneReader
+{
+public:
+  Stats stats{};
+
+  void execute() override
+  {
+    // no assets are needed: the scene is not built
+    parser::Reader::execute();
+  }
+
+private:
+  parser::Reader::Parser* makeParser() override
+  {
+    return new Tokenizer{*this, stats};
+  }
+
+}; // TokenReader
+
+} // end namespace
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// LexerBench implementation
+// ==========
+bool
+LexerBench::requested(int argc, char** argv)
+{
+  for (int i = 1; i < argc; ++i)
+    if (strcmp(argv[i], "--lexbench") == 0)
+      return true;
+  return false;
+}
+
+int
+LexerBench::run(int argc, char** argv)
+{
+  const char* filename = "assets/scenes/test.scn";
+  auto iterations = 20;
+
+  for (int i = 1; i < argc; ++i)
+    if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+      iterations = std::max(1, atoi(argv[++i]));
+    else if (argv[i][0] != '-')
+      filename = argv[i];
+
+  TokenReader reader;
+  auto best = 0.0;
+  auto total = 0.0;
+
+  try
+  {
+    for (auto i = 0; i < iterations; ++i)
+    {
+      auto start = Clock::now();
+
+      reader.setInput(filename);
+      reader.execute();
+
+      auto t = elapsed(start);
+
+      best = i ? std::min(best, t) : t;
+      total += t;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  const auto& ids = reader.stats.identifiers;
+  // pipes have no size
+  std::error_code ec;
+  auto length = fs::file_size(filename, ec);
+  auto size = ec ? 0.0 : (double)length;
+
+  printf("%s: %.0f KB, %zu tokens, %zu identifiers\n",
+    filename,
+    size / 1024,
+    reader.stats.tokens,
+    ids.size());
+  printf("tokenize: best %.3f ms, mean %.3f ms (%.1f MB/s, %.1f Mtokens/s)\n",
+    best,
+    total / iterations,
+    size / (best * 1e3),
+    reader.stats.tokens / (best * 1e3));
+
+  // Keyword lookup only, the way the lexer does it for every identifier
+  constexpr auto repeat = 50;
+  size_t hits[2]{};
+  double times[2];
+
+  for (int m = 0; m < 2; ++m)
+  {
+    auto start = Clock::now();
+
+    for (auto r = 0; r < repeat; ++r)
+      for (const auto& name : ids)
+        hits[m] += (m ? Tokenizer::search(name) : Tokenizer::find(name)) != nullptr;
+    times[m] = elapsed(start) * 1e6 / (repeat * std::max<size_t>(ids.size(), 1));
+  }
+  printf("keyword lookup: perfect hash %.1f ns, linear search %.1f ns%s\n",
+    times[0],
+    times[1],
+    hits[0] == hits[1] ? "" : " (MISMATCH)");
+  return hits[0] == hits[1] ? 0 : 1;
+}
+
+} // end namespace cg::util
@@ -0,0 +1,43 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: LexerBench.h
+// ========
+// Class definition for scene lexer benchmark.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+
+#ifndef __LexerBench_h
+#define __LexerBench_h
+
+namespace cg::util
+{ // begin namespace cg::util
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// LexerBench: scene lexer benchmark
+// ==========
+//
+// Headless run: tp2 --lexbench [file] [--iterations n]. Tokenizes a
+// scene file (assets/scenes/test.scn by default) n times, without
+// building the scene or following includes, and then times the keyword
+// lookup of every identifier of the file with the perfect hash of the
+// scene parser and with a linear search over the same keywords.
+class LexerBench
+{
+public:
+  static bool requested(int argc, char** argv);
+  static int run(int argc, char** argv);
+
+}; // LexerBench
+
+} // end namespace cg::util
+
+#endif // __LexerBench_h
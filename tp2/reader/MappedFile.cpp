@@ -0,0 +1,119 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: MappedFile.cpp
+// ========
+// Source file for memory mapped file.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace cg::parser
+{ // begin namespace cg::parser
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// MappedFile implementation
+// ==========
+size_t
+MappedFile::pageSize()
+{
+#ifdef _WIN32
+  SYSTEM_INFO info;
+
+  GetSystemInfo(&info);
+  return (size_t)info.dwPageSize;
+#else
+  return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+bool
+MappedFile::open(const std::filesystem::path& path, bool sequential)
+//[]---------------------------------------------------[]
+//|  Map a file into memory                             |
+//|  @param path: path of the file                      |
+//|  @param sequential: true if the file is read in     |
+//|  order                                              |
+//|  @return true if the file was mapped                |
+//[]---------------------------------------------------[]
+{
+  close();
+
+  std::error_code ec;
+  auto size = (size_t)std::filesystem::file_size(path, ec);
+
+  if (ec || size == 0)
+    return false;
+
+  void* view;
+
+#ifdef _WIN32
+  auto file = CreateFileW(path.c_str(),
+    GENERIC_READ,
+    FILE_SHARE_READ,
+    nullptr,
+    OPEN_EXISTING,
+    sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL,
+    nullptr);
+
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+  CloseHandle(file);
+  if (mapping == nullptr)
+    return false;
+  view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (view == nullptr)
+    return false;
+#else
+  auto fd = ::open(path.c_str(), O_RDONLY);
+
+  if (fd < 0)
+    return false;
+  view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (view == MAP_FAILED)
+    return false;
+  if (sequential)
+    madvise(view, size, MADV_SEQUENTIAL);
+#endif
+  _data = static_cast<const char*>(view);
+  _size = size;
+  return true;
+}
+
+void
+MappedFile::close()
+{
+  if (_data == nullptr)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile(_data);
+#else
+  munmap(const_cast<char*>(_data), _size);
+#endif
+  _data = nullptr;
+  _size = 0;
+}
+
+} // end namespace cg::parser
@@ -0,0 +1,73 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: MappedFile.h
+// ========
+// Class definition for memory mapped file.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+
+#ifndef __MappedFile_h
+#define __MappedFile_h
+
+#include <cstddef>
+#include <filesystem>
+
+namespace cg::parser
+{ // begin namespace cg::parser
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// MappedFile: read-only memory mapped file class
+// ==========
+class MappedFile
+{
+public:
+  MappedFile() = default;
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator =(const MappedFile&) = delete;
+
+  ~MappedFile()
+  {
+    close();
+  }
+
+  static size_t pageSize();
+
+  // Maps the whole file. A file read once from the beginning to the end
+  // should be mapped as sequential. Empty files cannot be mapped.
+  bool open(const std::filesystem::path&, bool sequential = false);
+  void close();
+
+  bool isOpen() const
+  {
+    return _data != nullptr;
+  }
+
+  const char* data() const
+  {
+    return _data;
+  }
+
+  auto size() const
+  {
+    return _size;
+  }
+
+private:
+  const char* _data{};
+  size_t _size{};
+
+}; // MappedFile
+
+} // end namespace cg::parser
+
+#endif // __MappedFile_h
@@ -0,0 +1,696 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: MeshLoader.cpp
+// ========
+// Source file for OBJ mesh loader.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+#include "graphics/Application.h"
+#include "graphics/Assets.h"
+#include "MappedFile.h"
+#include "MeshLoader.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace cg::util
+{ // begin namespace cg::util
+
+namespace
+{ // begin namespace
+
+// Chunks smaller than this are not worth a thread
+constexpr size_t minChunkSize{0x40000};
+
+constexpr char magic[4]{'M', 'E', 'S', 'H'};
+constexpr uint32_t version{1};
+constexpr uint32_t byteOrder{0x01020304};
+
+// Cache flags
+enum : uint32_t
+{
+  hasUV = 1
+};
+
+struct CacheHeader
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t flags;
+  uint64_t sourceSize;
+  int64_t sourceTime;
+  int32_t vertexCount;
+  int32_t triangleCount;
+  vec3f boundsMin;
+  vec3f boundsMax;
+
+}; // CacheHeader
+
+// Face corner. Relative (negative) OBJ indices are resolved against the
+// number of elements read before the face in the chunk; the chunk base
+// is only known after all of the chunks are parsed
+struct Corner
+{
+  int v;
+  int t;
+  int n;
+  uint8_t relative;
+
+}; // Corner
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// ObjChunk: OBJ chunk parser
+// ========
+class ObjChunk
+{
+public:
+  std::vector<vec3f> positions;
+  std::vector<vec3f> normals;
+  std::vector<vec2f> uv;
+  // three corners per triangle
+  std::vector<Corner> corners;
+  bool failed{};
+
+  void parse(const char* begin, const char* end);
+
+private:
+  const char* _p;
+  const char* _eol;
+  // corners of the current face, reused from face to face
+  std::vector<Corner> _face;
+
+  void skipSpaces()
+  {
+    while (_p < _eol && (*_p == ' ' || *_p == '\t' || *_p == '\r'))
+      ++_p;
+  }
+
+  bool parseFloat(float& x)
+  {
+    skipSpaces();
+    // from_chars does not skip a leading plus sign
+    if (_p < _eol && *_p == '+')
+      ++_p;
+
+    auto [p, ec] = std::from_chars(_p, _eol, x);
+
+    _p = p;
+    return ec == std::errc{};
+  }
+
+  bool parseIndex(int& index, int count, uint8_t bit, uint8_t& relative)
+  {
+    auto [p, ec] = std::from_chars(_p, _eol, index);
+
+    if (ec != std::errc{} || index == 0)
+      return false;
+    _p = p;
+    if (index < 0)
+    {
+      index += count;
+      relative |= bit;
+    }
+    return true;
+  }
+
+  bool parseCorner(Corner&);
+  bool parseFace();
+
+}; // ObjChunk
+
+bool
+ObjChunk::parseCorner(Corner& c)
+{
+  c = {0, 0, 0, 0};
+  if (!parseIndex(c.v, (int)positions.size(), 1, c.relative))
+    return false;
+  if (_p < _eol && *_p == '/')
+  {
+    if (++_p < _eol && *_p != '/' &&
+      !parseIndex(c.t, (int)uv.size(), 2, c.relative))
+      return false;
+    if (_p < _eol && *_p == '/')
+    {
+      ++_p;
+      if (!parseIndex(c.n, (int)normals.size(), 4, c.relative))
+        return false;
+    }
+  }
+  return true;
+}
+
+bool
+ObjChunk::parseFace()
+{
+  _face.clear();
+  for (skipSpaces(); _p < _eol; skipSpaces())
+  {
+    Corner c;
+
+    if (!parseCorner(c))
+      return false;
+    _face.push_back(c);
+  }
+  if (_face.size() < 3)
+    return false;
+  // triangle fan
+  for (size_t i = 2; i < _face.size(); ++i)
+  {
+    corners.push_back(_face[0]);
+    corners.push_back(_face[i - 1]);
+    corners.push_back(_face[i]);
+  }
+  return true;
+}
+
+void
+ObjChunk::parse(const char* begin, const char* end)
+{
+  for (_p = begin; _p < end && !failed; _p = _eol + 1)
+  {
+    if ((_eol = (const char*)memchr(_p, '\n', end - _p)) == nullptr)
+      _eol = end;
+    skipSpaces();
+    if (_eol - _p < 2 || _p[0] == '#')
+      continue;
+    if (_p[0] == 'v')
+    {
+      if (_p[1] == ' ' || _p[1] == '\t')
+      {
+        vec3f v;
+
+        _p += 2;
+        failed = !parseFloat(v.x) || !parseFloat(v.y) || !parseFloat(v.z);
+        positions.push_back(v);
+      }
+      else if (_p[1] == 'n')
+      {
+        vec3f n;
+
+        _p += 2;
+        failed = !parseFloat(n.x) || !parseFloat(n.y) || !parseFloat(n.z);
+        normals.push_back(n);
+      }
+      else if (_p[1] == 't')
+      {
+        vec2f t;
+
+        _p += 2;
+        failed = !parseFloat(t.x) || !parseFloat(t.y);
+        uv.push_back(t);
+      }
+    }
+    else if (_p[0] == 'f' && (_p[1] == ' ' || _p[1] == '\t'))
+    {
+      _p += 2;
+      failed = !parseFace();
+    }
+    // groups, smoothing groups and materials are ignored
+  }
+}
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// VertexTable: table of distinct (position, uv, normal) triples
+// ===========
+class VertexTable
+{
+public:
+  // The first triple of each position is kept in an array indexed by
+  // position: most files have about one vertex per position, and only
+  // the other triples go to the hash table, which grows at half load
+  VertexTable(size_t positionCount):
+    _first(positionCount + 1, {-1, 0, 0, 0})
+  {
+    resize(16);
+  }
+
+  // Returns the index of a triple, adding it if it is new
+  int find(int v, int t, int n, std::vector<int>& vertices)
+  {
+    auto& f = _first[v];
+
+    if (f.v < 0)
+    {
+      f = {v, t, n, add(v, t, n, vertices)};
+      return f.index;
+    }
+    if (f.t == t && f.n == n)
+      return f.index;
+    for (auto i = hash(v, t, n);; i = (i + 1) & _mask)
+    {
+      auto& s = _slots[i];
+
+      if (s.v < 0)
+      {
+        auto index = add(v, t, n, vertices);
+
+        s = {v, t, n, index};
+        if (++_count * 2 > _slots.size())
+          resize(_slots.size() * 2);
+        return index;
+      }
+      if (s.v == v && s.t == t && s.n == n)
+        return s.index;
+    }
+  }
+
+private:
+  struct Slot
+  {
+    int v;
+    int t;
+    int n;
+    int index;
+
+  }; // Slot
+
+  std::vector<Slot> _first;
+  std::vector<Slot> _slots;
+  size_t _mask;
+  size_t _count{};
+
+  static int add(int v, int t, int n, std::vector<int>& vertices)
+  {
+    vertices.push_back(v);
+    vertices.push_back(t);
+    vertices.push_back(n);
+    return (int)vertices.size() / 3 - 1;
+  }
+
+  size_t hash(int v, int t, int n) const
+  {
+    auto h = ((uint64_t)(uint32_t)v * 0x9e3779b97f4a7c15ull) ^
+      ((uint64_t)(uint32_t)t * 0xc2b2ae3d27d4eb4full) ^
+      ((uint64_t)(uint32_t)n * 0x165667b19e3779f9ull);
+
+    return (size_t)(h >> 17) & _mask;
+  }
+
+  void resize(size_t minSize)
+  {
+    size_t size = 16;
+
+    while (size < minSize)
+      size <<= 1;
+
+    auto slots = std::move(_slots);
+
+    _slots.assign(size, {-1, 0, 0, 0});
+    _mask = size - 1;
+    for (const auto& s : slots)
+      if (s.v >= 0)
+      {
+        auto i = hash(s.v, s.t, s.n);
+
+        while (_slots[i].v >= 0)
+          i = (i + 1) & _mask;
+        _slots[i] = s;
+      }
+  }
+
+}; // VertexTable
+
+template <typename T>
+inline T*
+copyArray(const T* data, size_t count)
+{
+  auto a = new T[count];
+
+  memcpy((void*)a, data, count * sizeof(T));
+  return a;
+}
+
+inline int64_t
+modificationTime(const fs::path& path, std::error_code& ec)
+{
+  return (int64_t)fs::last_write_time(path, ec).time_since_epoch().count();
+}
+
+// Path of an asset mesh, if it is an OBJ file
+inline bool
+objFilePath(const std::string& name, fs::path& path)
+{
+  std::error_code ec;
+
+  path = Application::assetFilePath(("meshes/" + name).c_str());
+  return path.extension() == ".obj" && fs::is_regular_file(path, ec);
+}
+
+} // end namespace
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// MeshLoader implementation
+// ==========
+fs::path
+MeshLoader::cachePath(const fs::path& path)
+{
+  auto cache = path;
+  return cache.replace_extension(".mesh");
+}
+
+MeshLoader::Future
+MeshLoader::prefetch(const std::string& name)
+{
+  auto& meshes = Assets::meshes();
+
+  if (auto mit = meshes.find(name); mit != meshes.end() && mit->second)
+    return {};
+
+  fs::path path;
+
+  if (!objFilePath(name, path))
+    return {};
+  return std::async(std::launch::async, [path]() { return read(path); })
+    .share();
+}
+
+TriangleMesh*
+MeshLoader::load(const std::string& name, const Future& prefetched)
+{
+  auto& meshes = Assets::meshes();
+
+  // meshes built in or already loaded
+  if (auto mit = meshes.find(name); mit != meshes.end() && mit->second)
+    return mit->second;
+
+  Reference<TriangleMesh> mesh;
+
+  if (prefetched.valid())
+    mesh = prefetched.get();
+  else if (fs::path path; objFilePath(name, path))
+    mesh = read(path);
+  if (mesh == nullptr)
+    return Assets::loadMesh(name);
+  meshes[name] = mesh;
+  return mesh;
+}
+
+Reference<TriangleMesh>
+MeshLoader::read(const fs::path& path, bool useCache)
+{
+  CG_TRACE_SCOPE("mesh read", "scene");
+
+  auto cache = cachePath(path);
+
+  if (useCache)
+    if (auto mesh = readCache(cache, path); mesh != nullptr)
+      return mesh;
+
+  parser::MappedFile file;
+
+  if (!file.open(path, true))
+    return nullptr;
+
+  auto mesh = parse(file.data(), file.size());
+
+  if (mesh != nullptr && useCache)
+    writeCache(cache, path, *mesh);
+  return mesh;
+}
+
+Reference<TriangleMesh>
+MeshLoader::parse(const char* data, size_t size, unsigned threadCount)
+//[]---------------------------------------------------[]
+//|  Parse an OBJ file                                  |
+//|  @param data: contents of the file                  |
+//|  @param size: size of the file in bytes             |
+//|  @param threadCount: max number of threads          |
+//|  @return the mesh, or null if the file is invalid   |
+//[]---------------------------------------------------[]
+{
+  CG_TRACE_SCOPE("mesh parse", "scene");
+  if (threadCount == 0)
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+  // Split the file into line aligned chunks
+  auto n = std::clamp<size_t>(size / minChunkSize, 1, threadCount);
+  std::vector<const char*> bounds{data};
+
+  for (size_t i = 1; i < n; ++i)
+  {
+    auto p = data + size * i / n;
+
+    if (p < bounds.back())
+      continue;
+    if (p = (const char*)memchr(p, '\n', data + size - p); p == nullptr)
+      break;
+    bounds.push_back(p + 1);
+  }
+  bounds.push_back(data + size);
+
+  // The calling thread parses the first chunk
+  std::vector<ObjChunk> chunks(bounds.size() - 1);
+  std::vector<std::thread> threads;
+
+  for (size_t i = 1; i < chunks.size(); ++i)
+    threads.emplace_back(&ObjChunk::parse, &chunks[i], bounds[i], bounds[i + 1]);
+  chunks[0].parse(bounds[0], bounds[1]);
+  for (auto& t : threads)
+    t.join();
+
+  // Merge the chunks
+  size_t np{}, nt{}, nn{}, nc{};
+
+  for (const auto& c : chunks)
+  {
+    if (c.failed)
+      return nullptr;
+    np += c.positions.size();
+    nt += c.uv.size();
+    nn += c.normals.size();
+    nc += c.corners.size();
+  }
+  if (nc == 0)
+    return nullptr;
+
+  std::vector<vec3f> positions;
+  std::vector<vec3f> normals;
+  std::vector<vec2f> uv;
+  std::vector<int> corners(nc);
+
+  positions.reserve(np);
+  normals.reserve(nn);
+  uv.reserve(nt);
+
+  // Resolve the indices of the corners (0 means none)
+  auto resolve = [](int i, int base, bool relative, size_t count)
+  {
+    auto r = relative ? base + i + 1 : i;
+
+    if (r < 0 || r > (int)count)
+      throw std::out_of_range{"OBJ index out of range"};
+    return r;
+  };
+  // a vertex is a distinct (position, uv, normal) triple, unless the
+  // file has neither normals nor texture coordinates
+  auto split = nt != 0 || nn != 0;
+  VertexTable table{split ? np : 0};
+  std::vector<int> vertices;
+
+  try
+  {
+    size_t k = 0;
+
+    for (const auto& c : chunks)
+    {
+      auto bp = (int)positions.size();
+      auto bt = (int)uv.size();
+      auto bn = (int)normals.size();
+
+      positions.insert(positions.end(), c.positions.begin(), c.positions.end());
+      uv.insert(uv.end(), c.uv.begin(), c.uv.end());
+      normals.insert(normals.end(), c.normals.begin(), c.normals.end());
+      for (const auto& corner : c.corners)
+      {
+        auto v = resolve(corner.v, bp, corner.relative & 1, np);
+        auto t = resolve(corner.t, bt, corner.relative & 2, nt);
+        auto n = resolve(corner.n, bn, corner.relative & 4, nn);
+
+        if (v == 0)
+          throw std::out_of_range{"OBJ face without position"};
+        corners[k++] = split ? table.find(v, t, n, vertices) : v - 1;
+      }
+    }
+  }
+  catch (const std::out_of_range&)
+  {
+    return nullptr;
+  }
+
+  // Build the mesh
+  TriangleMesh::Data m{};
+  auto nv = split ? vertices.size() / 3 : np;
+
+  m.vertexCount = (int)nv;
+  m.triangleCount = (int)(nc / 3);
+  m.triangles = new TriangleMesh::Triangle[m.triangleCount];
+  for (int i = 0; i < m.triangleCount; ++i)
+    for (int j = 0; j < 3; ++j)
+      m.triangles[i].v[j] = corners[3 * i + j];
+  if (!split)
+    m.vertices = copyArray(positions.data(), nv);
+  else
+  {
+    m.vertices = new vec3f[nv];
+    for (size_t i = 0; i < nv; ++i)
+      m.vertices[i] = positions[vertices[3 * i] - 1];
+    if (nt != 0)
+    {
+      m.uv = new vec2f[nv];
+      for (size_t i = 0; i < nv; ++i)
+        if (auto t = vertices[3 * i + 1])
+          m.uv[i] = uv[t - 1];
+        else
+          m.uv[i] = {0, 0};
+    }
+  }
+
+  // the normals are computed if any corner has no normal
+  auto computeNormals = nn == 0;
+
+  if (!computeNormals)
+  {
+    m.vertexNormals = new vec3f[nv];
+    for (size_t i = 0; i < nv && !computeNormals; ++i)
+      if (auto n = vertices[3 * i + 2])
+        m.vertexNormals[i] = normals[n - 1];
+      else
+        computeNormals = true;
+    if (computeNormals)
+    {
+      delete []m.vertexNormals;
+      m.vertexNormals = nullptr;
+    }
+  }
+
+  Reference<TriangleMesh> mesh{new TriangleMesh{std::move(m)}};
+
+  if (computeNormals)
+    mesh->computeNormals();
+  return mesh;
+}
+
+Reference<TriangleMesh>
+MeshLoader::readCache(const fs::path& cache, const fs::path& source)
+{
+  parser::MappedFile file;
+
+  if (!file.open(cache, true) || file.size() < sizeof(CacheHeader))
+    return nullptr;
+
+  CacheHeader h;
+  std::error_code ec;
+
+  memcpy(&h, file.data(), sizeof h);
+  if (memcmp(h.magic, magic, sizeof magic) != 0 ||
+    h.version != version ||
+    h.byteOrder != byteOrder ||
+    h.sourceSize != fs::file_size(source, ec) ||
+    h.sourceTime != modificationTime(source, ec) ||
+    ec ||
+    h.vertexCount <= 0 ||
+    h.triangleCount <= 0)
+    return nullptr;
+
+  size_t nv = h.vertexCount;
+  size_t nt = h.triangleCount;
+  auto size = sizeof h + nv * 2 * sizeof(vec3f) +
+    nt * sizeof(TriangleMesh::Triangle);
+
+  if (h.flags & hasUV)
+    size += nv * sizeof(vec2f);
+  if (file.size() != size)
+    return nullptr;
+
+  TriangleMesh::Data m{};
+  auto p = file.data() + sizeof h;
+
+  m.vertexCount = h.vertexCount;
+  m.triangleCount = h.triangleCount;
+  m.vertices = copyArray((const vec3f*)p, nv);
+  m.vertexNormals = copyArray((const vec3f*)(p += nv * sizeof(vec3f)), nv);
+  m.triangles = copyArray((const TriangleMesh::Triangle*)
+    (p += nv * sizeof(vec3f)), nt);
+  if (h.flags & hasUV)
+    m.uv = copyArray((const vec2f*)(p + nt * sizeof(TriangleMesh::Triangle)),
+      nv);
+  return Reference<TriangleMesh>{new TriangleMesh{std::move(m)}};
+}
+
+bool
+MeshLoader::writeCache(const fs::path& cache,
+  const fs::path& source,
+  const TriangleMesh& mesh)
+{
+  const auto& m = mesh.data();
+
+  if (m.vertexNormals == nullptr)
+    return false;
+
+  CacheHeader h{};
+  std::error_code ec;
+
+  memcpy(h.magic, magic, sizeof magic);
+  h.version = version;
+  h.byteOrder = byteOrder;
+  h.flags = m.uv != nullptr ? (uint32_t)hasUV : 0;
+  h.sourceSize = fs::file_size(source, ec);
+  h.sourceTime = modificationTime(source, ec);
+  h.vertexCount = m.vertexCount;
+  h.triangleCount = m.triangleCount;
+  h.boundsMin = h.boundsMax = m.vertices[0];
+  for (int i = 1; i < m.vertexCount; ++i)
+  {
+    const auto& v = m.vertices[i];
+
+    h.boundsMin = {std::min(h.boundsMin.x, v.x),
+      std::min(h.boundsMin.y, v.y),
+      std::min(h.boundsMin.z, v.z)};
+    h.boundsMax = {std::max(h.boundsMax.x, v.x),
+      std::max(h.boundsMax.y, v.y),
+      std::max(h.boundsMax.z, v.z)};
+  }
+  if (ec)
+    return false;
+
+  // write a temporary file first: a reader never sees a partial cache
+  auto temp = cache;
+
+  temp += ".tmp";
+  {
+    std::ofstream file{temp, std::ios::binary};
+    size_t nv = m.vertexCount;
+
+    file.write((const char*)&h, sizeof h);
+    file.write((const char*)m.vertices, nv * sizeof(vec3f));
+    file.write((const char*)m.vertexNormals, nv * sizeof(vec3f));
+    file.write((const char*)m.triangles,
+      m.triangleCount * sizeof(TriangleMesh::Triangle));
+    if (m.uv != nullptr)
+      file.write((const char*)m.uv, nv * sizeof(vec2f));
+    if (!file)
+      return false;
+  }
+  fs::rename(temp, cache, ec);
+  return !ec;
+}
+
+} // end namespace cg::util
@@ -0,0 +1,75 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: MeshLoader.h
+// ========
+// Class definition for OBJ mesh loader.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+
+#ifndef __MeshLoader_h
+#define __MeshLoader_h
+
+#include "geometry/TriangleMesh.h"
+#include "FileBuffer.h"
+#include <future>
+
+namespace cg::util
+{ // begin namespace cg::util
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// MeshLoader: OBJ mesh loader class
+// ==========
+//
+// An OBJ file is mapped into memory, split into line aligned chunks and
+// the chunks are parsed in parallel. The mesh is then written to a
+// binary cache (.mesh, next to the OBJ file) that is mapped on later
+// loads while the OBJ file does not change.
+class MeshLoader
+{
+public:
+  using Future = std::shared_future<Reference<TriangleMesh>>;
+
+  // Starts reading the OBJ file of an asset in a background thread.
+  // The future is invalid if there is nothing to read (the mesh is
+  // already loaded or it is not an OBJ file)
+  static Future prefetch(const std::string& name);
+
+  // Returns the mesh of an asset, waiting for its prefetch, if any.
+  // OBJ files in the asset meshes folder are read by the loader; any
+  // other mesh is left to Assets
+  static TriangleMesh* load(const std::string& name,
+    const Future& prefetched = {});
+
+  // Reads an OBJ file, or its cache if it is current
+  static Reference<TriangleMesh> read(const fs::path& path,
+    bool useCache = true);
+
+  // Parses an OBJ file in memory, using at most a number of threads
+  // (all of the hardware threads if zero)
+  static Reference<TriangleMesh> parse(const char* data,
+    size_t size,
+    unsigned threadCount = 0);
+
+  static fs::path cachePath(const fs::path& path);
+
+private:
+  static Reference<TriangleMesh> readCache(const fs::path&,
+    const fs::path&);
+  static bool writeCache(const fs::path&,
+    const fs::path&,
+    const TriangleMesh&);
+
+}; // MeshLoader
+
+} // end namespace cg::util
+
+#endif // __MeshLoader_h
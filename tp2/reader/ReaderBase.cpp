@@ -32,9 +32,13 @@
 
 #include "math/Matrix3x3.h"
 #include "ReaderBase.h"
+#include "TraceRecorder.h"
 #include <cassert>
 #include <cctype>
+#include <charconv>
 #include <cstdlib>
+#include <stdexcept>
+#include <vector>
 
 namespace cg::parser
 { // begin namespace cg::parser
@@ -42,16 +46,27 @@ namespace cg::parser
 //
 // Auxiliary functions
 //
+template <typename T>
+inline T
+toNumber(StringView s)
+{
+  T value{};
+
+  if (std::from_chars(s.data(), s.data() + s.size(), value).ec != std::errc{})
+    throw std::out_of_range{"Number out of range"};
+  return value;
+}
+
 inline auto
-toInteger(const String& s)
+toInteger(StringView s)
 {
-  return std::stoi(s);
+  return toNumber<int>(s);
 }
 
 inline auto
-toFloat(const String& s)
+toFloat(StringView s)
 {
-  return std::stof(s);
+  return toNumber<float>(s);
 }
 
 
@@ -101,31 +116,148 @@ Reader::terminate()
   // do nothing
 }
 
-void
-Reader::include(const String& filename)
+Reader*
+Reader::makeReader() const
+{
+  return nullptr;
+}
+
+String
+Reader::includePath(const String& filename) const
 {
   fs::path path{filename};
 
   if (!path.is_absolute())
     path = _currentPath / path;
-  if (auto s = path.string(); _includedFiles.find(s) == _includedFiles.end())
-    if (auto input = makeBuffer(s); input != nullptr)
-      parse(*input);
+  return path.string();
 }
 
 void
-Reader::parse(FileBuffer& input)
+Reader::include(const String& filename)
+{
+  IncludeFuture prefetched;
+
+  include(filename, prefetched);
+}
+
+IncludeCache::UnitRef
+Reader::include(const String& filename, IncludeFuture& prefetched)
+{
+  auto s = includePath(filename);
+
+  if (_includedFiles.find(s) != _includedFiles.end())
+    return nullptr;
+  if (_cacheIncludes)
+    if (auto unit = IncludeCache::instance().find(s))
+    {
+      splice(*unit);
+      return unit;
+    }
+  // a prefetch fails if the include uses names defined before it: the
+  // file is then parsed here, and so are its errors reported
+  if (prefetched.valid())
+    if (auto unit = prefetched.get())
+    {
+      if (_cacheIncludes)
+        IncludeCache::instance().add(unit);
+      splice(*unit);
+      return unit;
+    }
+
+  IncludeCache::UnitRef unit;
+
+  // the includes of a prefetched file are recorded too, since its
+  // unit depends on them
+  if (auto input = makeBuffer(s); input != nullptr)
+  {
+    unit = parse(*input, _cacheIncludes || _prefetching);
+    if (_cacheIncludes)
+      IncludeCache::instance().add(unit);
+  }
+  return unit;
+}
+
+Reader::IncludeFuture
+Reader::prefetch(const String& filename) const
+//[]---------------------------------------------------[]
+//|  Parse an include in background                     |
+//|  @param filename: name of the include file          |
+//|                                                     |
+//|  The file is parsed by a new reader, into a scope   |
+//|  of its own, and its definitions are recorded in a  |
+//|  unit to be spliced when the include is reached.    |
+//|  The reader starts with the set of included files,  |
+//|  so a cycle is broken as if the file were parsed in |
+//|  order. The future holds no unit if the file could  |
+//|  not be parsed by itself                            |
+//[]---------------------------------------------------[]
+{
+  auto s = includePath(filename);
+
+  if (_includedFiles.find(s) != _includedFiles.end())
+    return {};
+  if (_cacheIncludes && IncludeCache::instance().find(s) != nullptr)
+    return {};
+
+  Reference<Reader> reader{makeReader()};
+
+  if (reader == nullptr)
+    return {};
+  reader->_currentPath = _currentPath;
+  reader->_includedFiles = _includedFiles;
+  reader->_cacheIncludes = _cacheIncludes;
+  reader->_prefetching = true;
+  return std::async(std::launch::async,
+    [reader = std::move(reader), s = std::move(s)]()
+    {
+      IncludeCache::UnitRef unit;
+
+      try
+      {
+        if (auto input = reader->makeBuffer(s); input != nullptr)
+          if (auto u = reader->parse(*input, true); u && u->isCacheable())
+            unit = std::move(u);
+      }
+      catch (const std::exception&)
+      {
+        // do nothing
+      }
+      return unit;
+    });
+}
+
+std::shared_ptr<IncludeUnit>
+Reader::parse(FileBuffer& input, bool record)
 {
+  std::shared_ptr<IncludeUnit> unit;
+
   // make a parser to the input file
   if (Reference<Parser> parser{makeParser()}; parser != nullptr)
   {
+    // included files show up nested in the timeline
+    CG_TRACE_SCOPE("scene parse", "scene");
     // add the input file to the set of included files
     _includedFiles.emplace(input.name());
     // set the parser input
     parser->setInput(input);
+    // the unit is stamped before the file is parsed
+    if (record)
+      parser->_unit = (unit = std::make_shared<IncludeUnit>(input.path())).get();
     // run the parser
     parser->execute();
   }
+  return unit;
+}
+
+void
+Reader::splice(const IncludeUnit& unit)
+{
+  if (Reference<Parser> parser{makeParser()}; parser != nullptr)
+  {
+    CG_TRACE_SCOPE("include splice", "scene");
+    _includedFiles.emplace(unit.name());
+    parser->splice(unit);
+  }
 }
 
 const char*
@@ -142,12 +274,12 @@ Reader::makeBuffer(const String& filename) const
 
   if (!fs::exists(path))
     error(COULD_NOT_FIND_FILE, filename.c_str());
-  else if (fs::is_regular_file(path))
+  else if (!fs::is_directory(path))
     try
     {
       Reference<FileBuffer> buffer = new FileBuffer{path};
 
-      if (buffer->file().is_open())
+      if (buffer->isOpen())
         return buffer;
     }
     catch (const std::exception&)
@@ -163,21 +295,6 @@ Reader::makeBuffer(const String& filename) const
 //
 // Reader::Parser implementation
 // ==============
-DEFINE_KEYWORD_TABLE(Reader::Parser, AbstractParser)
-  KEYWORD("vec2", _VEC2, 0)
-  KEYWORD("vec3", _VEC3, 0)
-  KEYWORD("vec4", _VEC4, 0)
-  KEYWORD("rgb", _RGB, 0)
-  KEYWORD("hsv", _HSV, 0)
-  KEYWORD("define", _DEFINE, 0)
-  KEYWORD("length", _LENGTH, 0)
-  KEYWORD("normalize", _NORMALIZE, 0)
-  KEYWORD("dot", _DOT, 0)
-  KEYWORD("cross", _CROSS, 0)
-  KEYWORD("axes", _AXES, 0)
-  KEYWORD("include", _INCLUDE, 0)
-  END_KEYWORD_TABLE;
-
 DEFINE_ERROR_MESSAGE_TABLE(Reader::Parser, AbstractParser)
   ERROR_MESSAGE(UNEXPECTED_CHAR,
     "Unexpected char '%c'")
@@ -264,12 +381,17 @@ _comment:
   {
     while (++buffer() == '_' || isalnum(*buffer()))
       ;
-    _lexeme = buffer().lexeme();
+    _lexeme = buffer().lexemeView();
     if (auto k = findKeyword(_lexeme); k == nullptr)
+    {
+      _tokenValue.atom = atoms().intern(_lexeme);
+      _lexeme = atoms().name(_tokenValue.atom);
       return _NAME;
+    }
     else
     {
-      _tokenValue.object = k->value;
+      _lexeme = StringView{k->name, _lexeme.size()};
+      _tokenValue.object = (void*)k->value;
       return k->token;
     }
   }
@@ -296,7 +418,7 @@ _float:
       else
         error(UNEXPECTED_CHAR, *buffer());
     }
-    _lexeme = buffer().lexeme();
+    _lexeme = buffer().lexemeView();
     if (isFloat)
     {
       _tokenValue.real = toFloat(_lexeme);
@@ -326,8 +448,10 @@ _float:
       ++buffer();
       goto _next_char;
     }
-    _lexeme = buffer().lexeme();
+    // the closing quote is read before the view is taken
     ++buffer();
+    _lexeme = buffer().lexemeView();
+    _lexeme.remove_suffix(1);
     return _STRING;
   }
 
@@ -361,26 +485,105 @@ _float:
     default:
       error(UNEXPECTED_CHAR, c);
   }
-  _lexeme = buffer().lexeme();
+  _lexeme = buffer().lexemeView();
   return c;
 }
 
 void
-Reader::Parser::define(const String& name, const Expression& e)
+Reader::Parser::define(Atom name, const Expression& e)
 {
-  if (_currentScope->contains(name))
-    error(MULTIPLE_DECLARATION_FOR, name.c_str());
-  else
-    _currentScope->insert(name, e);
+  // atom names are null terminated
+  if (!_currentScope->insert(name, e))
+    error(MULTIPLE_DECLARATION_FOR, atoms().name(name).data());
+  if (_unit != nullptr && _currentScope == &_reader->_scope)
+    _unit->addSymbol(String{atoms().name(name)}, e, _lineNumber);
+}
+
+void
+Reader::Parser::include()
+{
+  // files of a run of include directives, and their lines
+  std::vector<std::pair<String, int>> files;
+
+  do
+  {
+    // _INCLUDE
+    advance();
+
+    auto filename = matchString();
+
+    files.emplace_back(std::move(filename), _lineNumber);
+  } while (_reader->_parallelIncludes && _token == _INCLUDE);
+
+  // the first file is parsed here while the others are prefetched
+  std::vector<IncludeFuture> prefetched(files.size());
+
+  for (size_t i = 1; i < files.size(); ++i)
+    prefetched[i] = _reader->prefetch(files[i].first);
+
+  auto lineNumber = _lineNumber;
+
+  for (size_t i = 0; i < files.size(); ++i)
+  {
+    _lineNumber = files[i].second;
+    if (_unit != nullptr)
+      _unit->addInclude(files[i].first, _lineNumber);
+    // the unit depends on the files of the nested include
+    if (auto unit = _reader->include(files[i].first, prefetched[i]))
+      if (_unit != nullptr)
+        _unit->addUnit(*unit);
+  }
+  _lineNumber = lineNumber;
+}
+
+void
+Reader::Parser::splice(const IncludeUnit& unit)
+//[]---------------------------------------------------[]
+//|  Splice the definitions of a cached include         |
+//|  @param unit: unit of the include file              |
+//|                                                     |
+//|  The definitions are replayed in the order they     |
+//|  were parsed: redefinition errors are the same, at  |
+//|  the same file and line, as when the file is parsed |
+//[]---------------------------------------------------[]
+{
+  for (const auto& d : unit.definitions())
+  {
+    setLocation(unit.name(), d.line);
+    if (d.kind == IncludeUnit::Symbol)
+      define(atoms().intern(d.name), d.value);
+    else if (d.kind == IncludeUnit::Include)
+      _reader->include(d.name);
+    else
+      spliceObject(d);
+  }
+}
+
+void
+Reader::Parser::spliceObject(const IncludeUnit::Definition&)
+{
+  // do nothing
 }
 
 Expression
-Reader::Parser::access(const String& name) const
+Reader::Parser::access(Atom name) const
 {
   Expression e;
 
   if (!_currentScope->lookup(name, e))
-    error(UNDEFINED_NAME, name.c_str());
+    error(UNDEFINED_NAME, atoms().name(name).data());
+  else if (_unit != nullptr)
+  {
+    auto scope = _currentScope;
+
+    while (!scope->contains(name))
+      scope = scope->parent();
+    // a global name defined out of the unit may change from a reader
+    // to another, and so would the values of the unit
+    if (scope == &_reader->_scope)
+      if (String s{atoms().name(name)}; !_unit->defines(s))
+        _unit->setCacheable(false);
+  }
   return e;
 }
 
@@ -402,7 +605,7 @@ Reader::Parser::matchEndOfBlock()
     if (_token == _EOF)
       error(CHAR_EXPECTED, '}');
     else
-      error(UNEXPECTED_LEXEME, _lexeme.c_str());
+      error(UNEXPECTED_LEXEME, String{_lexeme}.c_str());
   advance();
 }
 
@@ -426,13 +629,13 @@ Reader::Parser::matchIndex(int min, int max)
   return i;
 }
 
-String
+Atom
 Reader::Parser::matchName()
 {
   if (_token != _NAME)
     error(NAME_EXPECTED);
 
-  auto name = _lexeme;
+  auto name = _tokenValue.atom;
 
   advance();
   return name;
@@ -445,7 +648,7 @@ Reader::Parser::matchString()
   if (_token != _STRING)
     error(STRING_EXPECTED);
 
-  auto string = _lexeme;
+  String string{_lexeme};
 
   advance();
   return string;
@@ -543,7 +746,7 @@ Reader::Parser::factor()
       e = +expression();
       break;
     case _NAME:
-      e = access(_lexeme);
+      e = access(_tokenValue.atom);
       advance();
       break;
     case _INTEGER:
@@ -34,7 +34,9 @@
 #define __ReaderBase_h
 
 #include "AbstractParser.h"
+#include "IncludeCache.h"
 #include "Scope.h"
+#include <future>
 #include <set>
 
 namespace cg::parser
@@ -54,6 +56,36 @@ public:
 
   void setInput(const String& filename);
 
+  auto cacheIncludes() const
+  {
+    return _cacheIncludes;
+  }
+
+  // Included files are parsed once per process and their definitions
+  // are spliced into later readers (see IncludeCache)
+  void setCacheIncludes(bool value)
+  {
+    _cacheIncludes = value;
+  }
+
+  auto parallelIncludes() const
+  {
+    return _parallelIncludes;
+  }
+
+  // A run of include directives is parsed in background, each file
+  // by a reader of its own, and spliced in order (see Reader::prefetch)
+  void setParallelIncludes(bool value)
+  {
+    _parallelIncludes = value;
+  }
+
+  // Whether the reader parses an include in background
+  auto isPrefetching() const
+  {
+    return _prefetching;
+  }
+
   virtual void execute();
 
 protected:
@@ -71,16 +103,30 @@ protected:
 
   virtual Parser* makeParser() = 0;
 
+  // Makes a reader to parse an include in background, if supported
+  virtual Reader* makeReader() const;
+
   virtual void init();
   virtual void terminate();
 
   void include(const String&);
 
 private:
+  using IncludeFuture = std::future<IncludeCache::UnitRef>;
+
+  // names of the input files, shared by the scopes of all of them
+  AtomTable _atoms;
   // "global" scope to be used by the parser
   Scope _scope;
+  bool _cacheIncludes{false};
+  bool _parallelIncludes{false};
+  bool _prefetching{false};
 
-  void parse(FileBuffer&);
+  String includePath(const String&) const;
+  IncludeFuture prefetch(const String&) const;
+  IncludeCache::UnitRef include(const String&, IncludeFuture&);
+  std::shared_ptr<IncludeUnit> parse(FileBuffer&, bool record = false);
+  void splice(const IncludeUnit&);
 
   FileBufferRef makeBuffer(const String&) const;
   const char* findErrorMessage(int) const override;
@@ -153,10 +199,13 @@ protected:
     int integer;
     float real;
     void* object;
+    Atom atom;
 
   };
 
-  String _lexeme;
+  // Names and keywords are views of the atom table and keyword names;
+  // other lexemes are views of the input buffer, valid until advance()
+  StringView _lexeme;
   Value _tokenValue;
 
   Parser(Reader& reader):
@@ -171,6 +220,11 @@ protected:
     return *_currentScope;
   }
 
+  auto& atoms() const
+  {
+    return _reader->_atoms;
+  }
+
   int nextToken() override;
 
   void advance()
@@ -178,13 +232,18 @@ protected:
     _token = nextToken();
   }
 
-  void include()
+  void include();
+
+  // Unit recording the definitions of the file, if it is a cacheable
+  // include
+  auto includeUnit() const
   {
-    // _INCLUDE
-    advance();
-    _reader->include(matchString());
+    return _unit;
   }
 
+  void splice(const IncludeUnit&);
+  virtual void spliceObject(const IncludeUnit::Definition&);
+
   void beginBlock()
   {
     _currentScope = new Scope{*_currentScope};
@@ -199,8 +258,8 @@ protected:
     }
   }
 
-  void define(const String&, const Expression&);
-  Expression access(const String&) const;
+  void define(Atom, const Expression&);
+  Expression access(Atom) const;
 
   void match(int);
   void matchEndOfBlock();
@@ -238,7 +297,7 @@ protected:
   }
 
   int matchIndex(int, int);
-  String matchName();
+  Atom matchName();
   String matchString();
   String matchFilename();
   String matchOptionalString();
@@ -250,12 +309,28 @@ protected:
 private:
   Reader* _reader;
   Scope* _currentScope;
+  IncludeUnit* _unit{};
 
   template <typename T> T matchValue();
 
-  DECLARE_KEYWORD_TABLE(Reader::Parser);
+  DEFINE_KEYWORD_TABLE(Reader::Parser, AbstractParser)
+    KEYWORD("vec2", _VEC2, 0)
+    KEYWORD("vec3", _VEC3, 0)
+    KEYWORD("vec4", _VEC4, 0)
+    KEYWORD("rgb", _RGB, 0)
+    KEYWORD("hsv", _HSV, 0)
+    KEYWORD("define", _DEFINE, 0)
+    KEYWORD("length", _LENGTH, 0)
+    KEYWORD("normalize", _NORMALIZE, 0)
+    KEYWORD("dot", _DOT, 0)
+    KEYWORD("cross", _CROSS, 0)
+    KEYWORD("axes", _AXES, 0)
+    KEYWORD("include", _INCLUDE, 0)
+  END_KEYWORD_TABLE;
   DECLARE_ERROR_MESSAGE_TABLE(Reader::Parser);
 
+  friend Reader;
+
 }; // Reader::Parser
 
 template <typename T>
@@ -0,0 +1,630 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: SceneCache.cpp
+// ========
+// Source file for binary scene cache.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+#include "graph/CameraProxy.h"
+#include "graph/LightProxy.h"
+#include "graph/PrimitiveProxy.h"
+#include "MappedFile.h"
+#include "MeshLoader.h"
+#include "SceneCache.h"
+#include "TraceRecorder.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace cg::util
+{ // begin namespace cg::util
+
+namespace
+{ // begin namespace
+
+constexpr char magic[4]{'S', 'C', 'N', 'C'};
+constexpr uint32_t version{1};
+constexpr uint32_t byteOrder{0x01020304};
+
+// Component tags
+enum : uint8_t
+{
+  _END,
+  _CAMERA,
+  _LIGHT,
+  _MESH,
+  _CHILD
+};
+
+inline uint64_t
+hash(const char* data, size_t size, uint64_t h = 0xcbf29ce484222325ull)
+{
+  // FNV-1a
+  for (auto end = data + size; data != end; ++data)
+    h = (h ^ (uint8_t)*data) * 0x100000001b3ull;
+  return h;
+}
+
+uint64_t
+hashFile(const fs::path& path)
+{
+  if (parser::MappedFile file; file.open(path, true))
+    return hash(file.data(), file.size());
+  return hash(nullptr, 0);
+}
+
+inline int64_t
+modificationTime(const fs::path& path, std::error_code& ec)
+{
+  return (int64_t)fs::last_write_time(path, ec).time_since_epoch().count();
+}
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Output: cache output stream
+// ======
+class Output
+{
+public:
+  Output(SceneCache::Bytes& bytes):
+    _bytes{&bytes}
+  {
+    // do nothing
+  }
+
+  template <typename T>
+  void put(const T& value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    _bytes->append((const char*)&value, sizeof(T));
+  }
+
+  void put(const char* s)
+  {
+    auto n = (uint32_t)(s ? strlen(s) : 0);
+
+    put(n);
+    _bytes->append(s, n);
+  }
+
+private:
+  SceneCache::Bytes* _bytes;
+
+}; // Output
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Input: cache input stream
+// =====
+class Input
+{
+public:
+  Input(const char* data, size_t size):
+    _current{data},
+    _end{data + size}
+  {
+    // do nothing
+  }
+
+  template <typename T>
+  T get()
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    T value;
+
+    memcpy(&value, skip(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  // The string is a view of the cache; it is not null terminated
+  parser::StringView getString()
+  {
+    auto n = get<uint32_t>();
+    return {skip(n), n};
+  }
+
+  auto left() const
+  {
+    return (size_t)(_end - _current);
+  }
+
+  const char* skip(size_t n)
+  {
+    if (n > left())
+      throw std::runtime_error("Truncated scene cache");
+
+    auto p = _current;
+
+    _current += n;
+    return p;
+  }
+
+private:
+  const char* _current;
+  const char* _end;
+
+}; // Input
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Serializer: scene snapshot writer
+// ==========
+class Serializer
+{
+public:
+  Serializer(SceneCache::Bytes& bytes):
+    _out{bytes}
+  {
+    // do nothing
+  }
+
+  bool write(const graph::Scene&, const MaterialMap&);
+
+private:
+  Output _out;
+
+  void writeMaterial(const Material&);
+  bool writeObject(const graph::SceneObject&);
+  bool writeComponent(const graph::Component&);
+
+}; // Serializer
+
+inline void
+Serializer::writeMaterial(const Material& m)
+{
+  _out.put(m.name());
+  _out.put(m.ambient);
+  _out.put(m.diffuse);
+  _out.put(m.spot);
+  _out.put(m.shine);
+  _out.put(m.specular);
+  _out.put(m.transparency);
+  _out.put(m.ior);
+}
+
+bool
+Serializer::writeComponent(const graph::Component& c)
+{
+  if (typeid(c) == typeid(graph::CameraProxy))
+  {
+    auto camera = static_cast<const graph::CameraProxy&>(c).camera();
+    float F, B;
+
+    camera->clippingPlanes(F, B);
+    _out.put(_CAMERA);
+    _out.put((int32_t)camera->projectionType());
+    _out.put(camera->viewAngle());
+    _out.put(camera->height());
+    _out.put(camera->aspectRatio());
+    _out.put(F);
+    _out.put(B);
+  }
+  else if (typeid(c) == typeid(graph::LightProxy))
+  {
+    auto light = static_cast<const graph::LightProxy&>(c).light();
+
+    _out.put(_LIGHT);
+    _out.put((int32_t)light->type());
+    _out.put(light->color);
+    _out.put(light->range());
+    _out.put(light->spotAngle());
+    _out.put((int32_t)light->falloff);
+  }
+  else if (typeid(c) == typeid(graph::TriangleMeshProxy))
+  {
+    auto& proxy = static_cast<const graph::TriangleMeshProxy&>(c);
+
+    _out.put(_MESH);
+    _out.put(proxy.meshName());
+    _out.put(proxy.mapper()->primitive()->material()->name());
+  }
+  else
+    // the cache knows nothing about components added by derived readers
+    return false;
+  return true;
+}
+
+bool
+Serializer::writeObject(const graph::SceneObject& object)
+{
+  auto t = object.transform();
+
+  _out.put(object.name());
+  _out.put(t->localPosition());
+  _out.put(t->localRotation());
+  _out.put(t->localScale());
+  for (auto component : object.components())
+    if (!asTransform(component) && !writeComponent(*component))
+      return false;
+  _out.put(_END);
+  for (auto& child : object.children())
+  {
+    _out.put(_CHILD);
+    if (!writeObject(child))
+      return false;
+  }
+  _out.put(_END);
+  return true;
+}
+
+bool
+Serializer::write(const graph::Scene& scene, const MaterialMap& materials)
+{
+  _out.put(scene.name());
+  _out.put(scene.ambientLight);
+  _out.put(scene.backgroundColor);
+  _out.put((uint32_t)materials.size());
+  for (const auto& [name, m] : materials)
+    writeMaterial(*m);
+  for (auto& object : scene.root()->children())
+  {
+    _out.put(_CHILD);
+    if (!writeObject(object))
+      return false;
+  }
+  _out.put(_END);
+  return true;
+}
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// Loader: scene snapshot reader
+// ======
+class Loader: public graph::SceneObjectBuilder
+{
+public:
+  Loader(Input& in):
+    _in{&in}
+  {
+    // do nothing
+  }
+
+  MaterialMap materials;
+
+  void load(graph::Scene&, bool setCurrentCamera);
+
+private:
+  Input* _in;
+  bool _setCurrentCamera;
+
+  auto getName()
+  {
+    return parser::String{_in->getString()};
+  }
+
+  Material* findMaterial(const parser::String& name) const
+  {
+    if (auto mit = materials.find(name); mit != materials.end())
+      return mit->second;
+    return Assets::findMaterial(name);
+  }
+
+  void loadMaterial();
+  void loadObject(graph::SceneObject&);
+  Reference<graph::Component> loadComponent(uint8_t);
+
+}; // Loader
+
+inline void
+Loader::loadMaterial()
+{
+  Reference<Material> material = new Material{Color::black};
+  auto name = getName();
+
+  material->ambient = _in->get<Color>();
+  material->diffuse = _in->get<Color>();
+  material->spot = _in->get<Color>();
+  material->shine = _in->get<float>();
+  material->specular = _in->get<Color>();
+  material->transparency = _in->get<Color>();
+  material->ior = _in->get<float>();
+  material->setName(name.c_str());
+  materials.emplace(name, material);
+}
+
+Reference<graph::Component>
+Loader::loadComponent(uint8_t tag)
+{
+  if (tag == _CAMERA)
+  {
+    Reference<graph::CameraProxy> proxy{graph::CameraProxy::New()};
+    auto camera = proxy->camera();
+
+    camera->setProjectionType((Camera::ProjectionType)_in->get<int32_t>());
+    camera->setViewAngle(_in->get<float>());
+    camera->setHeight(_in->get<float>());
+    camera->setAspectRatio(_in->get<float>());
+
+    auto F = _in->get<float>();
+
+    camera->setClippingPlanes(F, _in->get<float>());
+    if (_setCurrentCamera)
+      graph::CameraProxy::setCurrent(camera);
+    return (graph::Component*)proxy;
+  }
+  if (tag == _LIGHT)
+  {
+    Reference<graph::LightProxy> proxy{graph::LightProxy::New()};
+    auto light = proxy->light();
+
+    light->setType((Light::Type)_in->get<int32_t>());
+    light->color = _in->get<Color>();
+    light->setRange(_in->get<float>());
+    light->setSpotAngle(_in->get<float>());
+    light->falloff = (Light::Falloff)_in->get<int32_t>();
+    return (graph::Component*)proxy;
+  }
+  if (tag == _MESH)
+  {
+    auto meshName = getName();
+    auto materialName = _in->getString();
+    auto mesh = MeshLoader::load(meshName);
+
+    if (nullptr == mesh)
+      throw std::runtime_error("Could not find mesh " + meshName);
+
+    auto proxy = makePrimitive(*mesh, meshName);
+    auto primitive = proxy->mapper()->primitive();
+
+    // the material is set only if the parser has set it
+    if (materialName != primitive->material()->name())
+    {
+      auto material = findMaterial(parser::String{materialName});
+
+      if (nullptr == material)
+        throw std::runtime_error("Could not find material");
+      primitive->setMaterial(material);
+    }
+    return (graph::Component*)proxy;
+  }
+  throw std::runtime_error("Bad scene cache component");
+}
+
+void
+Loader::loadObject(graph::SceneObject& parent)
+{
+  auto name = getName();
+  auto object = createEmptyObject();
+  auto t = object->transform();
+
+  if (!name.empty())
+    object->setName(name.c_str());
+  object->setParent(&parent);
+  t->setLocalPosition(_in->get<vec3f>());
+  t->setLocalRotation(_in->get<quatf>());
+  t->setLocalScale(_in->get<vec3f>());
+  for (uint8_t tag; (tag = _in->get<uint8_t>()) != _END;)
+    object->addComponent<graph::Component>(loadComponent(tag));
+  while (_in->get<uint8_t>() == _CHILD)
+    loadObject(*object);
+}
+
+void
+Loader::load(graph::Scene& scene, bool setCurrentCamera)
+{
+  // the scene name comes first: the scene is made by the reader
+  _setCurrentCamera = setCurrentCamera;
+  scene.ambientLight = _in->get<Color>();
+  scene.backgroundColor = _in->get<Color>();
+  for (auto n = _in->get<uint32_t>(); n--;)
+    loadMaterial();
+  setScene(scene);
+  while (_in->get<uint8_t>() == _CHILD)
+    loadObject(*scene.root());
+}
+
+// Returns the payload of a cache if it is valid for the input
+parser::StringView
+checkHeader(Input& in, const fs::path& input)
+{
+  if (memcmp(in.skip(sizeof magic), magic, sizeof magic) != 0 ||
+    in.get<uint32_t>() != version ||
+    in.get<uint32_t>() != byteOrder ||
+    in.getString() != input.string())
+    return {};
+
+  std::error_code ec;
+
+  for (auto n = in.get<uint32_t>(); n--;)
+  {
+    fs::path path{in.getString()};
+    auto size = in.get<uint64_t>();
+    auto time = in.get<int64_t>();
+    auto fileHash = in.get<uint64_t>();
+
+    if (fs::file_size(path, ec) != size || ec)
+      return {};
+    // a file touched but not changed is still valid
+    if (modificationTime(path, ec) != time || ec)
+      if (hashFile(path) != fileHash)
+        return {};
+  }
+
+  auto size = in.get<uint64_t>();
+
+  if (size + sizeof(uint64_t) != in.left())
+    return {};
+
+  auto payload = in.skip(size);
+
+  if (hash(payload, size) != in.get<uint64_t>())
+    return {};
+  return {payload, size};
+}
+
+} // end namespace
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// SceneCache implementation
+// ==========
+fs::path
+SceneCache::cachePath(const fs::path& input)
+{
+  auto path = input;
+  return path.replace_extension(".scnc");
+}
+
+bool
+SceneCache::serialize(const SceneReader& reader, Bytes& bytes)
+//[]---------------------------------------------------[]
+//|  Serialize the scene of a reader                    |
+//|  @param reader: reader that has parsed the scene    |
+//|  @param bytes: header and payload of the cache      |
+//|  @return false if the scene cannot be cached        |
+//[]---------------------------------------------------[]
+{
+  CG_TRACE_SCOPE("scene cache write", "scene");
+
+  Bytes payload;
+
+  if (!Serializer{payload}.write(*reader._scene, reader.materials))
+    return false;
+
+  Output out{bytes};
+  std::error_code ec;
+
+  bytes.clear();
+  bytes.append(magic, sizeof magic);
+  out.put(version);
+  out.put(byteOrder);
+  out.put(reader._input->path().string().c_str());
+  out.put((uint32_t)reader._includedFiles.size());
+  for (const auto& name : reader._includedFiles)
+  {
+    fs::path path{name};
+
+    auto size = (uint64_t)fs::file_size(path, ec);
+
+    if (ec)
+      return false;
+
+    auto time = modificationTime(path, ec);
+
+    if (ec)
+      return false;
+    out.put(name.c_str());
+    out.put(size);
+    out.put(time);
+    out.put(hashFile(path));
+  }
+  // the payload hash follows the payload
+  out.put((uint64_t)payload.size());
+  bytes += payload;
+  out.put(hash(payload.data(), payload.size()));
+  return true;
+}
+
+bool
+SceneCache::write(const fs::path& path, const Bytes& bytes)
+{
+  // write a temporary file first: a reader never sees a partial cache
+  auto temp = path;
+
+  temp += ".tmp";
+  if (std::ofstream file{temp, std::ios::binary}; !file.write(bytes.data(),
+    bytes.size()))
+    return false;
+
+  std::error_code ec;
+
+  fs::rename(temp, path, ec);
+  return !ec;
+}
+
+Reference<graph::Scene>
+SceneCache::load(const SceneReader& reader,
+  parser::StringView payload,
+  MaterialMap& materials,
+  bool setCurrentCamera)
+{
+  Input in{payload.data(), payload.size()};
+  Loader loader{in};
+  parser::String name{in.getString()};
+  Reference<graph::Scene> scene{reader.makeScene(name.c_str())};
+
+  loader.load(*scene, setCurrentCamera);
+  materials = std::move(loader.materials);
+  return scene;
+}
+
+bool
+SceneCache::read(const fs::path& path, SceneReader& reader) try
+{
+  CG_TRACE_SCOPE("scene cache read", "scene");
+
+  parser::MappedFile file;
+
+  if (!file.open(path, true))
+    return false;
+
+  Input in{file.data(), file.size()};
+  auto payload = checkHeader(in, reader._input->path());
+
+  if (payload.data() == nullptr)
+    return false;
+
+  MaterialMap materials;
+  auto scene = load(reader, payload, materials, true);
+
+  reader.materials = std::move(materials);
+  reader._scene = scene;
+  return true;
+}
+catch (const std::exception&)
+{
+  return false;
+}
+
+bool
+SceneCache::verify(const SceneReader& reader, const Bytes& bytes) try
+{
+  using clock = std::chrono::steady_clock;
+
+  Input in{bytes.data(), bytes.size()};
+  auto payload = checkHeader(in, reader._input->path());
+
+  if (payload.data() == nullptr)
+  {
+    puts("Scene cache verify: invalid header");
+    return false;
+  }
+
+  // the current camera is kept: the loaded scene is thrown away
+  auto t = clock::now();
+  MaterialMap materials;
+  auto scene = load(reader, payload, materials, false);
+  std::chrono::duration<double, std::milli> ms{clock::now() - t};
+  Bytes snapshot;
+  auto ok = Serializer{snapshot}.write(*scene, materials) &&
+    parser::StringView{snapshot} == payload;
+
+  printf("Scene cache verify: %s (load %.2f ms, %zu bytes)\n",
+    ok ? "ok" : "MISMATCH",
+    ms.count(),
+    bytes.size());
+  return ok;
+}
+catch (const std::exception& e)
+{
+  printf("Scene cache verify: %s\n", e.what());
+  return false;
+}
+
+} // end namespace cg::util
@@ -0,0 +1,67 @@
+//[]---------------------------------------------------------------[]
+//|                                                                 |
+//| Copyright (C) 2025 - Trabalho Prático 2                         |
+//| Computação Gráfica - UFMS                                       |
+//|                                                                 |
+//[]---------------------------------------------------------------[]
+//
+// OVERVIEW: SceneCache.h
+// ========
+// Class definition for binary scene cache.
+//
+// Author: Trabalho Prático 2
+// Last revision: 18/10/2025
+
+
+#ifndef __SceneCache_h
+#define __SceneCache_h
+
+#include "SceneReader.h"
+
+namespace cg::util
+{ // begin namespace cg::util
+
+
+/////////////////////////////////////////////////////////////////////
+//
+// SceneCache: binary scene cache class
+// ==========
+//
+// A cache file (.scnc, next to the scene file) holds a snapshot of the
+// scene and the materials read by a scene reader: object hierarchy,
+// transforms, cameras, lights and mesh references. Mesh geometry is not
+// stored; meshes are loaded from the assets by name, as the parser does.
+// The cache also holds the size, modification time and hash of every
+// file read by the parser, and it is discarded as soon as any of them
+// has changed.
+class SceneCache
+{
+public:
+  using Bytes = std::string;
+
+  static fs::path cachePath(const fs::path& input);
+
+  // Serializes the scene of a reader. Returns false if the scene has
+  // components the cache cannot store
+  static bool serialize(const SceneReader& reader, Bytes& bytes);
+  static bool write(const fs::path& path, const Bytes& bytes);
+
+  // Loads the scene of a reader from a cache file. Returns false if the
+  // cache is missing, stale or corrupt; the reader is left untouched
+  static bool read(const fs::path& path, SceneReader& reader);
+
+  // Loads the scene from the bytes serialized from a reader and checks
+  // it against the scene of the reader
+  static bool verify(const SceneReader& reader, const Bytes& bytes);
+
+private:
+  static Reference<graph::Scene> load(const SceneReader&,
+    parser::StringView,
+    MaterialMap&,
+    bool);
+
+}; // SceneCache
+
+} // end namespace cg::util
+
+#endif // __SceneCache_h
@@ -30,11 +30,35 @@
 // Author: Paulo Pagliosa
 // Last revision: 01/11/2025
 
-#include "SceneReader.h"
+#include "MeshLoader.h"
+#include "SceneCache.h"
+#include "TraceRecorder.h"
+#include <stdexcept>
 
 namespace cg::util
 { // begin namespace cg::util
 
+namespace
+{ // begin namespace
+
+Material*
+copyMaterial(const Material& m)
+{
+  auto material = new Material{Color::black};
+
+  material->ambient = m.ambient;
+  material->diffuse = m.diffuse;
+  material->spot = m.spot;
+  material->shine = m.shine;
+  material->specular = m.specular;
+  material->transparency = m.transparency;
+  material->ior = m.ior;
+  material->setName(m.name());
+  return material;
+}
+
+} // end namespace
+
 
 /////////////////////////////////////////////////////////////////////
 //
@@ -43,10 +67,30 @@ namespace cg::util
 void
 SceneReader::execute()
 {
+  CG_TRACE_SCOPE("scene read", "scene");
   Assets::initialize();
+  if (_cacheMode == CacheMode::On && _input != nullptr)
+    if (SceneCache::read(SceneCache::cachePath(_input->path()), *this))
+      return;
   Reader::execute();
 }
 
+void
+SceneReader::terminate()
+{
+  if (_cacheMode == CacheMode::Off || _scene == nullptr)
+    return;
+
+  // a scene with components unknown to the cache is always parsed
+  SceneCache::Bytes bytes;
+
+  if (!SceneCache::serialize(*this, bytes))
+    return;
+  SceneCache::write(SceneCache::cachePath(_input->path()), bytes);
+  if (_cacheMode == CacheMode::Verify)
+    SceneCache::verify(*this, bytes);
+}
+
 graph::Scene*
 SceneReader::makeScene(const char* name) const
 {
@@ -59,44 +103,17 @@ SceneReader::makeParser()
   return new Parser{*this};
 }
 
+parser::Reader*
+SceneReader::makeReader() const
+{
+  return new SceneReader;
+}
+
 
 /////////////////////////////////////////////////////////////////////
 //
 // SceneReader::Parser implementation
 // ===================
-DEFINE_KEYWORD_TABLE(SceneReader::Parser, parser::Reader::Parser)
-  KEYWORD("ambient", _AMBIENT, 0)
-  KEYWORD("angle", _ANGLE, 0)
-  KEYWORD("aspect", _ASPECT, 0)
-  KEYWORD("background", _BACKGROUND, 0)
-  KEYWORD("camera", _COMPONENT, _CAMERA)
-  KEYWORD("color", _COLOR, 0)
-  KEYWORD("depth", _DEPTH, 0)
-  KEYWORD("diffuse", _DIFFUSE, 0)
-  KEYWORD("directional", _DIRECTIONAL, 0)
-  KEYWORD("environment", _ENVIRONMENT, 0)
-  KEYWORD("falloff", _FALLOFF, 0)
-  KEYWORD("height", _HEIGHT, 0)
-  KEYWORD("ior", _IOR, 0)
-  KEYWORD("light", _COMPONENT, _LIGHT)
-  KEYWORD("material", _MATERIAL, 0)
-  KEYWORD("mesh", _COMPONENT, _MESH)
-  KEYWORD("object", _OBJECT, 0)
-  KEYWORD("parallel", _PARALLEL, 0)
-  KEYWORD("perspective", _PERSPECTIVE, 0)
-  KEYWORD("point", _POINT, 0)
-  KEYWORD("position", _POSITION, 0)
-  KEYWORD("range", _RANGE, 0)
-  KEYWORD("rotation", _ROTATION, 0)
-  KEYWORD("scale", _SCALE, 0)
-  KEYWORD("scene", _SCENE, 0)
-  KEYWORD("shine", _SHINE, 0)
-  KEYWORD("specular", _SPECULAR, 0)
-  KEYWORD("spot", _SPOT, 0)
-  KEYWORD("transform", _TRANSFORM, 0)
-  KEYWORD("transparency", _TRANSPARENCY, 0)
-  END_KEYWORD_TABLE;
-
 DEFINE_ERROR_MESSAGE_TABLE(SceneReader::Parser, parser::Reader::Parser)
   ERROR_MESSAGE(MATERIAL_ALREADY_DEFINED,
     "Material '%s' already defined")
@@ -220,6 +237,7 @@ SceneReader::Parser::parseMaterial()
   advance();
 
   auto name = matchString();
+  auto line = _lineNumber;
 
   if (_reader->materials.contains(name))
     error(MATERIAL_ALREADY_DEFINED, name.c_str());
@@ -231,6 +249,22 @@ SceneReader::Parser::parseMaterial()
   matchEndOfBlock();
   material->setName(name.c_str());
   _reader->materials.emplace(name, material);
+  // the unit keeps a copy: the material itself goes to the scene
+  if (auto unit = includeUnit())
+    unit->addObject(_MATERIAL_DEFINITION, name, copyMaterial(*material), line);
+}
+
+void
+SceneReader::Parser::spliceObject(const parser::IncludeUnit::Definition& d)
+{
+  if (d.kind != _MATERIAL_DEFINITION)
+    return;
+  if (_reader->materials.contains(d.name))
+    error(MATERIAL_ALREADY_DEFINED, d.name.c_str());
+
+  auto prototype = (Material*)(SharedObject*)d.object;
+
+  _reader->materials.emplace(d.name, copyMaterial(*prototype));
 }
 
 inline void
@@ -267,9 +301,18 @@ SceneReader::Parser::parseScene()
   // _SCENE
   advance();
 
+  // the objects of a scene are not built in background: an include
+  // with a scene is given up by the prefetch and parsed by the reader
+  if (_reader->isPrefetching())
+    throw std::logic_error{"Scene in a prefetched include"};
+
   auto sceneName = matchOptionalString();
   auto scene = _reader->makeScene(sceneName.c_str());
 
+  // an include with a scene is always parsed
+  if (auto unit = includeUnit())
+    unit->setCacheable(false);
+
   setScene(*scene);
   match('{');
   beginBlock();
@@ -279,6 +322,7 @@ SceneReader::Parser::parseScene()
     parseSceneEnvironment();
   parseWorld();
   parseObjectBlock(*scene->root());
+  attachMeshes();
   _reader->_scene = scene;
 }
 
@@ -473,49 +517,72 @@ SceneReader::Parser::matchLight()
   }
 }
 
-inline Reference<graph::PrimitiveProxy>
-SceneReader::Parser::matchPrimitive(int type)
+inline void
+SceneReader::Parser::matchMesh(graph::SceneObject& object)
 {
-  if (type != _MESH)
-    return {};
-
+  auto lineNumber = _lineNumber;
   auto name = matchString();
 
   if (name.empty())
     error(EMPTY_MESH_NAME);
 
-  Reference<graph::PrimitiveProxy> proxy;
-
-  if (auto mesh = Assets::loadMesh(name); nullptr == mesh)
-    error(COULD_NOT_FIND_MESH, name.c_str());
-  else
-  {
-    proxy = makePrimitive(*mesh, name);
-    parsePrimitiveMaterial(*proxy->mapper()->primitive());
-  }
-  return proxy;
+  // the mesh is read while parsing goes on (see attachMeshes)
+  if (auto& read = _meshReads[name]; !read.valid())
+    read = MeshLoader::prefetch(name);
+  _meshComponents.push_back({&object,
+    std::move(name),
+    parsePrimitiveMaterial(),
+    lineNumber});
 }
 
 void
-SceneReader::Parser::parsePrimitiveMaterial(Primitive& primitive)
+SceneReader::Parser::attachMeshes()
 {
-  if (_token == _MATERIAL)
+  auto lineNumber = _lineNumber;
+
+  for (auto& c : _meshComponents)
   {
-    advance();
+    _lineNumber = c.lineNumber;
 
-    auto name = matchString();
+    auto mesh = MeshLoader::load(c.name, _meshReads[c.name]);
 
-    if (auto material = _reader->findMaterial(name); material == nullptr)
-      error(COULD_NOT_FIND_MATERIAL, name.c_str());
-    else
-      primitive.setMaterial(material);
+    if (nullptr == mesh)
+    {
+      error(COULD_NOT_FIND_MESH, c.name.c_str());
+      continue;
+    }
+
+    auto proxy = makePrimitive(*mesh, c.name);
+
+    if (c.material != nullptr)
+      proxy->mapper()->primitive()->setMaterial(c.material);
+    if (c.object->addComponent<graph::Component>(proxy) == nullptr)
+      error(COMPONENT_ALREADY_DEFINED, proxy->typeName());
   }
+  _meshComponents.clear();
+  _meshReads.clear();
+  _lineNumber = lineNumber;
+}
+
+Material*
+SceneReader::Parser::parsePrimitiveMaterial()
+{
+  if (_token != _MATERIAL)
+    return nullptr;
+  advance();
+
+  auto name = matchString();
+  auto material = _reader->findMaterial(name);
+
+  if (material == nullptr)
+    error(COULD_NOT_FIND_MATERIAL, name.c_str());
+  return material;
 }
 
 Reference<graph::Component>
-SceneReader::Parser::parseComponent(int type, graph::SceneObject&)
+SceneReader::Parser::parseComponent(int, graph::SceneObject&)
 {
-  return (graph::Component*)matchPrimitive(type);
+  return {};
 }
 
 void
@@ -528,9 +595,16 @@ SceneReader::Parser::parseComponent(graph::SceneObject& object)
     component = matchCamera();
   else if (type == _LIGHT)
     component = matchLight();
+  else if (type == _MESH)
+  {
+    // _COMPONENT (_MESH)
+    advance();
+    matchMesh(object);
+    return;
+  }
   else
   {
-    auto string = _lexeme;
+    String string{_lexeme};
 
     // _COMPONENT (...)
     advance();
@@ -35,11 +35,16 @@
 
 #include "graph/SceneObjectBuilder.h"
 #include "graphics/Assets.h"
+#include "MeshLoader.h"
 #include "ReaderBase.h"
+#include <unordered_map>
+#include <vector>
 
 namespace cg::util
 { // begin namespace cg::util
 
+class SceneCache;
+
 
 /////////////////////////////////////////////////////////////////////
 //
@@ -50,6 +55,15 @@ class SceneReader: public parser::Reader
 public:
   class Parser;
 
+  // Binary scene cache: off, read and written, or written and checked
+  // against the scene parsed from the text
+  enum class CacheMode
+  {
+    Off,
+    On,
+    Verify
+  };
+
   MaterialMap materials;
 
   graph::Scene* scene() const
@@ -64,17 +78,32 @@ public:
     return Assets::findMaterial(name);
   }
 
+  auto cacheMode() const
+  {
+    return _cacheMode;
+  }
+
+  void setCacheMode(CacheMode mode)
+  {
+    _cacheMode = mode;
+  }
+
   void execute() override;
 
 protected:
   virtual graph::Scene* makeScene(const char* name) const;
 
+  void terminate() override;
+
 private:
   Reference<graph::Scene> _scene;
+  CacheMode _cacheMode{CacheMode::Off};
 
   parser::Reader::Parser* makeParser() override;
+  parser::Reader* makeReader() const override;
 
   friend Parser;
+  friend SceneCache;
 
 }; // SceneReader
 
@@ -103,6 +132,13 @@ protected:
   using Base = parser::Reader::Parser;
   using ComponentRef = Reference<graph::Component>;
 
+  // Include unit definition kinds
+  enum
+  {
+    _MATERIAL_DEFINITION = parser::IncludeUnit::lastKind,
+    lastDefinitionKind
+  };
+
   // Component type
   enum
   {
@@ -161,11 +197,25 @@ protected:
   };
 
   virtual void parseWorld();
-  void parsePrimitiveMaterial(Primitive&);
+  Material* parsePrimitiveMaterial();
   virtual ComponentRef parseComponent(int, graph::SceneObject&);
 
+  void spliceObject(const parser::IncludeUnit::Definition&) override;
+
 private:
+  // Mesh component whose mesh is read in background while the scene
+  // is parsed; it is attached to its object at the end of the scene
+  struct MeshComponent
+  {
+    graph::SceneObject* object;
+    parser::String name;
+    Reference<Material> material;
+    int lineNumber;
+  };
+
   SceneReader* _reader;
+  std::unordered_map<parser::String, MeshLoader::Future> _meshReads;
+  std::vector<MeshComponent> _meshComponents;
 
   void start() override;
 
@@ -189,9 +239,41 @@ private:
 
   Reference<graph::CameraProxy> matchCamera();
   Reference<graph::LightProxy> matchLight();
-  Reference<graph::PrimitiveProxy> matchPrimitive(int);
-
-  DECLARE_KEYWORD_TABLE(SceneReader::Parser);
+  void matchMesh(graph::SceneObject&);
+  void attachMeshes();
+
+  DEFINE_KEYWORD_TABLE(SceneReader::Parser, parser::Reader::Parser)
+    KEYWORD("ambient", _AMBIENT, 0)
+    KEYWORD("angle", _ANGLE, 0)
+    KEYWORD("aspect", _ASPECT, 0)
+    KEYWORD("background", _BACKGROUND, 0)
+    KEYWORD("camera", _COMPONENT, _CAMERA)
+    KEYWORD("color", _COLOR, 0)
+    KEYWORD("depth", _DEPTH, 0)
+    KEYWORD("diffuse", _DIFFUSE, 0)
+    KEYWORD("directional", _DIRECTIONAL, 0)
+    KEYWORD("environment", _ENVIRONMENT, 0)
+    KEYWORD("falloff", _FALLOFF, 0)
+    KEYWORD("height", _HEIGHT, 0)
+    KEYWORD("ior", _IOR, 0)
+    KEYWORD("light", _COMPONENT, _LIGHT)
+    KEYWORD("material", _MATERIAL, 0)
+    KEYWORD("mesh", _COMPONENT, _MESH)
+    KEYWORD("object", _OBJECT, 0)
+    KEYWORD("parallel", _PARALLEL, 0)
+    KEYWORD("perspective", _PERSPECTIVE, 0)
+    KEYWORD("point", _POINT, 0)
+    KEYWORD("position", _POSITION, 0)
+    KEYWORD("range", _RANGE, 0)
+    KEYWORD("rotation", _ROTATION, 0)
+    KEYWORD("scale", _SCALE, 0)
+    KEYWORD("scene", _SCENE, 0)
+    KEYWORD("shine", _SHINE, 0)
+    KEYWORD("specular", _SPECULAR, 0)
+    KEYWORD("spot", _SPOT, 0)
+    KEYWORD("transform", _TRANSFORM, 0)
+    KEYWORD("transparency", _TRANSPARENCY, 0)
+  END_KEYWORD_TABLE;
   DECLARE_ERROR_MESSAGE_TABLE(SceneReader::Parser);
 
 }; // SceneReader::Parser
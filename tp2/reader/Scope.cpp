@@ -31,22 +31,94 @@
 // Last revision: 10/02/2022
 
 #include "Scope.h"
+#include <algorithm>
 
 namespace cg::parser
 { // begin namespace cg::parser
 
+namespace
+{ // begin namespace
+
+constexpr size_t maxLinearSize{8};
+
+inline size_t
+slotOf(Atom name, size_t mask)
+{
+  // Atoms are consecutive: spread them over the table (Fibonacci hash)
+  return (name * 2654435769u >> 7) & mask;
+}
+
+} // end namespace
+
 
 /////////////////////////////////////////////////////////////////////
 //
 // Scope implementation
 // =====
 bool
-Scope::lookup(const std::string& name, Expression& e) const
+Scope::lookup(Atom name, Expression& e) const
 {
   for (auto scope = this; scope != nullptr; scope = scope->_parent)
-    if (auto it = scope->_symbols.find(name); it != scope->_symbols.end())
-      return void(e = it->second), true;
+    if (auto value = scope->find(name))
+      return void(e = *value), true;
   return false;
 }
 
+const Expression*
+Scope::find(Atom name) const
+{
+  if (_slots.empty())
+  {
+    for (const auto& symbol : _symbols)
+      if (symbol.name == name)
+        return &symbol.value;
+    return nullptr;
+  }
+
+  auto mask = _slots.size() - 1;
+
+  for (auto i = slotOf(name, mask);; i = (i + 1) & mask)
+    if (auto slot = _slots[i]; slot == 0)
+      return nullptr;
+    else if (_symbols[slot - 1].name == name)
+      return &_symbols[slot - 1].value;
+}
+
+bool
+Scope::insert(Atom name, const Expression& e)
+{
+  if (contains(name))
+    return false;
+  _symbols.push_back({name, e});
+  if (_symbols.size() > maxLinearSize && 2 * _symbols.size() > _slots.size())
+    rehash();
+  else if (!_slots.empty())
+  {
+    auto mask = _slots.size() - 1;
+    auto i = slotOf(name, mask);
+
+    while (_slots[i] != 0)
+      i = (i + 1) & mask;
+    _slots[i] = (uint32_t)_symbols.size();
+  }
+  return true;
+}
+
+void
+Scope::rehash()
+{
+  _slots.assign(std::max<size_t>(4 * maxLinearSize, 2 * _slots.size()), 0);
+
+  auto mask = _slots.size() - 1;
+
+  for (size_t k = 0; k < _symbols.size(); ++k)
+  {
+    auto i = slotOf(_symbols[k].name, mask);
+
+    while (_slots[i] != 0)
+      i = (i + 1) & mask;
+    _slots[i] = uint32_t(k + 1);
+  }
+}
+
 } // end namespace cg::parser
@@ -33,8 +33,9 @@
 #ifndef __Scope_h
 #define __Scope_h
 
+#include "Atom.h"
 #include "Expression.h"
-#include <map>
+#include <vector>
 
 namespace cg::parser
 { // begin namespace cg::parser
@@ -44,6 +45,9 @@ namespace cg::parser
 //
 // Scope: simple scope class
 // =====
+//
+// Symbols are keyed by atom. A small scope is searched linearly; a
+// larger one gets an open addressing table of symbol indices.
 class Scope
 {
 public:
@@ -60,29 +64,38 @@ public:
     return _parent;
   }
 
-  bool lookup(const std::string&, Expression&) const;
+  bool lookup(Atom, Expression&) const;
 
-  auto contains(const std::string& name) const
+  auto contains(Atom name) const
   {
-    return _symbols.find(name) != _symbols.end();
+    return find(name) != nullptr;
   }
 
-  void insert(const std::string& name, const Expression& e)
-  {
-    _symbols.emplace(name, e);
-  }
+  // Returns false if the name is already in the scope.
+  bool insert(Atom name, const Expression& e);
 
   void clear()
   {
     _symbols.clear();
+    _slots.clear();
   }
 
 private:
-  using SymbolTable = std::map<std::string, Expression>;
+  struct Symbol
+  {
+    Atom name;
+    Expression value;
+
+  };
 
-  SymbolTable _symbols;
+  std::vector<Symbol> _symbols;
+  // Symbol indices + 1 (0 is an empty slot)
+  std::vector<uint32_t> _slots;
   Scope* _parent{};
 
+  const Expression* find(Atom) const;
+  void rehash();
+
 }; // Scope
 
 } // end namespace cg::parser
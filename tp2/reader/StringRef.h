@@ -34,11 +34,13 @@
 #define __StringRef_h
 
 #include <string>
+#include <string_view>
 
 namespace cg::parser
 { // begin namespace cg::parser
 
 using String = std::string;
+using StringView = std::string_view;
 
 
 ///////////////////////////////////////////////////////////////////